@@ -32,9 +32,11 @@
 #include "cssc.h"
 #include "sccsfile.h"
 #include "fileiter.h"
+#include "parallel.h"
 #include "sid_list.h"
 #include "sl-merge.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "version.h"
 #include "delta.h"
 #include "except.h"
@@ -57,7 +59,7 @@ well_formed_sccsname(const sccs_name& n)
 }
 
 void
-usage() {
+admin_usage() {
 	fprintf(stderr,
 "usage: %s [-nrzV] [-a users] [-d flags] [-e users] [-f flags]\n"
 "\t[-i file] [-m MRs] [-t file] [-y comments] file ...\n",
@@ -65,7 +67,7 @@ usage() {
 }
 
 int
-main(int argc, char **argv)
+admin_main(int argc, char **argv)
 {
   int c;
   Cleaner arbitrary_name;
@@ -85,6 +87,7 @@ main(int argc, char **argv)
   int suppress_mrs = 0;				/* -m " " (i.e. no actual MRs) */
   int suppress_comments = 0;			/* -y (no arg) */
   int empty_t_option = 0;	                /* -t (no arg) */
+  int max_jobs = 1;				/* -j */
   int retval;
 
 
@@ -112,7 +115,7 @@ main(int argc, char **argv)
 
   retval = 0;
 
-  class CSSC_Options opts(argc, argv, "bni!r!t!f!d!a!e!m!y!hzV");
+  class CSSC_Options opts(argc, argv, "bni!r!t!f!d!a!e!m!y!hzVj!");
   for (c = opts.next();
        c != CSSC_Options::END_OF_ARGUMENTS;
        c = opts.next()) {
@@ -214,6 +217,14 @@ main(int argc, char **argv)
       reset_checksum = 1;
       break;
 
+    case 'j':
+      max_jobs = atoi(opts.getarg());
+      if (max_jobs < 1) {
+	errormsg("Invalid number of jobs: '%s'", opts.getarg());
+	return 2;
+      }
+      break;
+
     case 'V':
       version();
       if (2 == argc)
@@ -249,7 +260,8 @@ main(int argc, char **argv)
     }
 
 
-  while (iter.next())
+  parallel_jobs jobs(max_jobs);
+  while (jobs.next(iter, retval))
     {
       try
 	{
@@ -396,6 +408,21 @@ main(int argc, char **argv)
   return retval;
 }
 
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  admin_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return admin_main(argc, argv);
+}
+#endif
+
 /* Local variables: */
 /* mode: c++ */
 /* End: */
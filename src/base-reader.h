@@ -113,8 +113,7 @@ class sccs_file_reader_base
       }
     here_.advance_line();
     // chomp the newline from the end of the line.
-    // TODO: make me 8-bit clean!
-    (*plinebuf)[strlen(plinebuf->c_str()) - 1] = '\0';
+    plinebuf->truncate(plinebuf->length() - 1u);
     return 0;
   }
 
@@ -35,13 +35,14 @@
 #include "failure.h"
 #include "failure_macros.h"
 #include "failure_or.h"
-#include "filediff.h"
 #include "filepos.h"
 #include "ioerr.h"
+#include "line-diff.h"
 #include "linebuf.h"
 #include "seqstate.h"
 #include "subst-parms.h"
 #include "quit.h"
+#include "trace.h"
 
 
 using cssc::Failure;
@@ -81,7 +82,7 @@ cssc::Failure sccs_file_body_scanner::seek_to_body()
 cssc::Failure
 sccs_file_body_scanner::get(const std::string& gname,
 			    const cssc_delta_table& delta_table,
-			    std::function<cssc::Failure(const char *start,
+			    std::function<cssc::Failure(const char *start, size_t len,
 							struct delta const& gotten_delta,
 							bool force_expansion)> write_subst,
 			    cssc::Failure (*outputfn)(FILE*,const cssc_linebuf*),
@@ -125,6 +126,9 @@ sccs_file_body_scanner::get(const std::string& gname,
   state.start(first_delta, 'I'); /* 'I' means "insert". */
 
   FILE *out = parms.out;
+  trace_phase phase("body", name());
+  unsigned long body_lines = 0, control_lines = 1, output_lines = 0;
+  unsigned long subst_lines = 0;
 
   while (1) {
     fol = read_line();
@@ -138,12 +142,14 @@ sccs_file_body_scanner::get(const std::string& gname,
     if (line_type == 0) {
       /* A non-control line */
 
+      ++body_lines;
       if (!state.include_line())
 	{
 	  continue;
 	}
 
       parms.out_lineno++;
+      ++output_lines;
 
       if (show_module)
         fprintf(out, "%s\t", parms.get_module_name().c_str());
@@ -157,7 +163,9 @@ sccs_file_body_scanner::get(const std::string& gname,
         }
       if (do_kw_subst && !encoded)
 	{
-	  cssc::Failure wrote = write_subst(plinebuf->c_str(), parms.delta, false);
+	  ++subst_lines;
+	  cssc::Failure wrote = write_subst(plinebuf->c_str(), plinebuf->length(),
+					    parms.delta, false);
 	  if (!wrote.ok())
 	    {
 	      wrote = cssc::make_failure_builder(wrote)
@@ -190,6 +198,7 @@ sccs_file_body_scanner::get(const std::string& gname,
 
     /* A control line */
 
+    ++control_lines;
     check_arg();
     seq_no seq = strict_atous(here(), plinebuf->c_str() + 3);
     if (seq < 1 || seq > highest_delta_seqno) {
@@ -234,6 +243,11 @@ sccs_file_body_scanner::get(const std::string& gname,
     }
   }
 
+  phase.count("body_lines", body_lines);
+  phase.count("control_lines", control_lines);
+  phase.count("output_lines", output_lines);
+  phase.count("subst_lines", subst_lines);
+
   if (fflush_failed(fflush(out)))
     {
       return cssc::make_failure_builder_from_errno(errno)
@@ -269,24 +283,187 @@ namespace
 
 }  // namespace
 
+cssc::Failure
+sccs_file_body_scanner::get_lines(seq_no highest_delta_seqno,
+				  seq_state& state, line_list* lines)
+{
+  seq_state* const states[] = { &state };
+  line_list* const outputs[] = { lines };
+  return collect_lines(highest_delta_seqno, 1, states, outputs);
+}
+
+cssc::Failure
+sccs_file_body_scanner::get_lines(seq_no highest_delta_seqno,
+				  seq_state& state1, line_list* lines1,
+				  seq_state& state2, line_list* lines2)
+{
+  seq_state* const states[] = { &state1, &state2 };
+  line_list* const outputs[] = { lines1, lines2 };
+  return collect_lines(highest_delta_seqno, 2, states, outputs);
+}
+
+// Read the body once, adding each line to lines[i] if it is selected
+// by states[i].
+cssc::Failure
+sccs_file_body_scanner::collect_lines(seq_no highest_delta_seqno, size_t n,
+				      seq_state* const states[],
+				      line_list* const lines[])
+{
+  cssc::Failure seek = seek_to_body();
+  if (!seek.ok())
+    return seek;
+
+  trace_phase phase("body", name());
+  unsigned long body_lines = 0, control_lines = 0;
+  for (;;)
+    {
+      FailureOr<char> fol = read_line();
+      if (!fol.ok())
+	{
+	  if (isEOF(fol.fail()))
+	    break;
+	  return fol.fail();
+	}
+      const char line_type = *fol;
+      if (0 == line_type)
+	{
+	  ++body_lines;
+	  const char *s = plinebuf->c_str();
+	  const size_t len = plinebuf->length();
+	  for (size_t i = 0; i < n; ++i)
+	    {
+	      if (states[i]->include_line())
+		lines[i]->append(s, len);
+	    }
+	  continue;
+	}
+
+      ++control_lines;
+      check_arg();
+      seq_no seq = strict_atous(here(), plinebuf->c_str() + 3);
+      if (seq < 1 || seq > highest_delta_seqno)
+	{
+	  corrupt(here(), "Invalid serial number %u converted from '%s'",
+		  unsigned(seq), plinebuf->c_str());
+	  /*NOTREACHED*/
+	}
+
+      for (size_t i = 0; i < n; ++i)
+	{
+	  std::pair<bool, std::string> outcome;
+	  switch (line_type)
+	    {
+	    case 'E':
+	      outcome = states[i]->end(seq);
+	      break;
+
+	    case 'D':
+	    case 'I':
+	      outcome = states[i]->start(seq, line_type);
+	      break;
+
+	    default:
+	      corrupt(here(), "Unexpected control line");
+	      /*NOTREACHED*/
+	      break;
+	    }
+	  if (!outcome.first)
+	    {
+	      corrupt(here(), "%s", outcome.second.c_str());
+	      /*NOTREACHED*/
+	    }
+	}
+    }
+  phase.count("body_lines", body_lines);
+  phase.count("control_lines", control_lines);
+  return cssc::Failure::Ok();
+}
+
+cssc::Failure
+sccs_file_body_scanner::scan_body(seq_no highest_delta_seqno,
+				  std::function<std::pair<bool, std::string>(char command,
+									     seq_no seq)> each_control,
+				  std::function<cssc::Failure(const cssc_linebuf& line)> each_line)
+{
+  cssc::Failure seek = seek_to_body();
+  if (!seek.ok())
+    return seek;
+
+  trace_phase phase("body", name());
+  unsigned long body_lines = 0, control_lines = 0;
+  for (;;)
+    {
+      FailureOr<char> fol = read_line();
+      if (!fol.ok())
+	{
+	  if (isEOF(fol.fail()))
+	    break;
+	  return fol.fail();
+	}
+      const char line_type = *fol;
+      if (0 == line_type)
+	{
+	  ++body_lines;
+	  cssc::Failure done = each_line(*plinebuf);
+	  if (!done.ok())
+	    return done;
+	  continue;
+	}
+
+      ++control_lines;
+      check_arg();
+      seq_no seq = strict_atous(here(), plinebuf->c_str() + 3);
+      if (seq < 1 || seq > highest_delta_seqno)
+	{
+	  corrupt(here(), "Invalid serial number %u converted from '%s'",
+		  unsigned(seq), plinebuf->c_str());
+	  /*NOTREACHED*/
+	}
+      if ('I' != line_type && 'D' != line_type && 'E' != line_type)
+	{
+	  corrupt(here(), "Unexpected control line");
+	  /*NOTREACHED*/
+	}
+      std::pair<bool, std::string> outcome = each_control(line_type, seq);
+      if (!outcome.first)
+	{
+	  corrupt(here(), "%s", outcome.second.c_str());
+	  /*NOTREACHED*/
+	}
+    }
+  phase.count("body_lines", body_lines);
+  phase.count("control_lines", control_lines);
+  return cssc::Failure::Ok();
+}
+
 delta_result
-sccs_file_body_scanner::delta(const std::string& dname,
-			      const std::string& file_to_diff,
+sccs_file_body_scanner::delta(const line_list& new_lines,
 			      seq_no highest_delta_seqno,
 			      seq_no new_seq,
 			      seq_state *sstate, FILE *out,
 			      bool display_diff_output)
 {
   delta_result result;
-  if (!seek_to_body().ok())  // prepare to read the body for predecessor.
+
+  // Reconstruct the predecessor in memory and compare it with the
+  // new version of the file.
+  line_list old_lines;
+  seq_state pstate(*sstate);
+  cssc::Failure got = get_lines(highest_delta_seqno, pstate, &old_lines);
+  if (!got.ok())
     {
+      errormsg("%s", got.to_string().c_str());
       result.success = false;
       return result;
     }
+  const std::vector<diff_hunk> hunks = diff_lines(old_lines, new_lines);
 
-  FileDiff differ(dname.c_str(), file_to_diff.c_str());
-  FILE *diff_out = differ.start();
-  class diff_state dstate(diff_out, display_diff_output);
+  if (!seek_to_body().ok())  // prepare to read the body again.
+    {
+      result.success = false;
+      return result;
+    }
+  class diff_state dstate(old_lines, new_lines, hunks, display_diff_output);
 
   result.success = [this, &result, highest_delta_seqno, new_seq, sstate, &dstate, out]() -> bool
     {
@@ -438,14 +615,12 @@ sccs_file_body_scanner::delta(const std::string& dname,
 #endif
 			++result.inserted;
 
-			auto pline = dstate.get_insert_line();
-			auto len = strlen(pline);
-			if (len)
-			  len -= 1u;  // newline char should not contribute.
-
-			if (0 == len_max || len < len_max)
+			size_t len;
+			const char *pline = dstate.get_insert_line(&len);
+			// newline char should not contribute.
+			if (0 == len_max || len - 1u < len_max)
 			  {
-			    if (fputs_failed(fputs(pline, out)))
+			    if (fwrite(pline, 1, len, out) < len)
 			      {
 				return false;
 			      }
@@ -453,7 +628,7 @@ sccs_file_body_scanner::delta(const std::string& dname,
 			else
 			  {
 			    // The line is too long.
-			    line_too_long(len_max, len);
+			    line_too_long(len_max, len - 1u);
 			    return false;
 			  }
 			break;
@@ -500,16 +675,12 @@ sccs_file_body_scanner::delta(const std::string& dname,
 		{
 		  ++result.inserted;
 
-		  auto pline = dstate.get_insert_line();
-		  auto len = strlen(pline);
-		  if (len)
-		    len -= 1u;      // newline char should not contribute.
-
-		  if (0 == len_max
-		      || len < len_max
-		      )
+		  size_t len;
+		  const char *pline = dstate.get_insert_line(&len);
+		  // newline char should not contribute.
+		  if (0 == len_max || len - 1u < len_max)
 		    {
-		      if (fputs_failed(fputs(pline, out)))
+		      if (fwrite(pline, 1, len, out) < len)
 			{
 			  return false;
 			}
@@ -517,7 +688,7 @@ sccs_file_body_scanner::delta(const std::string& dname,
 		  else
 		    {
 		      // The line is too long.
-		      line_too_long(len_max, len);
+		      line_too_long(len_max, len - 1u);
 		      return false;
 		    }
 		}
@@ -529,14 +700,15 @@ sccs_file_body_scanner::delta(const std::string& dname,
 #ifdef JAY_DEBUG
 	  fprintf(stderr, "-> %s\n", plinebuf->c_str());
 #endif
-	  fputs(plinebuf->c_str(), out);
+	  if (!plinebuf->write(out).ok())
+	    {
+	      return false;
+	    }
 	  putc('\n', out);
 	}
       return true;
     }();
 
-  differ.finish(diff_out); // "give back" the FILE pointer.
-  ASSERT(nullptr == diff_out);
   return result;
 }
 
@@ -544,9 +716,9 @@ sccs_file_body_scanner::delta(const std::string& dname,
 Failure
 sccs_file_body_scanner::emit_raw_body(FILE* out, const char *outname)
 {
-  auto emitline = [out](const char* s) -> Failure
+  auto emitline = [out](const cssc_linebuf& line) -> Failure
     {
-      TRY_PUTS(fputs(s, out));
+      TRY_OPERATION(line.write(out));
       TRY_PUTC(putc('\n', out));
       return Failure::Ok();
     };
@@ -562,7 +734,7 @@ sccs_file_body_scanner::emit_raw_body(FILE* out, const char *outname)
 	  else
 	    return got.fail();
 	}
-      Failure f = emitline(plinebuf->c_str());
+      Failure f = emitline(*plinebuf);
       if (!f.ok())
 	{
 	  return cssc::make_failure_builder(f)
@@ -727,7 +899,7 @@ sccs_file_body_scanner::remove(FILE *out, seq_no seq)
 	    }
 	  else
 	    {
-	      if (fputs_failed(fputs(plinebuf->c_str(), out))
+	      if (!plinebuf->write(out).ok()
 		  || putc_failed(putc('\n', out)))
 		{
 		  return cssc::make_failure_builder_from_errno(errno)
@@ -737,7 +909,7 @@ sccs_file_body_scanner::remove(FILE *out, seq_no seq)
 	}
       else if (state != INSERT)
 	{
-	  if (fputs_failed(fputs(plinebuf->c_str(), out))
+	  if (!plinebuf->write(out).ok()
 	      || putc_failed(putc('\n', out)))
 	    {
 	      return cssc::make_failure_builder_from_errno(errno)
@@ -756,6 +928,127 @@ sccs_file_body_scanner::remove(FILE *out, seq_no seq)
   return cssc::Failure::Ok();
 }
 
+cssc::Failure
+sccs_file_body_scanner::check_whole_file(seq_no highest_delta_seqno,
+					 std::vector<body_line_counts>* counts,
+					 int* sum)
+{
+  if (fseek(f_, 0L, SEEK_SET) != 0)
+    {
+      return cssc::make_failure_builder_from_errno(errno)
+	<< "fseek failed on " << name();
+    }
+  set_line_number(0);
+  counts->assign(highest_delta_seqno + 1u, body_line_counts());
+
+  auto corrupt_here = [this](const std::string& what) -> Failure
+    {
+      return cssc::make_failure_builder(cssc::errorcode::HistoryFileCorrupt)
+	<< what << " at " << here();
+    };
+
+  trace_phase phase("check", name());
+  unsigned long body_lines = 0, control_lines = 0;
+  int total = 0;
+  // The command letter of the open block for each sequence number
+  // (or 0), and the open ^AI and ^AD blocks in the order they were
+  // opened.  Each text line is inserted by the innermost ^AI.
+  std::vector<char> open(highest_delta_seqno + 1u, 0);
+  std::vector<seq_no> inserting, deleting;
+  for (;;)
+    {
+      cssc::Failure got = plinebuf->read_line(f_);
+      if (!got.ok())
+	{
+	  if (isEOF(got))
+	    break;
+	  return got;
+	}
+      here_.advance_line();
+      const char *s = plinebuf->c_str();
+      const size_t len = plinebuf->length();
+      if (here().line_number() == 1)
+	continue;		// the checksum line is not included.
+      for (size_t i = 0; i < len; ++i)
+	total += static_cast<char>(s[i]); // plain char, as in the parser.
+      if (here().line_number() <= start_.line_number())
+	continue;		// part of the header.
+
+      if ('\n' != s[len - 1u])
+	return corrupt_here("missing newline");
+      if ('\001' != s[0])
+	{
+	  ++body_lines;
+	  if (inserting.empty())
+	    return corrupt_here("text outside any ^AI block");
+	  ++(*counts)[inserting.back()].inserted;
+	  for (auto d : deleting)
+	    ++(*counts)[d].deleted;
+	  continue;
+	}
+
+      ++control_lines;
+      const char c = s[1];
+      unsigned long seq = 0;
+      size_t i = 3;
+      if (len < 5u || ' ' != s[2])
+	return corrupt_here("malformed control line");
+      for (; i < len - 1u; ++i)
+	{
+	  if (s[i] < '0' || s[i] > '9')
+	    return corrupt_here("malformed control line");
+	  seq = seq * 10u + (s[i] - '0');
+	  if (seq > highest_delta_seqno)
+	    break;
+	}
+      if (seq < 1 || seq > highest_delta_seqno)
+	return corrupt_here("invalid sequence number");
+
+      switch (c)
+	{
+	case 'I':
+	case 'D':
+	  if (open[seq])
+	    return corrupt_here(std::string("^A") + c
+				+ " for sequence number which is already active");
+	  open[seq] = c;
+	  (c == 'I' ? inserting : deleting).push_back(static_cast<seq_no>(seq));
+	  break;
+
+	case 'E':
+	  {
+	    if (!open[seq])
+	      return corrupt_here("unmatched ^AE");
+	    std::vector<seq_no>& blocks = ('I' == open[seq]) ? inserting : deleting;
+	    for (auto it = blocks.end(); it != blocks.begin(); )
+	      {
+		if (*--it == seq)
+		  {
+		    blocks.erase(it);
+		    break;
+		  }
+	      }
+	    open[seq] = 0;
+	  }
+	  break;
+
+	default:
+	  return corrupt_here("unexpected control line");
+	}
+    }
+  if (!inserting.empty() || !deleting.empty())
+    {
+      const seq_no seq = inserting.empty() ? deleting.back() : inserting.back();
+      return cssc::make_failure_builder(cssc::errorcode::HistoryFileCorrupt)
+	<< "no ^AE for ^A" << open[seq] << " " << seq
+	<< " before the end of the file";
+    }
+  phase.count("body_lines", body_lines);
+  phase.count("control_lines", control_lines);
+  *sum = total & 0xFFFF;
+  return cssc::Failure::Ok();
+}
+
 std::unique_ptr<sccs_file_body_scanner>
 make_unique_sccs_file_body_scanner(const std::string& filename,
 				   FILE*f,
@@ -26,6 +26,7 @@
 #include <sys/types.h>		/* off_t */
 #include <string>
 #include <functional>
+#include <vector>
 #include <system_error>
 
 #include "base-reader.h"
@@ -35,6 +36,7 @@
 
 class cssc_linebuf;
 class cssc_delta_table;
+class line_list;
 class seq_state;
 
 struct delta_result
@@ -47,6 +49,15 @@ struct delta_result
   unsigned long unchanged;
 };
 
+// The number of lines of the body each delta inserts and deletes.
+struct body_line_counts
+{
+  body_line_counts() : inserted(0), deleted(0) {}
+
+  unsigned long inserted;
+  unsigned long deleted;
+};
+
 class sccs_file_body_scanner : public sccs_file_reader_base
 {
 public:
@@ -61,18 +72,38 @@ public:
   sccs_file_body_scanner& operator=(const sccs_file_body_scanner&) = delete;
 
   cssc::Failure get(const std::string& gname, const cssc_delta_table&,
-		    std::function<cssc::Failure(const char *start,
+		    std::function<cssc::Failure(const char *start, size_t len,
 						struct delta const& gotten_delta,
 						bool force_expansion)> write_subst,
 		    cssc::Failure (*outputfn)(FILE*,const cssc_linebuf*),
 		    bool encoded,
 		    class seq_state &state, struct subst_parms &parms,
 		    bool do_kw_subst, bool debug, bool show_module, bool show_sid);
+  // Collect the lines of the body selected by |state| (without any
+  // keyword substitution or decoding) into |lines|.
+  cssc::Failure get_lines(seq_no highest_delta_seqno, seq_state& state,
+			  line_list* lines);
+  // As above, but collect two versions in the same pass over the
+  // body.
+  cssc::Failure get_lines(seq_no highest_delta_seqno,
+			  seq_state& state1, line_list* lines1,
+			  seq_state& state2, line_list* lines2);
+  // Write a new body to |out| which adds the delta |new_seq_no|,
+  // turning the version selected by |state| into |new_lines|.
   delta_result
-  delta(const std::string& dname, const std::string& file_to_diff,
+  delta(const line_list& new_lines,
 	seq_no highest_delta_seqno, seq_no new_seq_no, seq_state*, FILE* out,
 	bool display_diff_output);
 
+  // Read the body once, calling |each_control| for each control
+  // line and |each_line| for each text line.  |each_control| is given
+  // the command letter (I, D or E) and serial number, and returns
+  // false and an explanation if the control line makes no sense.
+  cssc::Failure scan_body(seq_no highest_delta_seqno,
+			  std::function<std::pair<bool, std::string>(char command,
+								     seq_no seq)> each_control,
+			  std::function<cssc::Failure(const cssc_linebuf& line)> each_line);
+
   cssc::Failure seek_to_body();
   cssc::Failure emit_raw_body(FILE*, const char*);
   cssc::Failure remove(FILE*, seq_no id);
@@ -81,7 +112,22 @@ public:
   // into "*** "s.  The name of the output file is |name|.
   cssc::Failure print_body(FILE* out, const std::string& name);
 
+  // Read the whole file once, adding each byte after the first line
+  // to |*sum| (as the checksum does), and check that the body is
+  // well-formed: each control line names a sequence number no higher
+  // than |highest_delta_seqno|, ^AI and ^AD blocks are ended by a
+  // matching ^AE, and each text line is inside an ^AI block.
+  // (*counts)[seq] receives the number of lines delta |seq| inserts
+  // and deletes.
+  cssc::Failure check_whole_file(seq_no highest_delta_seqno,
+				 std::vector<body_line_counts>* counts,
+				 int* sum);
+
 private:
+  cssc::Failure collect_lines(seq_no highest_delta_seqno, size_t n,
+			      seq_state* const states[],
+			      line_list* const lines[]);
+
   FILE* f_;
   // TODO: rationalise the body_start_ / start_ overcomplexity
   off_t body_start_;
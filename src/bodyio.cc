@@ -27,6 +27,7 @@
 
 #include <cstdio>
 #include <cstring>
+#include <vector>
 
 #include "cssc.h"
 #include "bodyio.h"
@@ -39,39 +40,42 @@
 #include "ioerr.h"
 #include "file.h"
 
-/* Check if we have exceeded the maximum line length.
- */
-static bool check_line_len(const char *iname,
-			   long int len_max,
-			   int column,
-			   int ch,
-			   FILE *in)
+namespace
 {
-  if (0 == len_max || column < len_max)
-    {
-      return true;
-    }
-  else
-    {
-      ungetc(ch, in);	// push back the character.
-
-      if (binary_file_creation_allowed())
-	{
-	  errormsg("%s: line length exceeds %ld characters, "
-		   "treating as binary.\n",
-		   iname, len_max );
-	}
-      else
-	{
-	  errormsg("%s: line length exceeds %d characters, "
-		   "and binary file support is disabled.\n",
-		   iname, len_max );
-	}
-      return false;
-    }
-}
-
-
+  // The input file is read this many bytes at a time, unless a
+  // single line is longer than that.
+  const size_t ingest_block_size = 64u * 1024u;
+
+  void report_line_too_long(const char *iname, long int len_max)
+  {
+    if (binary_file_creation_allowed())
+      {
+	errormsg("%s: line length exceeds %ld characters, "
+		 "treating as binary.\n",
+		 iname, len_max );
+      }
+    else
+      {
+	errormsg("%s: line length exceeds %ld characters, "
+		 "and binary file support is disabled.\n",
+		 iname, len_max );
+      }
+  }
+
+  // Write out BUF[0..LEN).  This is also used to put back data we
+  // have read but then decided not to accept as text; see
+  // body_insert().
+  cssc::Failure write_block(const char *buf, size_t len,
+			    const char *oname, FILE *out)
+  {
+    if (len && fwrite(buf, 1, len, out) < len)
+      {
+	return cssc::make_failure_builder_from_errno(errno)
+	  .diagnose() << "write error on " << oname;
+      }
+    return cssc::Failure::Ok();
+  }
+}  // unnamed namespace
 
 
 /* body_insert_text()
@@ -88,6 +92,16 @@ static bool check_line_len(const char *iname,
  *
  *  2) many diff(1) programs only cope with text files
  *   that end with a newline.
+ *
+ * The input is read a block at a time.  The complete lines in each
+ * block are checked (using memchr() to find the line ends) before
+ * any of them are written, and are then written out together.
+ * A partial line at the end of a block is kept for the next one.
+ *
+ * If we fail, the output file is rewound to where it was when we
+ * started, but everything we read from IN has been written to OUT
+ * beyond that point.  That allows body_insert() to recover the data
+ * even if IN is not seekable.
  */
 cssc::Failure
 body_insert_text(const char iname[], const char oname[],
@@ -95,70 +109,77 @@ body_insert_text(const char iname[], const char oname[],
 		 unsigned long int *lines,
 		 bool *idkw)
 {
-  int ch, last;
   unsigned long int nl;		// number of lines.
   const long int len_max = max_sfile_line_len();
   bool found_id;
-  int column;			// current column in ouutput file.
 
   // If we fail, rewind these files to try binary encoding.
   FilePosSaver o_saver(out);
 
   *idkw = found_id = false;
   nl = 0uL;
-  last = '\n';
 
-  column = 0;
-  while ( EOF != (ch=getc(in)) )
-    {
-      if ('\n' == ch)
-	++nl;
+  std::vector<char> buf(ingest_block_size);
+  size_t held = 0;		// bytes of a partial line at the start of buf.
 
-      // check for ^A at start of line.
-      if ('\n' == last)
+  for (;;)
+    {
+      if (held == buf.size())
+	buf.resize(buf.size() * 2u); // a very long line.
+
+      const size_t n = fread(buf.data() + held, 1, buf.size() - held, in);
+      if (0 == n)
+	break;
+      const size_t end = held + n;
+      const char *const base = buf.data();
+
+      // Check each line in the block.  The last, incomplete, line
+      // is checked as far as it goes, so that we do not need to
+      // hold on to an overlong line before rejecting it.
+      size_t pos = 0;
+      while (pos < end)
 	{
-	  column = 0;
+	  const char *start = base + pos;
+	  const char *eol = static_cast<const char*>(memchr(start, '\n',
+							       end - pos));
+	  const size_t len = eol ? (eol - start) : (end - pos);
 
-	  if ('\001' == ch)
+	  if ('\001' == *start)
 	    {
-	      ungetc(ch, in);	// push back the control character.
+	      cssc::Failure put_back = write_block(base, end, oname, out);
+	      if (!put_back.ok())
+		return put_back;
 	      // output file pointer implicitly rewound
 	      return cssc::FailureBuilder(cssc::errorcode::ControlCharacterAtStartOfLine)
 		<< iname << ": control character at start of line, "
 		<< "treating as binary.\n";
 	    }
-	}
-      else
-	{
-	  // TODO: are there too many increment operations here?
-	  ++column;
-	  if (!check_line_len(iname, len_max, ++column, ch, in))
+	  if (len_max > 0 && len >= static_cast<size_t>(len_max))
 	    {
+	      report_line_too_long(iname, len_max);
+	      cssc::Failure put_back = write_block(base, end, oname, out);
+	      if (!put_back.ok())
+		return put_back;
 	      // output file pointer implicitly rewound
 	      return cssc::FailureBuilder(cssc::errorcode::BodyLineTooLong)
 		<< iname << ": line is too long, treating as binary";
 	    }
-	}
+	  if (NULL == eol)
+	    break;
 
-      if (putc_failed(putc(ch, out)))
-	{
-	  return cssc::make_failure_builder_from_errno(errno)
-	    .diagnose() << "write error on " << oname;
+	  if (!found_id && ::check_id_keywords(start, len))
+	    *idkw = found_id = true;
+	  ++nl;
+	  pos += len + 1u;
 	}
 
-      if (!found_id)		// Check for ID keywords.
-	{
-	  if ('%' == last && is_id_keyword_letter(static_cast<char>(ch)))
-	    {
-	      const int peek = getc(in);
-	      if ('%' == peek)
-		*idkw = found_id = true;
-	      if (EOF != peek)	// Can't put the genie back in the bottle!
-		ungetc(peek, in);
-	    }
-	}
-
-      last = ch;
+      // All the complete lines were acceptable.
+      cssc::Failure written = write_block(base, pos, oname, out);
+      if (!written.ok())
+	return written;
+      held = end - pos;
+      if (held)
+	memmove(buf.data(), base + pos, held);
     }
 
   if (ferror(in))
@@ -167,10 +188,12 @@ body_insert_text(const char iname[], const char oname[],
 	.diagnose() << "read error on " << iname;
     }
 
-
   // Make sure the file ended with a newline.
-  if ('\n' != last)
+  if (held)
     {
+      cssc::Failure put_back = write_block(buf.data(), held, oname, out);
+      if (!put_back.ok())
+	return put_back;
       // output file pointer implicitly rewound
       return cssc::FailureBuilder(cssc::errorcode::FileDoesNotEndWithNewline)
 	<< iname << ": no newline at end of file, treating as binary";
@@ -28,6 +28,7 @@
 #include <string>
 #include "cssc.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "fileiter.h"
 #include "sccsfile.h"
 #include "version.h"
@@ -39,7 +40,7 @@
 
 
 void
-usage()
+cdc_usage()
 {
   fprintf(stderr,
 	  "usage: %s [-V] [-m MRs] [-y comments] -r SID file ...\n",
@@ -56,7 +57,7 @@ plural(const T& n)
 }
 
 int
-main(int argc, char *argv[])
+cdc_main(int argc, char **argv)
 {
   Cleaner arbitrary_name;
   int c;
@@ -241,6 +242,21 @@ main(int argc, char *argv[])
   return retval;
 }
 
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  cdc_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return cdc_main(argc, argv);
+}
+#endif
+
 /* Local variables: */
 /* mode: c++ */
 /* End: */
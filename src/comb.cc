@@ -0,0 +1,214 @@
+/*
+ * comb.cc: Part of GNU CSSC.
+ *
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ *
+ * Rewrites SCCS files keeping only some of their deltas.
+ *
+ * Unlike the comb of other SCCS implementations, which writes a
+ * shell script to rebuild the file with get and delta, this comb
+ * rewrites the file itself.
+ *
+ */
+
+#include <config.h>
+#include "cssc.h"
+#include "fileiter.h"
+#include "sccsfile.h"
+#include "pfile.h"
+#include "my-getopt.h"
+#include "multicall.h"
+#include "version.h"
+#include "delta.h"
+#include "except.h"
+#include "sid_list.h"
+
+
+void
+comb_usage() {
+	fprintf(stderr,
+"usage: %s [-osV] [-p SID | -c list] file ...\n",
+		prg_name);
+}
+
+
+static void
+print_summary(const char *name, const comb_summary& summary)
+{
+  printf("%s: %lu deltas, %ld bytes; combed, %lu deltas, %ld bytes",
+	 name, summary.deltas_before, summary.bytes_before,
+	 summary.deltas_after, summary.bytes_after);
+  if (summary.bytes_before > 0)
+    {
+      printf(" (%ld%%)",
+	     (summary.bytes_after * 100L) / summary.bytes_before);
+    }
+  printf("\n");
+}
+
+
+int
+comb_main(int argc, char **argv)
+{
+  Cleaner arbitrary_name;
+  int c;
+  sid oldest(sid::null_sid());	/* -p */
+  sid_list keep_list;		/* -c */
+  bool got_keep_list = false;
+  bool dry_run = false;		/* -s */
+
+  if (argc > 0)
+    set_prg_name(argv[0]);
+  else
+    set_prg_name("comb");
+
+  class CSSC_Options opts(argc, argv, "p!c!osV");
+  for (c = opts.next(); c != CSSC_Options::END_OF_ARGUMENTS;
+       c = opts.next())
+    {
+      switch (c)
+	{
+	case 'p':
+	  oldest = sid(opts.getarg());
+	  if (!oldest.valid())
+	    {
+	      errormsg("Invalid SID: '%s'", opts.getarg());
+	      return 2;
+	    }
+	  break;
+
+	case 'c':
+	  {
+	    sid_list keep_arg(opts.getarg());
+	    if (!keep_arg.valid())
+	      {
+		errormsg("Invalid list of SIDs: '%s'", opts.getarg());
+		return 2;
+	      }
+	    keep_list = keep_arg;
+	    got_keep_list = true;
+	  }
+	  break;
+
+	case 'o':
+	  // In other implementations, this changes the shell script
+	  // which comb writes.  We have no script, so it does nothing.
+	  break;
+
+	case 's':
+	  dry_run = true;
+	  break;
+
+	case 'V':
+	  version();
+	  break;
+	}
+    }
+
+  if (oldest.valid() && got_keep_list)
+    {
+      errormsg("The -p and -c options cannot be used together.");
+      return 2;
+    }
+
+  sccs_file_iterator iter(opts);
+  if (iter.empty())
+    {
+      errormsg("No SCCS file specified.");
+      return 1;
+    }
+
+  int retval = 0;
+
+  while (iter.next())
+    {
+      try
+	{
+	  sccs_name &name = iter.get_name();
+	  sccs_file file(name, dry_run ? READ : UPDATE);
+
+	  sccs_pfile pfile(name, sccs_pfile::pfile_mode::PFILE_READ);
+	  if (!dry_run && pfile.length() > 0)
+	    {
+	      // The SIDs in the p-file might not survive.
+	      errormsg("%s: The file is being edited.", name.c_str());
+	      retval = 1;
+	      continue;
+	    }
+
+	  std::function<bool(const delta&)> keep;
+	  if (oldest.valid())
+	    {
+	      const delta *d = file.find_delta(oldest);
+	      if (nullptr == d)
+		{
+		  errormsg("%s: Requested SID %s doesn't exist.",
+			   name.c_str(), oldest.as_string().c_str());
+		  retval = 1;
+		  continue;
+		}
+	      const seq_no first = d->seq();
+	      keep = [first](const delta& candidate)
+		{
+		  return candidate.seq() >= first;
+		};
+	    }
+	  else if (got_keep_list)
+	    {
+	      keep = [&keep_list](const delta& candidate)
+		{
+		  return keep_list.member(candidate.id());
+		};
+	    }
+
+	  cssc::FailureOr<comb_summary> combed = file.comb(keep, dry_run);
+	  if (!combed.ok())
+	    retval = 1;
+	  else if (dry_run)
+	    print_summary(name.c_str(), *combed);
+	}
+      catch (const CsscExitvalException& e)
+	{
+	  if (e.exitval > retval)
+	    retval = e.exitval;
+	}
+    }
+  return retval;
+}
+
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  comb_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return comb_main(argc, argv);
+}
+#endif
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
@@ -81,6 +81,12 @@ bool is_id_keyword_letter(char ch);
 /* functions from environment.cc. */
 bool binary_file_creation_allowed (void);
 long max_sfile_line_len(void);
+bool recursive_directory_walk (void);
+bool directory_inode_order (void);
+long lock_timeout(void);
+const char *lock_log_file(void);
+const char *edit_registry_file(void);
+const char *trace_file(void);
 void check_env_vars(void);
 
 #endif
@@ -28,7 +28,6 @@
 
 #include "cssc.h"
 #include "delta-table.h"
-#include "delta-iterator.h"
 
 bool
 cssc_delta_table::delta_at_seq_exists(seq_no seq) const
@@ -85,16 +84,8 @@ delta const * cssc_delta_table::
 find(sid id) const
 {
   ASSERT(nullptr != this);
-  const_delta_iterator iter(this, delta_selector::current);
-
-  while (iter.next())
-    {
-      if (iter->id() == id)
-	{
-	  return iter.operator->();
-	}
-    }
-  return NULL;
+  const size_type pos = l_.find_sid(id, false);
+  return pos < l_.size() ? &l_.at(pos) : NULL;
 }
 
 /* Finds a delta in the delta table by its SID.
@@ -105,16 +96,8 @@ delta const * cssc_delta_table::
 find_any(sid id) const
 {
   ASSERT(nullptr != this);
-  const_delta_iterator iter(this, delta_selector::all);
-
-  while (iter.next())
-    {
-      if (iter->id() == id)
-	{
-	  return iter.operator->();
-	}
-    }
-  return NULL;
+  const size_type pos = l_.find_sid(id, true);
+  return pos < l_.size() ? &l_.at(pos) : NULL;
 }
 
 // This non-const variety is used by sf-cdc.cc.
@@ -122,16 +105,8 @@ delta * cssc_delta_table::
 find(sid id)
 {
   ASSERT(nullptr != this);
-  delta_iterator iter(this, delta_selector::current);
-
-  while (iter.next())
-    {
-      if (iter->id() == id)
-	{
-	  return iter.operator->();
-	}
-    }
-  return NULL;
+  const size_type pos = l_.find_sid(id, false);
+  return pos < l_.size() ? &l_.at(pos) : NULL;
 }
 
 
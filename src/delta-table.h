@@ -29,6 +29,7 @@
 #include <deque>
 #include <vector>
 #include <map>
+#include <unordered_map>
 
 #include "delta.h"
 
@@ -38,6 +39,9 @@ class stl_delta_list
   sid high_release_;
   std::vector<struct delta> items_;
   std::map<seq_no, size_t> seq_table_;
+  // A SID can appear more than once if all but one of the deltas
+  // having it have been removed.
+  std::unordered_multimap<sid, size_t> sid_table_;
 
 protected:
   void update_highest(const delta& d)
@@ -67,7 +71,8 @@ public:
     : high_seqno_(0),
       high_release_(sid::null_sid()),
       items_(),
-      seq_table_()
+      seq_table_(),
+      sid_table_()
   {
   }
 
@@ -101,6 +106,7 @@ public:
     size_t pos = items_.size();
     items_.push_back(d);
     seq_table_[d.seq()] = pos;
+    sid_table_.emplace(d.id(), pos);
     update_highest(d);
   }
 
@@ -125,6 +131,22 @@ public:
     ASSERT (i != seq_table_.end());
     return items_[i->second];
   }
+
+  // Returns the index of the first delta with the given SID (only
+  // counting those not removed unless WITH_REMOVED), or size() if
+  // there is none.
+  size_type find_sid(const sid& id, bool with_removed) const
+  {
+    size_type found = items_.size();
+    const auto range = sid_table_.equal_range(id);
+    for (auto i = range.first; i != range.second; ++i)
+      {
+	if (i->second < found
+	    && (with_removed || !items_[i->second].removed()))
+	  found = i->second;
+      }
+    return found;
+  }
 };
 
 
@@ -33,6 +33,7 @@
 #include "delta.h"
 #include "cleanup.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "pfile.h"
 #include "sccsfile.h"
 #include "version.h"
@@ -40,21 +41,125 @@
 #include "ioerr.h"
 #include "file.h"
 #include "fileiter.h"
+#include "parallel.h"
+#include "line-diff.h"
 #include "cssc.h"
 
 
+namespace
+{
+  // For "delta -o": writes the g-file that "get -t" would write next,
+  // from the text of the delta MADE if that is the one it would get.
+  bool
+  get_after_delta(sccs_file& file, sccs_name& name,
+		  const std::string& gname,
+		  const sid& made, const line_list& new_version)
+  {
+    sid retrieve;
+    if (!file.find_requested_sid(sid::null_sid(), retrieve, true))
+      {
+	errormsg("%s: Requested SID not found.", name.c_str());
+	return false;
+      }
+
+    const bool executable = file.gfile_should_be_executable();
+    int mode = CREATE_AS_REAL_USER | CREATE_FOR_GET | CREATE_READ_ONLY;
+    if (executable)
+      mode |= CREATE_EXECUTABLE;
+    cssc::FailureOr<FILE*> fof = fcreate(gname, mode);
+    if (!fof.ok())
+      {
+	errormsg("%s", fof.to_string().c_str());
+	return false;
+      }
+    FILE *out = *fof;
+
+    cssc::FailureOr<get_status> gotten = get_status();
+    if (retrieve == made)
+      {
+	gotten = file.get_new_version(out, gname, made, new_version);
+      }
+    else
+      {
+	// Some other delta is at the top of its release, so we have to
+	// read the body of the SCCS file after all.
+	sccs_file updated(name, READ);
+	gotten = updated.get(out, gname, NULL, retrieve, sccs_date(),
+			     sid_list(), sid_list(), true,
+			     cssc::optional<std::string>(),
+			     false, false, false, false);
+      }
+    cssc::Failure f = gotten.ok() ? cssc::Failure::Ok() : gotten.fail();
+    f = Update(f, fclose_failure(out));
+    if (f.ok())
+      f = set_gfile_writable(gname, false, executable);
+    if (!f.ok())
+      {
+	errormsg("%s", f.to_string().c_str());
+	unlink_file_as_real_user(gname.c_str());
+	return false;
+      }
+
+    retrieve.print(stdout);
+    putchar('\n');
+    printf("%u lines\n", (*gotten).lines);
+    return true;
+  }
+
+  // For "delta -e": locks the delta that "get -e -t" would get,
+  // using the delta table which add_delta() has brought up to date.
+  bool
+  edit_after_delta(sccs_file& file, sccs_name& name, sccs_pfile& pfile)
+  {
+    sid retrieve;
+    if (!file.find_requested_sid(sid::null_sid(), retrieve, true))
+      {
+	errormsg("%s: Requested SID not found.", name.c_str());
+	return false;
+      }
+    cssc::Failure allowed = file.edit_mode_permitted(true);
+    if (!allowed.ok())
+      {
+	errormsg("%s", allowed.to_string().c_str());
+	return false;
+      }
+    if (!file.test_locks(retrieve, pfile))
+      return false;
+
+    int failed = 0;
+    const sid next = file.find_next_sid(retrieve, retrieve, 0, pfile,
+					&failed);
+    if (failed)
+      return false;
+
+    retrieve.print(stdout);
+    printf("\nnew delta ");
+    next.print(stdout);
+    putchar('\n');
+
+    sid_list include, exclude;
+    cssc::Failure added = pfile.add_lock(retrieve, next, include, exclude);
+    if (!added.ok())
+      {
+	errormsg("%s", added.to_string().c_str());
+	return false;
+      }
+    return true;
+  }
+}  // unnamed namespace
+
 
 
 void
-usage() {
+delta_usage() {
 	fprintf(stderr,
-"usage: %s [-nsVp] [-m MRs] [-r SID] [-y comments] file ...\n",
+"usage: %s [-nsVp] [-e | -o] [-m MRs] [-r SID] [-y comments] file ...\n",
 		prg_name);
 }
 
 #define EXITVAL_INVALID_OPTION (1)
 
-static int
+int
 delta_main(int argc, char **argv)
 {
   Cleaner arbitrary_name;
@@ -62,6 +167,8 @@ delta_main(int argc, char **argv)
   sid rid(sid::null_sid());
   int silent = 0;		/* -s */
   int keep_gfile = 0;		/* -n */
+  bool get_after = false;	/* -o */
+  bool edit_after = false;	/* -e */
   std::string mrs;		/* -m -M */
   std::string comments;		/* -y -Y */
   int suppress_mrs = 0;		// if -m given with no arg.
@@ -69,6 +176,7 @@ delta_main(int argc, char **argv)
   int suppress_comments = 0;	// if -y given with no arg.
   int got_comments = 0;
   bool display_diff_output = false; // -p
+  int max_jobs = 1;		/* -j */
   if (argc > 0) {
     set_prg_name(argv[0]);
   } else {
@@ -77,7 +185,7 @@ delta_main(int argc, char **argv)
 
   ASSERT(!rid.valid());
 
-  class CSSC_Options opts(argc, argv, "r!sng!m!y!pV", EXITVAL_INVALID_OPTION);
+  class CSSC_Options opts(argc, argv, "r!sng!m!y!pVj!eo", EXITVAL_INVALID_OPTION);
   for(c = opts.next();
       c != CSSC_Options::END_OF_ARGUMENTS;
       c = opts.next()) {
@@ -106,6 +214,22 @@ delta_main(int argc, char **argv)
       display_diff_output = true;
       break;
 
+    case 'o':
+      get_after = true;
+      break;
+
+    case 'e':
+      edit_after = true;
+      break;
+
+    case 'j':
+      max_jobs = atoi(opts.getarg());
+      if (max_jobs < 1) {
+	errormsg("Invalid number of jobs: '%s'", opts.getarg());
+	return EXITVAL_INVALID_OPTION;
+      }
+      break;
+
     case 'm':
       mrs = opts.getarg();
       suppress_mrs = (mrs == "");
@@ -124,6 +248,12 @@ delta_main(int argc, char **argv)
     }
   }
 
+  if (get_after && edit_after)
+    {
+      errormsg("The -e and -o options cannot be used together.");
+      return EXITVAL_INVALID_OPTION;
+    }
+
   sccs_file_iterator iter(opts);
   if (iter.empty())
     {
@@ -145,7 +275,8 @@ delta_main(int argc, char **argv)
 
   int retval = 0;
 
-  while (iter.next())
+  parallel_jobs jobs(max_jobs);
+  while (jobs.next(iter, retval))
     {
       try
 	{
@@ -156,14 +287,18 @@ delta_main(int argc, char **argv)
 
 	  if (first)
 	    {
+	      // If the file names are being read from stdin, it is
+	      // not available for reading MRs or comments.
 	      if (!suppress_mrs && !got_mrs && file.mr_required())
 		{
-		  mrs = prompt_user("MRs? ");
+		  if (!iter.using_stdin())
+		    mrs = prompt_user("MRs? ");
 		  got_mrs = 1;
 		}
 	      if (!suppress_comments && !got_comments)
 		{
-		  comments = prompt_user("comments? ");
+		  if (!iter.using_stdin())
+		    comments = prompt_user("comments? ");
 		  got_comments = 1;
 		}
 	      mr_list = split_mrs(mrs);
@@ -247,20 +382,30 @@ delta_main(int argc, char **argv)
 		}
 
 	      std::string gname = name.gfile();
+	      const sid made = found.second->delta;
+	      line_list new_version;
 
 	      // The check that authorised() makes cannot fail, since it
 	      // is a lookup on an in-memory data structure.  It
 	      // issues its own error message.
 	      if (!file.authorised() || !file.add_delta(gname, pfile, found.second,
 							mr_list, comment_list,
-							display_diff_output))
+							display_diff_output,
+							(get_after || edit_after)
+							? &new_version : NULL))
 		{
 		  retval = 1;
 		  // if delta failed, don't delete the g-file.
 		}
+	      else if (edit_after)
+		{
+		  // We carry on editing the working file.
+		  if (!edit_after_delta(file, name, pfile))
+		    retval = 1;
+		}
 	      else
 		{
-		  if (!keep_gfile)
+		  if (!keep_gfile || get_after)
 		    {
 		      /* SourceForge bug 489005: remove the g-file
 		       * as the real user if we are running setuid.
@@ -272,6 +417,12 @@ delta_main(int argc, char **argv)
 				   gname.c_str(), unlinked.to_string().c_str());
 			  retval = 1;
 			}
+		      else if (get_after
+			       && !get_after_delta(file, name, gname, made,
+						   new_version))
+			{
+			  retval = 1;
+			}
 		    }
 		}
 	    }
@@ -285,12 +436,20 @@ delta_main(int argc, char **argv)
   return retval;
 }
 
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  delta_usage();
+}
 
 int
 main(int argc, char **argv)
 {
   return delta_main(argc, argv);
 }
+#endif
 
 /* Local variables: */
 /* mode: c++ */
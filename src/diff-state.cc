@@ -23,71 +23,69 @@
  */
 #include "config.h"
 
-#include <limits>
-#include <errno.h>
-
 #include "cssc.h"
 #include "diff-state.h"
-#include "except.h"
-#include "failure.h"
-
-
-/* Quit with an appropriate error message when a read operation
-   on the diff output fails. */
-NORETURN
-diff_state::diff_output_corrupt() {
-        if (ferror(in_)) {
-                fatal_quit(errno, "(diff output): Read error.");
-        }
-        fatal_quit(-1, "(diff output): Unexpected EOF.");
-}
 
 
-/* Quit with a cryptic error message indicating that something
-   is wrong with the diff output. */
-
-NORETURN
-diff_state::diff_output_corrupt(const char *msg)
+void
+diff_state::echo_hunk_header() const
 {
-  fatal_quit(-1, "Diff output corrupt. (%s)", msg);
+  const size_t old_first = hunk_.old_start + 1u;
+  const size_t old_last = hunk_.old_start + hunk_.old_count;
+  const size_t new_first = hunk_.new_start + 1u;
+  const size_t new_last = hunk_.new_start + hunk_.new_count;
+  char op;
+
+  if (0u == hunk_.old_count)
+    {
+      op = 'a';
+      printf("%lu", static_cast<unsigned long>(hunk_.old_start));
+    }
+  else
+    {
+      op = hunk_.new_count ? 'c' : 'd';
+      if (old_last > old_first)
+	printf("%lu,%lu", static_cast<unsigned long>(old_first),
+	       static_cast<unsigned long>(old_last));
+      else
+	printf("%lu", static_cast<unsigned long>(old_first));
+    }
+  putchar(op);
+  if (0u == hunk_.new_count)
+    printf("%lu\n", static_cast<unsigned long>(hunk_.new_start));
+  else if (new_last > new_first)
+    printf("%lu,%lu\n", static_cast<unsigned long>(new_first),
+	   static_cast<unsigned long>(new_last));
+  else
+    printf("%lu\n", static_cast<unsigned long>(new_first));
 }
 
 
-inline long get_num(const char *p,  char **endp)
+void
+diff_state::echo_line(char prefix, const line_list& lines, size_t i) const
 {
-  errno = 0;
-  long val = strtol(p, endp, 10);
-  if ((val == std::numeric_limits<long>::max()
-       || val == std::numeric_limits<long>::min())
-      && (errno != 0))
+  putchar(prefix);
+  putchar(' ');
+  fwrite(lines.line(i), 1, lines.length(i), stdout);
+  if (lines.missing_final_newline() && i + 1u == lines.size())
     {
-      // We have a range error.
-      throw CsscInternalRangeException(p);
+      fputs("\\ No newline at end of file\n", stdout);
     }
-  return val;
 }
 
 
-/* Figure out what the new state should be by processing the
-   diff output. */
+/* Figure out what the new state should be from the next hunk of
+   differences. */
 
 inline void
 diff_state::next_state()
 {
   if (state_ == diffstate::DELETE && change_left_ != 0)
     {
-      if (!read_line().ok())
-        {
-          diff_output_corrupt();
-        }
-#ifdef JAY_DEBUG
-      fprintf(stderr, "next_state(): read %s", linebuf_.c_str());
-#endif
-
-      if (strcmp(linebuf_.c_str(), "---\n") != 0)
-        {
-          diff_output_corrupt("expected ---");
-        }
+      if (echo_diff_output_)
+	{
+	  fputs("---\n", stdout);
+	}
       lines_left_ = change_left_;
       change_left_ = 0;
       state_ = diffstate::INSERT;
@@ -99,67 +97,31 @@ diff_state::next_state()
 
   if (state_ != diffstate::NOCHANGE)
     {
-      if (!read_line().ok())
+      if (next_hunk_ == hunks_.size())
         {
-          if (ferror(in_))
-            {
-              diff_output_corrupt();
-            }
           state_ = diffstate::END;
 #ifdef JAY_DEBUG
       fprintf(stderr, "next_state(): returning END [2]");
-#endif
-      return;
-        }
-#ifdef JAY_DEBUG
-      fprintf(stderr, "next_state()[3]: read %s", linebuf_.c_str());
-#endif
-
-      /* Ignore "\ No newline at end of file" if it appears
-         at the end of the diff output. */
-
-      if (linebuf_[0] == '\\')
-        {
-	  // if we can read a line, we weren't at EOF.
-	  auto status = read_line();
-          if (status.ok() || !cssc::isEOF(status))
-            {
-              diff_output_corrupt("Expected EOF");
-            }
-          if (ferror(in_))
-            {
-              diff_output_corrupt();
-            }
-          state_ = diffstate::END;
-#ifdef JAY_DEBUG
-      fprintf(stderr, "next_state(): returning END [4]\n");
 #endif
           return;
         }
-
+      hunk_ = hunks_[next_hunk_++];
+      if (echo_diff_output_)
+	{
+	  echo_hunk_header();
+	}
     }
 
-  char *s = nullptr;
+  // line1 and line2 are the first and last lines of the old file
+  // affected by the hunk, and line3 and line4 the first and last
+  // lines of the new file (numbered from 1, as diff does).  For an
+  // insertion, line1 is the line after which we insert; for a
+  // deletion, line3 is the line after which the deleted lines would
+  // have appeared.
   long line1, line2, line3, line4;
-  char c;
-
-  line1 = get_num(linebuf_.c_str(), &s);
-  line2 = line1;
-  if (*s == ',')
-    {
-      line2 = get_num(s + 1, &s);
-      if (line2 <= line1)
-        {
-          diff_output_corrupt("left end line");
-        }
-    }
-
-  c = *s;
-
-  ASSERT(c != '\0');
-
-  if (c == 'a')
+  if (0u == hunk_.old_count)
     {
+      line1 = line2 = static_cast<long>(hunk_.old_start);
       if (line1 >= in_lineno_)
         {
           state_ = diffstate::NOCHANGE;
@@ -169,88 +131,60 @@ diff_state::next_state()
 #endif
           return;
         }
-      if (line1 + 1 != in_lineno_)
-        {
-          diff_output_corrupt("left start line [case 1]");
-        }
+      ASSERT(line1 + 1 == in_lineno_);
     }
   else
     {
+      line1 = static_cast<long>(hunk_.old_start + 1u);
+      line2 = static_cast<long>(hunk_.old_start + hunk_.old_count);
       if (line1 > in_lineno_)
         {
           state_ = diffstate::NOCHANGE;
           lines_left_ = line1 - in_lineno_;
 #ifdef JAY_DEBUG
-      fprintf(stderr, "next_state(): returning END\n");
+      fprintf(stderr, "next_state(): returning NOCHANGE\n");
 #endif
           return;
         }
-      if (line1 != in_lineno_)
-        {
-          diff_output_corrupt("left start line [case 2]");
-        }
+      ASSERT(line1 == in_lineno_);
     }
 
-  line3 = get_num(s + 1, &s);
-  if (c == 'd')
+  if (0u == hunk_.new_count)
     {
-      if (line3 != out_lineno_)
-        {
-          diff_output_corrupt("right start line [case 1]");
-        }
+      line3 = line4 = static_cast<long>(hunk_.new_start);
+      ASSERT(line3 == out_lineno_);
     }
   else
     {
-      if (line3 != out_lineno_ + 1)
-        {
-          diff_output_corrupt("right start line [case 2]");
-        }
-    }
-
-  line4 = line3;
-  if (*s == ',')
-    {
-      line4 = get_num(s + 1, &s);
-      if (line4 <= line3)
-        {
-          diff_output_corrupt("right end line");
-        }
-    }
-
-  if (*s != '\n')
-    {
-      diff_output_corrupt("EOL");
+      line3 = static_cast<long>(hunk_.new_start + 1u);
+      line4 = static_cast<long>(hunk_.new_start + hunk_.new_count);
+      ASSERT(line3 == out_lineno_ + 1);
     }
 
-  switch (c)
+  if (0u == hunk_.old_count)
     {
-    case 'a':
       state_ = diffstate::INSERT;
       lines_left_ = line4 - line3 + 1;
 #ifdef JAY_DEBUG
       fprintf(stderr, "next_state(): returning INSERT [6]\n");
 #endif
-      break;
-
-    case 'd':
+    }
+  else if (0u == hunk_.new_count)
+    {
       state_ = diffstate::DELETE;
       lines_left_ = line2 - line1 + 1;
 #ifdef JAY_DEBUG
       fprintf(stderr, "next_state(): returning DELETE [7]\n");
 #endif
-      break;
-
-    case 'c':
+    }
+  else
+    {
       state_ = diffstate::DELETE;
       lines_left_ = line2 - line1 + 1;
       change_left_ = line4 - line3 + 1;
 #ifdef JAY_DEBUG
       fprintf(stderr, "next_state(): returning DELETE [8]\n");
 #endif
-      break;
-
-    default:
-      diff_output_corrupt("unknown operation");
     }
 }
 
@@ -290,27 +224,22 @@ diff_state::process(FILE *out, seq_no seq)
 
   if (state_ == diffstate::DELETE)
     {
-      if (!read_line().ok())
-        {
-          diff_output_corrupt();
-        }
-      if (linebuf_[0] != '<' || linebuf_[1] != ' ')
-        {
-          diff_output_corrupt("expected <");
-        }
+      ASSERT(in_lineno_ >= 1);
+      if (echo_diff_output_)
+	{
+	  echo_line('<', old_lines_, in_lineno_ - 1);
+	}
     }
   else
     {
       if (state_ == diffstate::INSERT)
         {
-          if (!read_line().ok())
-            {
-              diff_output_corrupt();
-            }
-          if (linebuf_[0] != '>' || linebuf_[1] != ' ')
-            {
-              diff_output_corrupt("expected >");
-            }
+	  insert_line_ = out_lineno_;
+	  ASSERT(insert_line_ < new_lines_.size());
+	  if (echo_diff_output_)
+	    {
+	      echo_line('>', new_lines_, insert_line_);
+	    }
         }
       out_lineno_++;
     }
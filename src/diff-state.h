@@ -24,11 +24,12 @@
 #define CSSC__DIFF_STATE_H
 
 #include <cstdio>
+#include <vector>
 
+#include "cssc-assert.h"
 #include "defaults.h"
 #include "delta.h"
-#include "failure.h"
-#include "linebuf.h"
+#include "line-diff.h"
 
 enum class diffstate { START, NOCHANGE, DELETE, INSERT, END };
 
@@ -42,49 +43,51 @@ private:
   int change_left_;
   bool echo_diff_output_;
 
-  FILE *in_;
-  cssc_linebuf linebuf_;
-
-  NORETURN diff_output_corrupt() POSTDECL_NORETURN;
-  NORETURN diff_output_corrupt(const char *msg) POSTDECL_NORETURN;
+  const line_list& old_lines_;
+  const line_list& new_lines_;
+  const std::vector<diff_hunk>& hunks_;
+  std::vector<diff_hunk>::size_type next_hunk_;
+  diff_hunk hunk_;
+  // Index into new_lines_ of the line to be inserted.
+  size_t insert_line_;
 
   void next_state();
-  cssc::Failure read_line()
-    {
-      cssc::Failure bad = linebuf_.read_line(in_);
-
-      // If and only if we read in a new line, echo it.
-      if (echo_diff_output_ && bad.ok())
-        {
-	  printf("%s", linebuf_.c_str());
-        }
-      return bad;
-    }
+  void echo_hunk_header() const;
+  void echo_line(char prefix, const line_list& lines, size_t i) const;
 
-  // Prohibit copying, to avoid two objects being able to consume data
-  // from the same input.
+  // Prohibit copying, to avoid two objects being able to consume
+  // the same hunks.
   diff_state& operator=(const diff_state&) = delete;
   diff_state(const diff_state&) = delete;
 
 public:
-  diff_state(FILE *f, bool echo)
+  // If echo is true, the differences are also printed on stdout in
+  // the format of diff(1).
+  diff_state(const line_list& old_lines, const line_list& new_lines,
+	     const std::vector<diff_hunk>& hunks, bool echo)
     : state_(diffstate::START),
       in_lineno_(0L), out_lineno_(0L),
       lines_left_(0), change_left_(0),
       echo_diff_output_(echo),
-      in_(f),
-      linebuf_()
+      old_lines_(old_lines),
+      new_lines_(new_lines),
+      hunks_(hunks),
+      next_hunk_(0u),
+      hunk_(),
+      insert_line_(0u)
     {
     }
 
   diffstate process(FILE *out, seq_no seq);
 
+  // Returns the line to be inserted; *len is set to its length,
+  // including the newline.  The result is not NUL-terminated.
   const char *
-  get_insert_line()
+  get_insert_line(size_t *len) const
     {
       ASSERT(state_ == diffstate::INSERT);
-      ASSERT(linebuf_[0] == '>' && linebuf_[1] == ' ');
-      return linebuf_.c_str() + 2;
+      *len = new_lines_.length(insert_line_);
+      return new_lines_.line(insert_line_);
     }
 
   long in_line() { return in_lineno_; }
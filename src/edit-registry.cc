@@ -0,0 +1,369 @@
+/*
+ * edit-registry.cc: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Members of the class edit_registry.
+ *
+ */
+#include "config.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cssc.h"
+#include "edit-registry.h"
+#include "file.h"
+#include "privs.h"
+#include "sccsname.h"
+
+namespace
+{
+  // The registry is rewritten each time it grows past this size, or
+  // twice this size, or four times this size, and so on.
+  const off_t compaction_threshold = 64 * 1024;
+
+  // Give up if the registry is replaced under us this many times.
+  const int max_reopen_attempts = 10;
+
+  std::vector<std::string> split(const std::string& s, char sep)
+  {
+    std::vector<std::string> parts;
+    std::string::size_type start = 0;
+    for (;;)
+      {
+	const std::string::size_type end = s.find(sep, start);
+	if (std::string::npos == end)
+	  {
+	    parts.push_back(s.substr(start));
+	    return parts;
+	  }
+	parts.push_back(s.substr(start, end - start));
+	start = end + 1;
+      }
+  }
+
+  std::string format_line(const std::string& sfile,
+			  const std::vector<edit_registry::lock>& locks)
+  {
+    std::string line = std::to_string(locks.size());
+    line.push_back('\t');
+    line.append(sfile);
+    for (const auto& l : locks)
+      {
+	line.push_back('\t');
+	line.append(l.got + ' ' + l.delta + ' ' + l.user + ' ' + l.date);
+      }
+    line.push_back('\n');
+    return line;
+  }
+
+  // Applies one line of the registry to *C.  Lines which do not make
+  // sense are ignored.
+  void apply_line(const std::string& line, edit_registry::contents *c)
+  {
+    const std::vector<std::string> fields = split(line, '\t');
+    if (fields.size() < 2u || fields[1].empty())
+      return;
+    char *end;
+    const unsigned long count = strtoul(fields[0].c_str(), &end, 10);
+    if (fields[0].empty() || *end || count != fields.size() - 2u)
+      return;
+
+    std::vector<edit_registry::lock> locks;
+    for (size_t i = 2u; i < fields.size(); ++i)
+      {
+	const std::vector<std::string> words = split(fields[i], ' ');
+	if (words.size() != 5u)
+	  return;
+	locks.push_back(edit_registry::lock{words[0], words[1], words[2],
+					    words[3] + ' ' + words[4]});
+      }
+    if (locks.empty())
+      c->erase(fields[1]);
+    else
+      (*c)[fields[1]] = std::move(locks);
+  }
+
+  // Applies each complete line of TEXT to *C.  An incomplete last
+  // line is ignored.
+  void apply_text(const std::string& text, edit_registry::contents *c)
+  {
+    std::string::size_type start = 0;
+    std::string::size_type nl;
+    while ((nl = text.find('\n', start)) != std::string::npos)
+      {
+	apply_line(text.substr(start, nl - start), c);
+	start = nl + 1;
+      }
+  }
+
+  // Reads the whole of the file open on FD, from the start.
+  cssc::Failure read_all(int fd, std::string *text)
+  {
+    if (lseek(fd, 0, SEEK_SET) < 0)
+      return cssc::make_failure_from_errno(errno);
+    char buf[8192];
+    ssize_t got;
+    while ((got = read(fd, buf, sizeof(buf))) != 0)
+      {
+	if (got < 0)
+	  {
+	    if (EINTR == errno)
+	      continue;
+	    return cssc::make_failure_from_errno(errno);
+	  }
+	text->append(buf, static_cast<size_t>(got));
+      }
+    return cssc::Failure::Ok();
+  }
+
+  cssc::Failure write_all(int fd, const std::string& text)
+  {
+    const char *p = text.data();
+    size_t left = text.size();
+    while (left)
+      {
+	const ssize_t done = write(fd, p, left);
+	if (done < 0)
+	  {
+	    if (EINTR == errno)
+	      continue;
+	    return cssc::make_failure_from_errno(errno);
+	  }
+	p += done;
+	left -= static_cast<size_t>(done);
+      }
+    return cssc::Failure::Ok();
+  }
+
+  bool crosses_threshold(off_t before, off_t after)
+  {
+    for (off_t t = compaction_threshold; t > 0 && t <= after; t *= 2)
+      {
+	if (before < t)
+	  return true;
+      }
+    return false;
+  }
+
+  // Rewrites the registry NAME, which is open on FD (and locked),
+  // without its out-of-date lines.  Nothing is done unless that would
+  // at least halve its size.
+  cssc::Failure compact(int fd, const std::string& name, mode_t mode)
+  {
+    std::string text;
+    cssc::Failure done = read_all(fd, &text);
+    if (!done.ok())
+      return done;
+    edit_registry::contents c;
+    apply_text(text, &c);
+    std::string live;
+    for (const auto& entry : c)
+      live.append(format_line(entry.first, entry.second));
+    if (live.size() * 2u > text.size())
+      return cssc::Failure::Ok();
+
+    const std::string tmpname = name + ".tmp";
+    const int tfd = open(tmpname.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+			 mode & 0777);
+    if (tfd < 0)
+      return cssc::make_failure_builder_from_errno(errno)
+	.diagnose() << "cannot create " << tmpname;
+    (void) fchmod(tfd, mode & 0777); // the umask may have removed bits.
+    done = write_all(tfd, live);
+    if (0 != close(tfd) && done.ok())
+      done = cssc::make_failure_from_errno(errno);
+    if (done.ok() && 0 != rename(tmpname.c_str(), name.c_str()))
+      done = cssc::make_failure_from_errno(errno);
+    if (!done.ok())
+      {
+	remove(tmpname.c_str());
+	return cssc::FailureBuilder(done)
+	  .diagnose() << "cannot rewrite " << name;
+      }
+    return cssc::Failure::Ok();
+  }
+
+  // Removes "." and ".." components from the absolute name PATH.
+  std::string lexically_normal(const std::string& path)
+  {
+    std::vector<std::string> kept;
+    for (const auto& part : split(path, '/'))
+      {
+	if (part.empty() || part == ".")
+	  continue;
+	if (part == "..")
+	  {
+	    if (!kept.empty())
+	      kept.pop_back();
+	  }
+	else
+	  {
+	    kept.push_back(part);
+	  }
+      }
+    std::string result;
+    for (const auto& part : kept)
+      result.append("/" + part);
+    return result.empty() ? std::string("/") : result;
+  }
+}  // unnamed namespace
+
+
+bool
+edit_registry::enabled()
+{
+  const char *name = edit_registry_file();
+  return name != nullptr && *name != '\0';
+}
+
+
+std::string
+edit_registry::canonical_name(const std::string& name)
+{
+  cssc::FailureOr<std::string> canonical = canonify_filename(name.c_str());
+  if (canonical.ok())
+    return *canonical;
+
+  // The file does not exist (or we cannot see it), so we do the best
+  // we can without looking at the file system.
+  std::string path(name);
+  if (path.empty() || '/' != path[0])
+    {
+      char *cwd = getcwd(nullptr, 0); // a common extension to POSIX.
+      if (cwd)
+	{
+	  path = std::string(cwd) + "/" + path;
+	  free(cwd);
+	}
+    }
+  return lexically_normal(path);
+}
+
+
+cssc::Failure
+edit_registry::record(const std::string& sfile,
+		      const std::vector<lock>& locks)
+{
+  const std::string name(edit_registry_file());
+  const std::string registered = canonical_name(sfile);
+  if (registered.find_first_of("\t\n") != std::string::npos)
+    {
+      return cssc::make_failure_builder_from_errno(EINVAL)
+	.diagnose() << "cannot record " << registered << " in " << name
+		    << " as its name contains a tab or newline";
+    }
+  const std::string line = format_line(registered, locks);
+
+  // The registry is named by the user, so it is opened, compacted
+  // and replaced as the real user; otherwise a set-user-id program
+  // could be used to append to or replace some other file, such as
+  // an SCCS file.
+  TempPrivDrop drop;
+  for (int attempt = 1; ; ++attempt)
+    {
+      const int fd = open(name.c_str(), O_RDWR | O_APPEND | O_CREAT, 0666);
+      if (fd < 0)
+	{
+	  return cssc::make_failure_builder_from_errno(errno)
+	    .diagnose() << "cannot open " << name;
+	}
+      const int err = lock_whole_file(fd, F_WRLCK, lock_timeout());
+      if (ETIMEDOUT == err)
+	{
+	  close(fd);
+	  return cssc::make_failure_builder(cssc::errorcode::LockTimedOut)
+	    .diagnose() << "cannot lock " << name;
+	}
+      if (err)
+	{
+	  close(fd);
+	  return cssc::make_failure_builder_from_errno(err)
+	    .diagnose() << "cannot lock " << name;
+	}
+
+      // If another process replaced the registry while we were
+      // waiting for the lock, we have the old one open.
+      struct stat locked, current;
+      if (0 != fstat(fd, &locked)
+	  || 0 != stat(name.c_str(), &current)
+	  || locked.st_dev != current.st_dev
+	  || locked.st_ino != current.st_ino)
+	{
+	  close(fd);
+	  if (attempt < max_reopen_attempts)
+	    continue;
+	  return cssc::make_failure_builder_from_errno(EAGAIN)
+	    .diagnose() << name << " keeps being replaced";
+	}
+
+      cssc::Failure done = write_all(fd, line);
+      if (done.ok()
+	  && crosses_threshold(locked.st_size,
+			       locked.st_size + static_cast<off_t>(line.size())))
+	{
+	  // Our line is already in the registry, so if this fails, we
+	  // have only missed a chance to make the registry smaller.
+	  (void) compact(fd, name, locked.st_mode);
+	}
+      if (0 != close(fd) && done.ok())
+	done = cssc::make_failure_from_errno(errno);
+      if (!done.ok())
+	{
+	  return cssc::FailureBuilder(done)
+	    .diagnose() << "cannot write to " << name;
+	}
+      return cssc::Failure::Ok();
+    }
+}
+
+
+cssc::FailureOr<edit_registry::contents>
+edit_registry::read()
+{
+  const std::string name(edit_registry_file());
+  contents c;
+  TempPrivDrop drop;		// see record().
+  const int fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0)
+    {
+      if (ENOENT == errno)
+	return c;		// nobody has edited anything yet.
+      return cssc::make_failure_builder_from_errno(errno)
+	.diagnose() << "cannot open " << name;
+    }
+  std::string text;
+  cssc::Failure done = read_all(fd, &text);
+  close(fd);
+  if (!done.ok())
+    {
+      return cssc::FailureBuilder(done)
+	.diagnose() << "cannot read " << name;
+    }
+  apply_text(text, &c);
+  return c;
+}
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
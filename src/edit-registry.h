@@ -0,0 +1,83 @@
+/*
+ * edit-registry.h: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Defines the class edit_registry, a single file listing the edit
+ * locks on many SCCS files.
+ */
+#ifndef CSSC__EDIT_REGISTRY_H__
+#define CSSC__EDIT_REGISTRY_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "failure.h"
+#include "failure_or.h"
+
+/* If the environment variable CSSC_EDIT_REGISTRY names a file, each
+ * time a p-file is rewritten the new set of edit locks is also
+ * recorded there, so that "sact -R" can say who is editing what
+ * without reading any p-files.
+ *
+ * The registry is a text file with one line for each change:
+ *
+ *    COUNT <TAB> SFILE [<TAB> GOT DELTA USER DATE TIME]...
+ *
+ * SFILE is the canonical absolute name of the SCCS file, and there
+ * are COUNT edit locks, each in the form printed by sact.  A later
+ * line for an SCCS file replaces all earlier ones; a COUNT of zero
+ * means the file is no longer being edited.
+ *
+ * Lines are appended while holding an fcntl() write lock on the
+ * registry.  Now and again the writer which has the lock rewrites
+ * the registry without its out-of-date lines, replacing the file by
+ * rename(), so readers never need a lock.
+ */
+class edit_registry
+{
+public:
+  struct lock
+  {
+    std::string got;
+    std::string delta;
+    std::string user;
+    std::string date;		// "yy/mm/dd hh:mm:ss"
+  };
+  typedef std::map<std::string, std::vector<lock> > contents;
+
+  static bool enabled();
+
+  // Records that the SCCS file SFILE now has the edit locks LOCKS.
+  static cssc::Failure record(const std::string& sfile,
+			      const std::vector<lock>& locks);
+
+  // Returns the edit locks of every SCCS file which has any.
+  static cssc::FailureOr<contents> read();
+
+  // Returns the name under which the file NAME is registered.
+  static std::string canonical_name(const std::string& name);
+};
+
+#endif /* CSSC__EDIT_REGISTRY_H__ */
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
@@ -33,21 +33,21 @@
 
 #include "cssc.h"
 
-bool binary_file_creation_allowed (void)
+/* Returns true if the environment variable VAR is set to YES, false
+ * if it is set to NO, and DEFAULT_VALUE if it is unset.
+ */
+static bool env_choice(const char *var, const char *yes, const char *no,
+		       bool default_value)
 {
-  static const char * const bin_var = "CSSC_BINARY_SUPPORT";
-  static const char * const enabled = "enabled";
-  static const char * const disabled = "disabled";
-
-  const char *p = getenv(bin_var);
+  const char *p = getenv(var);
 
   if (p)
     {
-      if (0 == strcmp(p, enabled))
+      if (0 == strcmp(p, yes))
 	{
 	  return true;
 	}
-      else if (0 == strcmp(p, disabled))
+      else if (0 == strcmp(p, no))
 	{
 	  return false;
 	}
@@ -60,20 +60,41 @@ bool binary_file_creation_allowed (void)
 	  fprintf(stderr,
 		  "Error: The %s environment variable, if set, must be set "
 		  "to either '%s' or '%s'.\n",
-		  bin_var,
-		  enabled,
-		  disabled);
+		  var,
+		  yes,
+		  no);
 	  exit(1);
 	}
     }
   else
     {
+      return default_value;
+    }
+}
+
+
+bool binary_file_creation_allowed (void)
+{
 #ifdef CONFIG_DISABLE_BINARY_SUPPORT
-      return false;
+  const bool default_value = false;
 #else
-      return true;
+  const bool default_value = true;
 #endif
-    }
+  return env_choice("CSSC_BINARY_SUPPORT", "enabled", "disabled",
+		    default_value);
+}
+
+
+bool recursive_directory_walk (void)
+{
+  return env_choice("CSSC_RECURSE_DIRECTORIES", "enabled", "disabled",
+		    false);
+}
+
+
+bool directory_inode_order (void)
+{
+  return env_choice("CSSC_DIRECTORY_ORDER", "inode", "directory", false);
 }
 
 
@@ -112,8 +133,66 @@ long max_sfile_line_len(void)
 }
 
 
+/* Returns the number of seconds for which to wait for the lock on
+ * an SCCS file, or -1 (the default) to wait indefinitely.
+ */
+long lock_timeout(void)
+{
+  static const char * const timeout_var = "CSSC_LOCK_TIMEOUT";
+  const char *p = getenv(timeout_var);
+
+  if (p)
+    {
+      char *endptr;
+      errno = 0;
+      const long seconds = strtol(p, &endptr, 10);
+      if (endptr == p || *endptr != '\0' || seconds < 0 || 0 != errno)
+	{
+	  fprintf(stderr,
+		  "Error: Environment variable '%s' is set to '%s', but "
+		  "should be either a decimal number of seconds or unset.\n",
+		  timeout_var,
+		  p);
+	  exit(1);
+	}
+      return seconds;
+    }
+  return -1;
+}
+
+
+/* Returns the name of the file to which records of lock contention
+ * should be appended, or NULL.  See lock-log.h.
+ */
+const char *lock_log_file(void)
+{
+  return getenv("CSSC_LOCK_LOG");
+}
+
+
+/* Returns the name of the registry of edit locks, or NULL.  See
+ * edit-registry.h.
+ */
+const char *edit_registry_file(void)
+{
+  return getenv("CSSC_EDIT_REGISTRY");
+}
+
+
+/* Returns the name of the file to which the records of each phase of
+ * processing should be appended, or NULL.  See trace.h.
+ */
+const char *trace_file(void)
+{
+  return getenv("CSSC_TRACE");
+}
+
+
 void check_env_vars(void)
 {
   (void) binary_file_creation_allowed();
   (void) max_sfile_line_len();
+  (void) recursive_directory_walk();
+  (void) directory_inode_order();
+  (void) lock_timeout();
 }
@@ -0,0 +1,172 @@
+/*
+ * event-log.cc: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Members of the class event_record.
+ */
+#include "config.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/time.h>
+
+#include "cssc.h"
+#include "event-log.h"
+#include "privs.h"
+#include "quit.h"
+#include "sysdep.h"
+
+namespace
+{
+  void
+  append_json_string(std::string& out, const std::string& s)
+  {
+    out.push_back('"');
+    for (char c : s)
+      {
+	const unsigned char uc = static_cast<unsigned char>(c);
+	if ('"' == c || '\\' == c)
+	  {
+	    out.push_back('\\');
+	    out.push_back(c);
+	  }
+	else if (uc < 0x20u)
+	  {
+	    char buf[8];
+	    snprintf(buf, sizeof(buf), "\\u%04x", uc);
+	    out.append(buf);
+	  }
+	else
+	  {
+	    out.push_back(c);
+	  }
+      }
+    out.push_back('"');
+  }
+
+  void
+  append_key(std::string& out, const char *key)
+  {
+    out.push_back(',');
+    append_json_string(out, key);
+    out.push_back(':');
+  }
+}  // unnamed namespace
+
+
+event_record::event_record(const char *log_name, const char *event)
+  : log_name_(log_name), line_()
+{
+  if (nullptr == log_name_ || '\0' == *log_name_)
+    return;
+
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  char buf[64];
+  snprintf(buf, sizeof(buf), "{\"time\":%ld.%06ld,\"pid\":%ld",
+	   static_cast<long>(now.tv_sec), static_cast<long>(now.tv_usec),
+	   static_cast<long>(getpid()));
+  line_ = buf;
+  append_key(line_, "program");
+  append_json_string(line_, prg_name ? prg_name : "");
+  append_key(line_, "event");
+  append_json_string(line_, event);
+}
+
+event_record&
+event_record::add(const char *key, long value)
+{
+  if (!line_.empty())
+    {
+      append_key(line_, key);
+      line_.append(std::to_string(value));
+    }
+  return *this;
+}
+
+event_record&
+event_record::add(const char *key, double seconds)
+{
+  if (!line_.empty())
+    {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "%.6f", seconds);
+      append_key(line_, key);
+      line_.append(buf);
+    }
+  return *this;
+}
+
+event_record&
+event_record::add(const char *key, const std::string& value)
+{
+  if (!line_.empty())
+    {
+      append_key(line_, key);
+      append_json_string(line_, value);
+    }
+  return *this;
+}
+
+event_record&
+event_record::add_file(const char *key, const std::string& name)
+{
+  if (line_.empty())
+    return *this;
+
+  // Relative names are made absolute, so that records written by
+  // processes in different directories can be compared.
+  std::string path(name);
+  if (!path.empty() && '/' != path[0])
+    {
+      char *cwd = getcwd(nullptr, 0); // a common extension to POSIX.
+      if (cwd)
+	{
+	  path = std::string(cwd) + "/" + path;
+	  free(cwd);
+	}
+    }
+  return add(key, path);
+}
+
+void
+event_record::write()
+{
+  if (line_.empty())
+    return;
+  line_.append("}\n");
+
+  // The log is opened as the real user, so that a set-user-id
+  // program cannot be used to write to some other file.  Failure to
+  // log is not an error.
+  TempPrivDrop drop;
+  const int fd = open(log_name_, O_WRONLY | O_APPEND | O_CREAT, 0666);
+  if (fd >= 0)
+    {
+      const ssize_t written = ::write(fd, line_.data(), line_.size());
+      (void) written;
+      close(fd);
+    }
+  line_.clear();
+}
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
@@ -0,0 +1,68 @@
+/*
+ * event-log.h: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Defines the class event_record, a line appended to a log file.
+ */
+#ifndef CSSC__EVENT_LOG_H__
+#define CSSC__EVENT_LOG_H__
+
+#include <string>
+
+/* An event_record is a single line holding a JSON object, which
+ * always begins with the time, the process ID, the name of the
+ * program and the kind of event, for example
+ *
+ *   {"time":1571234567.123456,"pid":1234,"program":"delta",
+ *    "event":"lock","file":"/src/SCCS/z.foo","attempts":3}
+ *
+ * (without the line break).  The line is written with a single
+ * write(2) to a file opened with O_APPEND, so several processes can
+ * share one log.  If no log file is given, the record is discarded
+ * without being formatted.
+ */
+class event_record
+{
+public:
+  // LOG_NAME is normally the value of an environment variable; if it
+  // is null or empty, nothing is logged.
+  event_record(const char *log_name, const char *event);
+
+  event_record& add(const char *key, long value);
+  event_record& add(const char *key, double seconds);
+  event_record& add(const char *key, const std::string& value);
+  // Add the name of a file, made absolute.
+  event_record& add_file(const char *key, const std::string& name);
+
+  bool active() const { return !line_.empty(); }
+
+  // Append the record to the log.
+  void write();
+
+private:
+  const char *log_name_;
+  std::string line_;
+};
+
+#endif /* CSSC__EVENT_LOG_H__ */
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
@@ -68,6 +68,8 @@ namespace cssc
 	return "the selected revision cannot be removed as it is referred to by another delta in the history file";
       case isit(errorcode::HistoryFileCorrupt):
 	return "format/parsing error in history file";
+      case isit(errorcode::LockTimedOut):
+	return "timed out waiting for the lock on the SCCS file";
       default:
 	return "unknown CSSC error";
       }
@@ -129,15 +131,18 @@ namespace cssc
 
   std::string Failure::to_string() const
   {
-    if (detail_.empty())
-      return code_.message();
+    if (!rep_)
+      return std::error_code().message();
+    else if (rep_->detail.empty())
+      return rep_->code.message();
     else
-      return detail_ + "; " + code_.message();
+      return rep_->detail + "; " + rep_->code.message();
   }
 
   const std::string& Failure::detail() const
   {
-    return detail_;
+    static const std::string none;
+    return rep_ ? rep_->detail : none;
   }
 
 
@@ -21,9 +21,11 @@
 
 #include "cssc-assert.h"
 
+#include <memory>
 #include <sstream>
 #include <system_error>
 #include <type_traits>
+#include <utility>
 
 namespace cssc
 {
@@ -67,6 +69,7 @@ namespace cssc
       UsagePreconditionFailureDeltaHasSuccessor,
       UsagePreconditionFailureDeltaInUse,
       HistoryFileCorrupt,
+      LockTimedOut,
     };
 
   // condition is for storing in std::error_condition
@@ -75,19 +78,46 @@ namespace cssc
       BodyIsBinary = 50000
     };
 
+  // A Failure is returned by very many functions (every write in
+  // the output loops of get and prs, for example) and nearly always
+  // indicates success.  So the OK state is just a null pointer; the
+  // error code and detail are held on the heap only when there is
+  // an error.
   class Failure
   {
   public:
     explicit Failure(std::error_code ec)
-      : code_(ec), detail_() {}
+      : rep_(ec ? new record(ec, std::string()) : nullptr) {}
     explicit Failure(std::error_code ec, const std::string& detail)
-      : code_(ec), detail_(detail) {}
+      : rep_(ec ? new record(ec, detail) : nullptr) {}
 
     // The default constructor signals "OK".
-    Failure()
-      : code_(std::error_code()), detail_()
+    Failure() noexcept
+      : rep_()
     {
-      ASSERT(ok());
+    }
+
+    Failure(const Failure& other)
+      : rep_(other.rep_ ? new record(*other.rep_) : nullptr)
+    {
+    }
+
+    Failure(Failure&& other) noexcept
+      : rep_(std::move(other.rep_))
+    {
+    }
+
+    Failure& operator=(const Failure& other)
+    {
+      if (this != &other)
+	rep_.reset(other.rep_ ? new record(*other.rep_) : nullptr);
+      return *this;
+    }
+
+    Failure& operator=(Failure&& other) noexcept
+    {
+      rep_ = std::move(other.rep_);
+      return *this;
     }
 
     // We deliberately do not have an implicit cast to bool so that we
@@ -96,12 +126,12 @@ namespace cssc
     // what happens if you use a std::error_code directly.
     bool ok() const
     {
-      return !code_;
+      return !rep_;
     }
 
     std::error_code code() const
     {
-      return code_;
+      return rep_ ? rep_->code : std::error_code();
     }
 
     std::string to_string() const;
@@ -112,19 +142,27 @@ namespace cssc
     // FailureBuilder::FailureBuilder(const Failure&).
     const std::string& detail() const;
 
-    static Failure Ok()
+    static Failure Ok() noexcept
     {
-      return Failure(std::error_code());
+      return Failure();
     }
 
   private:
-    std::error_code code_;
-    std::string detail_;
+    struct record
+    {
+      record(std::error_code ec, const std::string& d)
+	: code(ec), detail(d) {}
+
+      std::error_code code;
+      std::string detail;
+    };
+
+    std::unique_ptr<record> rep_;
   };
 
-  inline Failure Update(const Failure& orig, const Failure& next)
+  inline Failure Update(Failure orig, Failure next)
   {
-    return orig.ok() ? next : orig;
+    return orig.ok() ? std::move(next) : std::move(orig);
   }
 
   std::error_condition make_error_condition(condition e);
@@ -22,6 +22,8 @@
 #include <memory>
 #include <stdexcept>
 #include <system_error>
+#include <type_traits>
+#include <utility>
 
 #include "failure.h"
 
@@ -45,29 +47,33 @@ template <class T>
 class FailureOr
 {
  public:
+  // On the OK path, fail_ is only a null pointer, and the value is
+  // moved rather than copied wherever the caller allows it.
   FailureOr(const T& val)
     : value_(val),
-      fail_(Failure::Ok())
+      fail_()
   {
   }
 
   FailureOr(T&& val)
     : value_(std::move(val)),
-      fail_(Failure::Ok())
+      fail_()
   {
   }
 
   FailureOr(Failure fail)
-    : value_(), fail_(fail)
+    : value_(), fail_(std::move(fail))
   {
     // You should not create a FailureOr<T> from an instance of
     // Failure which does not actually represent an error, since this
     // leaves the FailureOr instance empty with a default-constructed
     // T.
-    ASSERT(!fail.ok());
+    ASSERT(!fail_.ok());
   }
 
-  FailureOr(FailureBuilder f)
+  // The builder is taken by reference, because a copy would issue
+  // its diagnostic a second time.
+  FailureOr(const FailureBuilder& f)
     : value_(),
       fail_(f)
   {
@@ -81,10 +87,13 @@ class FailureOr
   {
   }
 
-  // Alow copying where T is std::unique_ptr<Q>.
+  // Alow copying where T is std::unique_ptr<Q>.  Moving a Failure
+  // cannot throw, so standard containers can move a FailureOr unless
+  // moving T might throw.
   FailureOr(FailureOr&& source)
+    noexcept(std::is_nothrow_move_constructible<T>::value)
     : value_(std::move(source.value_)),
-      fail_(source.fail_)
+      fail_(std::move(source.fail_))
   {
   }
 
@@ -120,10 +129,11 @@ class FailureOr
     return *this;
   }
 
-  FailureOr& operator=(const FailureOr&& other) noexcept
+  FailureOr& operator=(FailureOr&& other)
+    noexcept(std::is_nothrow_move_assignable<T>::value)
   {
     value_ = std::move(other.value_);
-    fail_ = other.fail_;
+    fail_ = std::move(other.fail_);
     return *this;
   }
 
@@ -33,7 +33,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <signal.h>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <stdlib.h>
 
 #include "cssc.h"		/* for CONFIG_CAN_HARD_LINK_AN_OPEN_FILE */
@@ -42,6 +46,7 @@
 #include "failure_or.h"
 #include "sysdep.h"
 #include "file.h"
+#include "lock-log.h"
 #include "quit.h"
 #include "ioerr.h"
 #include "defaults.h"
@@ -244,8 +249,11 @@ static FailureOr<nlink_t> get_nlinks(const char *name)
     }
 }
 
+/* Sleep before another attempt to get the lock, but never for longer
+ * than LIMIT seconds (if LIMIT is not negative).
+ */
 static void
-maybe_wait_a_bit(long attempt, const char *lockfile)
+maybe_wait_a_bit(long attempt, const char *lockfile, long limit)
 {
     unsigned int waitfor = 0u;
 
@@ -273,6 +281,9 @@ maybe_wait_a_bit(long attempt, const char *lockfile)
         }
     }
 
+    if (limit >= 0 && waitfor > static_cast<unsigned long>(limit))
+      waitfor = static_cast<unsigned int>(limit);
+
     if (waitfor)
     {
       // TODO: the cast below is likely wrong if pid_t is unsigned;
@@ -358,8 +369,10 @@ static FailureOr<int> atomic_nfs_create(const std::string& path, int flags, int
                     }
                   else
 		    {
-                      /* The z.* file exists; wait a bit. */
-                      maybe_wait_a_bit(attempt, path.c_str());
+                      /* The z.* file exists; our caller decides
+		       * whether and how to wait for it.
+		       */
+		      return cssc::make_failure_from_errno(EEXIST);
 		    }
                 }
             }
@@ -371,14 +384,11 @@ static FailureOr<int> atomic_nfs_create(const std::string& path, int flags, int
           switch (errno)
             {
             case EEXIST:
-              /* someone else got that lock first; they may in fact not
-               * be trying to lock the same s-file (but instead another
-               * s-file in the same directory)
-               *
-               * Try again.  Sleep first if we're not doing well,
-               * but try to avoid pathalogical cases...
+              /* someone else is using that temporary name; they may
+               * in fact not be trying to lock the same s-file (but
+               * instead another s-file in the same directory).  Try
+               * the next name.
                */
-              maybe_wait_a_bit(attempt, path.c_str());
               break;
 
             default:            /* hard failure. */
@@ -386,7 +396,7 @@ static FailureOr<int> atomic_nfs_create(const std::string& path, int flags, int
             }
         }
     }
-  return -1;
+  return cssc::make_failure_from_errno(EEXIST);
 }
 
 
@@ -643,41 +653,239 @@ std::unique_ptr<file_lock> make_unique_file_lock(const std::string& s)
 }
 
 
+namespace
+{
+  void
+  wake_up(int)
+  {
+  }
+
+  int
+  set_record_lock(int fd, int cmd, struct flock *fl)
+  {
+    return (0 == fcntl(fd, cmd, fl)) ? 0 : errno;
+  }
+}  // unnamed namespace
+
+
+// Take a record lock of TYPE (F_RDLCK or F_WRLCK) on the whole of
+// the file open on FD, waiting for at most SECONDS seconds for it
+// (indefinitely, if SECONDS is negative, and not at all if it is
+// zero).  Returns 0 on success, ETIMEDOUT if we gave up waiting, or
+// some other errno value if record locks cannot be used on this file.
+int
+lock_whole_file(int fd, short type, long seconds)
+{
+  struct flock fl;
+  memset(&fl, 0, sizeof(fl));
+  fl.l_type = type;
+  fl.l_whence = SEEK_SET;
+  fl.l_start = 0;
+  fl.l_len = 0;		// to the end of the file.
+
+  struct sigaction old_action;
+  if (seconds > 0)
+    {
+      // Without SA_RESTART, the alarm makes fcntl() fail with EINTR.
+      struct sigaction wake;
+      memset(&wake, 0, sizeof(wake));
+      wake.sa_handler = wake_up;
+      sigemptyset(&wake.sa_mask);
+      wake.sa_flags = 0;
+      sigaction(SIGALRM, &wake, &old_action);
+      alarm(static_cast<unsigned int>(seconds));
+    }
+
+  int result;
+  do
+    {
+      result = -1;
+#ifdef F_OFD_SETLKW
+      // Open file description locks belong to the descriptor, so
+      // they are not lost if some other descriptor for the file is
+      // closed.  Older kernels reject them with EINVAL.
+      result = set_record_lock(fd, seconds ? F_OFD_SETLKW : F_OFD_SETLK, &fl);
+#endif
+      if (result < 0 || EINVAL == result)
+	result = set_record_lock(fd, seconds ? F_SETLKW : F_SETLK, &fl);
+    }
+  while (EINTR == result && seconds < 0);
+
+  if (0 == seconds && (EAGAIN == result || EACCES == result))
+    return ETIMEDOUT;		// someone else has it.
+
+  if (seconds > 0)
+    {
+      alarm(0);
+      sigaction(SIGALRM, &old_action, nullptr);
+    }
+  return (EINTR == result) ? ETIMEDOUT : result;
+}
+
+
+namespace
+{
+  // Returns the contents of the lock file, which is the process ID of
+  // the process holding the lock.
+  std::string
+  lock_holder(const std::string& zname)
+  {
+    std::string holder;
+    FILE *f = fopen(zname.c_str(), "r");
+    if (f)
+      {
+	int ch;
+	while ((ch = getc(f)) != EOF && ch != '\n' && holder.size() < 20u)
+	  holder.push_back(static_cast<char>(ch));
+	fclose(f);
+      }
+    return holder.empty() ? std::string("unknown") : holder;
+  }
+
+  // Wait for the process holding the lock file ZNAME to release it,
+  // for at most SECONDS seconds (or indefinitely if SECONDS is
+  // negative).  Returns Ok when it is worth trying again to create
+  // the lock file.
+  //
+  // A process holding the lock keeps a write lock on the lock file
+  // (see file_lock::file_lock), so we ask for a read lock, which the
+  // system grants as soon as the holder closes the file.
+  cssc::Failure
+  wait_for_lock_holder(const std::string& zname, long attempt, long seconds)
+  {
+    const int fd = open(zname.c_str(), O_RDONLY);
+    if (fd < 0)
+      {
+	if (ENOENT == errno)
+	  return cssc::Failure::Ok(); // it has just been released.
+	return cssc::make_failure_from_errno(errno);
+      }
+
+    const int err = lock_whole_file(fd, F_RDLCK, seconds);
+    bool still_there = true;
+    if (0 == err)
+      {
+	// Either the holder has released the lock (in which case the
+	// lock file has gone), or it does not use record locks: it is
+	// an older version of CSSC or another SCCS implementation, or
+	// it was killed before it could remove the lock file.
+	struct stat held, now;
+	still_there = (0 == fstat(fd, &held)
+		       && 0 == stat(zname.c_str(), &now)
+		       && held.st_ino == now.st_ino
+		       && held.st_dev == now.st_dev);
+      }
+    close(fd);
+
+    if (ETIMEDOUT == err)
+      return cssc::make_failure(cssc::errorcode::LockTimedOut);
+    if (still_there)
+      {
+	// Record locks are not supported here (as is the case for
+	// some NFS file systems) or the holder does not use them, so
+	// all we can do is to poll.
+	maybe_wait_a_bit(attempt, zname.c_str(), seconds);
+      }
+    return cssc::Failure::Ok();
+  }
+}  // unnamed namespace
+
+
 file_lock::file_lock(const std::string& zname)
   : lock_state_(),		// empty optional.
-    name_(zname)
+    name_(zname),
+    f_(nullptr),
+    wait_seconds_(0.0),
+    acquired_()
 {
   ASSERT(name_ == zname);
-  cssc::FailureOr<FILE*> fof =
-    fcreate(zname, CREATE_READ_ONLY | CREATE_EXCLUSIVE | CREATE_NFS_ATOMIC);
-  if (!fof.ok())
+  const long timeout = lock_timeout();
+  const auto start = std::chrono::steady_clock::now();
+  auto elapsed = [start]() -> double
     {
-      // XXX: do not assume errno has been preserved.
-      if (errno == EEXIST)
-        {
-	  ASSERT(lock_state_.has_value());
-	  ASSERT(lock_state_.value().ok());
-          return;
-        }
-      lock_state_ =
-	(cssc::FailureBuilder(fof.fail())
-	 .diagnose() << "can't create lock file " <<  zname);
-      ctor_fail_nomsg(1);
+      const std::chrono::duration<double> d =
+	std::chrono::steady_clock::now() - start;
+      return d.count();
+    };
+
+  FILE *f = nullptr;
+  long attempt;
+  std::string holder;		// only recorded for the lock log.
+  for (attempt = 0; nullptr == f; ++attempt)
+    {
+      cssc::FailureOr<FILE*> fof =
+	fcreate(zname, CREATE_READ_ONLY | CREATE_EXCLUSIVE | CREATE_NFS_ATOMIC);
+      if (fof.ok())
+	{
+	  f = *fof;
+	  break;
+	}
+      if (fof.fail().code() != std::errc::file_exists)
+	{
+	  lock_state_ =
+	    (cssc::FailureBuilder(fof.fail())
+	     .diagnose() << "can't create lock file " <<  zname);
+	  ctor_fail_nomsg(1);
+	}
+
+      // Someone else has the lock.
+      if (0 == attempt && lock_log_record::enabled())
+	holder = lock_holder(zname);
+      long remaining = -1;
+      cssc::Failure waited = cssc::Failure::Ok();
+      if (timeout >= 0)
+	{
+	  remaining = static_cast<long>(std::ceil(timeout - elapsed()));
+	  if (remaining <= 0)
+	    waited = cssc::make_failure(cssc::errorcode::LockTimedOut);
+	}
+      if (waited.ok())
+	waited = wait_for_lock_holder(zname, attempt, remaining);
+      if (!waited.ok())
+	{
+	  lock_log_record("lock-failed", zname)
+	    .add("attempts", attempt + 1)
+	    .add("wait", elapsed())
+	    .add("holder", lock_holder(zname))
+	    .write();
+	  lock_state_ =
+	    (cssc::FailureBuilder(waited)
+	     .diagnose() << "lock file " << zname << " is held by process "
+	     << lock_holder(zname));
+	  ctor_fail_nomsg(1);
+	}
     }
 
-  FILE *f = *fof;
   cssc::Failure done = do_lock(f);
-  if (fclose_failed(fclose(f)))
+  if (done.ok() && fflush(f) != 0)
     {
-      done = cssc::Update(done,
-			  cssc::make_failure_builder_from_errno(errno)
-			  .diagnose() << "failed to close " << zname);
+      done = cssc::make_failure_builder_from_errno(errno)
+	.diagnose() << "failed to write " << zname;
     }
   if (!done.ok())
     {
       remove(zname.c_str());
+      fclose(f);
       ctor_fail_nomsg(1);
     }
+
+  // Hold a write lock on the lock file until we remove it, so that
+  // other processes can wait for us to finish without polling.  If
+  // record locks are not supported here, they will poll instead.
+  (void) lock_whole_file(fileno(f), F_WRLCK, -1);
+  f_ = f;
+  acquired_ = std::chrono::steady_clock::now();
+  wait_seconds_ = elapsed();
+  lock_log_record record("lock", zname);
+  record.add("attempts", attempt + 1).add("wait", wait_seconds_);
+  if (!holder.empty())
+    record.add("holder", holder);
+  record.write();
+  if (wait_seconds_ >= 1.0)
+    {
+      errormsg("Waited %.1f seconds for the lock on %s",
+	       wait_seconds_, zname.c_str());
+    }
   lock_state_ = done;
   return;
 }
@@ -686,6 +894,15 @@ file_lock::~file_lock() {
   if (lock_state_.has_value()) {
     lock_state_.reset();
     unlink(name_.c_str());
+    const std::chrono::duration<double> held =
+      std::chrono::steady_clock::now() - acquired_;
+    lock_log_record("unlock", name_).add("held", held.count()).write();
+  }
+  // Closing the lock file releases our record lock on it, which wakes
+  // up any process waiting for the lock.
+  if (f_) {
+    fclose(f_);
+    f_ = nullptr;
   }
 }
 
@@ -64,6 +64,7 @@ cssc::Failure unlink_file_as_real_user(const char *gfile_name);
 void split_filename(const std::string& fullname,
 		    std::string& dirname,
 		    std::string& basename);
+int lock_whole_file(int fd, short type, long seconds);
 
 
 #ifdef CONFIG_SYNC_BEFORE_REOPEN
@@ -26,6 +26,7 @@
  */
 #include <config.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <string>
@@ -38,94 +39,183 @@
 #include "my-getopt.h"
 #include "file.h"
 #include "quit.h"
+#include "sysdep.h"
 #include "dirent-safer.h"
 
-namespace
+
+/* Reads the entries of one directory, either in the order in which
+ * the system returns them, or sorted by inode number (which tends to
+ * be the order in which they are stored on disk).
+ */
+class directory_reader
 {
+public:
+  enum class kind { UNKNOWN, DIRECTORY, SYMLINK, OTHER };
 
-  std::vector<std::string> from_directory(const std::string& passed_dir_name, DIR * dir)
-  {
-    std::vector<std::string> result;
-    const std::string slash((passed_dir_name.back() != '/') ? "/" : "");
-    const std::string dirname = passed_dir_name + slash;
-
-    unsigned long entry_error_count = 0;
-    int sample_entry_errno = 0;
-    for (;;)
-      {
-	errno = 0;
-	struct dirent *dent = readdir(dir);
-	if (dent == nullptr)
-	  {
-	    if (errno == 0)
-	      {
-		break; // end of directory entries
-	      }
-	    else
-	      {
-		// Otherwise it's a directory
-		// read error which might be
-		// followed by some valid
-		// files.
-		if (entry_error_count++ == 0)
-		  sample_entry_errno = errno;
-	      }
-	  }
-	std::string directory_entry = std::string(dirname) + std::string(dent->d_name);
-
-	if (sccs_name::valid_filename(directory_entry.c_str()).ok()
-	    && is_readable(directory_entry.c_str()))
-	  {
-	    cssc::FailureOr<bool> dircheck = is_directory(directory_entry.c_str());
-	    if (dircheck.ok())
-	      {
-		if (*dircheck)
-		  warning("Ignoring subdirectory %s",
-			  directory_entry.c_str());
-		else
-		  result.push_back(directory_entry);
-	      }
-	    else
-	      {
-		warning("Don't know if %s is a subdirectory (%s), ignoring it",
-			directory_entry.c_str(),
-			dircheck.to_string().c_str());
-	      }
-	  }
-      }
-    if (entry_error_count)
-      {
-	warning("%lu errors occurred reading from directory '%s' (example: \"%s\"), "
-		"so some directory entries may have been ignored.",
-		entry_error_count, passed_dir_name.c_str(), strerror(sample_entry_errno));
-      }
-    return result;
-  }
-
-  std::vector<std::string> from_stdin()
+  struct entry
   {
-    std::vector<std::string> result;
+    std::string name;
+    ino_t ino;
+    kind type;
+  };
+
+  // Takes ownership of DIR.
+  directory_reader(const std::string& name, DIR *dir, bool inode_order);
+  ~directory_reader();
+
+  bool next(entry *e);
+
+  const std::string& name() const { return name_; }
+  const std::string& prefix() const { return prefix_; }
 
-    cssc_linebuf linebuf;
+  // Names are interpreted relative to this directory, so that we do
+  // not resolve the whole of the directory's path for every entry.
+  int fd() const { return dirfd(dir_); }
+  cssc::FailureOr<bool> is_subdirectory(const entry& e, bool follow_links) const;
+  bool is_readable(const entry& e) const;
 
-    while (linebuf.read_line(stdin).ok())
-      {
-	std::string s (linebuf.c_str());
-	auto name = s.substr(0, s.length()-1u); // chop off the newline.
-	result.push_back(name);
-      }
-    return result;
-  }
+private:
+  bool read_entry(entry *e);
 
+  std::string name_;
+  std::string prefix_;
+  DIR *dir_;
+  bool sorted_;
+  std::vector<entry> entries_;	// used only if sorted_.
+  std::vector<entry>::size_type pos_;
+  unsigned long entry_error_count_;
+  int sample_entry_errno_;
+
+  directory_reader(const directory_reader&) = delete;
+  directory_reader& operator=(const directory_reader&) = delete;
+};
+
+
+directory_reader::directory_reader(const std::string& name, DIR *dir,
+				   bool inode_order)
+  : name_(name),
+    prefix_(name + ((name.back() != '/') ? "/" : "")),
+    dir_(dir),
+    sorted_(inode_order),
+    entries_(),
+    pos_(0),
+    entry_error_count_(0),
+    sample_entry_errno_(0)
+{
+  if (sorted_)
+    {
+      entry e;
+      while (read_entry(&e))
+	entries_.push_back(e);
+      std::stable_sort(entries_.begin(), entries_.end(),
+		       [](const entry& a, const entry& b)
+		       {
+			 return a.ino < b.ino;
+		       });
+    }
+}
+
+directory_reader::~directory_reader()
+{
+  closedir(dir_);
+}
+
+bool
+directory_reader::read_entry(entry *e)
+{
+  errno = 0;
+  struct dirent *dent = readdir(dir_);
+  if (dent == nullptr)
+    {
+      if (errno != 0)
+	{
+	  // A directory read error.  We stop reading this directory,
+	  // so some valid files may be missed.
+	  if (entry_error_count_++ == 0)
+	    sample_entry_errno_ = errno;
+	}
+      if (entry_error_count_)
+	{
+	  warning("%lu errors occurred reading from directory '%s' "
+		  "(example: \"%s\"), "
+		  "so some directory entries may have been ignored.",
+		  entry_error_count_, name_.c_str(),
+		  strerror(sample_entry_errno_));
+	  entry_error_count_ = 0;
+	}
+      return false;
+    }
+
+  e->name = dent->d_name;
+  e->ino = dent->d_ino;
+  e->type = kind::UNKNOWN;
+#ifdef _DIRENT_HAVE_D_TYPE
+  switch (dent->d_type)
+    {
+    case DT_DIR:
+      e->type = kind::DIRECTORY;
+      break;
+    case DT_LNK:
+      e->type = kind::SYMLINK;
+      break;
+    case DT_UNKNOWN:
+      break;
+    default:
+      e->type = kind::OTHER;
+      break;
+    }
+#endif
+  return true;
+}
+
+bool
+directory_reader::next(entry *e)
+{
+  if (!sorted_)
+    return read_entry(e);
+  if (pos_ == entries_.size())
+    return false;
+  *e = entries_[pos_++];
+  return true;
+}
+
+cssc::FailureOr<bool>
+directory_reader::is_subdirectory(const entry& e, bool follow_links) const
+{
+  if (e.type == kind::DIRECTORY || e.type == kind::OTHER)
+    return e.type == kind::DIRECTORY;
+  if (e.type == kind::SYMLINK && !follow_links)
+    return false;
+
+  struct stat st;
+  if (0 != fstatat(fd(), e.name.c_str(), &st,
+		   follow_links ? 0 : AT_SYMLINK_NOFOLLOW))
+    {
+      return cssc::make_failure_builder_from_errno(errno)
+	<< "unable to determine whether " << prefix_ << e.name
+	<< " is a directory";
+    }
+  return S_ISDIR(st.st_mode) ? true : false;
+}
+
+bool
+directory_reader::is_readable(const entry& e) const
+{
+  // Like is_readable(), this checks access for the real user.
+  return 0 == faccessat(fd(), e.name.c_str(), R_OK, 0);
+}
 
-}  // unnamed namespace
 
 sccs_file_iterator::sccs_file_iterator(const CSSC_Options &opts)
   : source_(source::NONE),
     is_unique_(false),
     files_(),
     pos(0),
-    name_()
+    name_(),
+    linebuf_(),
+    dirs_(),
+    recursive_(false),
+    inode_order_(false)
 {
   auto argv = opts.get_argv() + opts.get_index();
   auto argc = opts.get_argc() - opts.get_index();
@@ -141,7 +231,6 @@ sccs_file_iterator::sccs_file_iterator(const CSSC_Options &opts)
   if (strcmp(first, "-") == 0)
     {
       source_ = source::STDIN;
-      files_ = from_stdin();
       return;
     }
 
@@ -151,11 +240,10 @@ sccs_file_iterator::sccs_file_iterator(const CSSC_Options &opts)
       if (dir != NULL)
 	{
 	  source_ = source::DIRECTORY;
-	  ResourceCleanup dir_closer([&dir](){
-	      closedir(dir);
-	    });
-	  files_ = from_directory(first, dir);
-	  pos = 0;
+	  recursive_ = recursive_directory_walk();
+	  inode_order_ = directory_inode_order();
+	  dirs_.push_back(std::unique_ptr<directory_reader>
+			  (new directory_reader(first, dir, inode_order_)));
 	  return;
 	}
     }
@@ -180,6 +268,10 @@ sccs_file_iterator::sccs_file_iterator(const CSSC_Options &opts)
     }
 }
 
+sccs_file_iterator::~sccs_file_iterator()
+{
+}
+
 bool
 sccs_file_iterator::unique() const
 {
@@ -187,8 +279,98 @@ sccs_file_iterator::unique() const
 }
 
 
+bool
+sccs_file_iterator::next_from_stdin()
+{
+  if (!linebuf_.read_line(stdin).ok())
+    return false;
+
+  std::string s(linebuf_.c_str());
+  if (!s.empty() && s.back() == '\n')
+    s.pop_back();		// chop off the newline.
+  name_ = s;
+  return true;
+}
+
+
+bool
+sccs_file_iterator::next_from_directory()
+{
+  while (!dirs_.empty())
+    {
+      directory_reader& dir = *dirs_.back();
+      directory_reader::entry e;
+      if (!dir.next(&e))
+	{
+	  dirs_.pop_back();
+	  continue;
+	}
+      const std::string path = dir.prefix() + e.name;
+
+      if (recursive_ && e.name != "." && e.name != "..")
+	{
+	  // We don't follow symbolic links to directories, so that
+	  // the walk cannot loop.
+	  cssc::FailureOr<bool> subdir = dir.is_subdirectory(e, false);
+	  if (subdir.ok() && *subdir)
+	    {
+	      const int fd = openat(dir.fd(), e.name.c_str(),
+				    O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+	      DIR *d = (fd >= 0) ? fdopendir(fd) : NULL;
+	      if (NULL == d)
+		{
+		  warning("Cannot read directory %s: %s",
+			  path.c_str(), strerror(errno));
+		  if (fd >= 0)
+		    close(fd);
+		}
+	      else
+		{
+		  dirs_.push_back(std::unique_ptr<directory_reader>
+				  (new directory_reader(path, d, inode_order_)));
+		}
+	      continue;
+	    }
+	}
+
+      if (!sccs_name::valid_filename(path.c_str()).ok()
+	  || !dir.is_readable(e))
+	continue;
+
+      cssc::FailureOr<bool> dircheck = dir.is_subdirectory(e, true);
+      if (!dircheck.ok())
+	{
+	  warning("Don't know if %s is a subdirectory (%s), ignoring it",
+		  path.c_str(), dircheck.to_string().c_str());
+	}
+      else if (*dircheck)
+	{
+	  warning("Ignoring subdirectory %s", path.c_str());
+	}
+      else
+	{
+	  name_ = path;
+	  return true;
+	}
+    }
+  return false;
+}
+
+
 bool sccs_file_iterator::next()
 {
+  switch (source_)
+    {
+    case source::STDIN:
+      return next_from_stdin();
+
+    case source::DIRECTORY:
+      return next_from_directory();
+
+    default:
+      break;
+    }
+
   if (pos == files_.size())
     return false;		// end
   name_ = files_[pos++];
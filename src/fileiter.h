@@ -29,20 +29,26 @@
 #ifndef CSSC__FILEITER_H__
 #define CSSC__FILEITER_H__
 
+#include <memory>
 #include <string>
 #include <vector>
+#include "linebuf.h"
 #include "sccsname.h"
 
 class CSSC_Options;
+class directory_reader;
 
 
 /* This class is used to iterate over the list of SCCS files as
-   specified on the command line. */
+   specified on the command line.  Names read from standard input or
+   from a directory are produced as they are read, rather than all
+   being read before the first file is processed. */
 class sccs_file_iterator
 {
 public:
   enum class source { NONE = 0, ARGS, STDIN, DIRECTORY };
   sccs_file_iterator(const CSSC_Options&);
+  ~sccs_file_iterator();
 
   bool next();
 
@@ -57,11 +63,22 @@ public:
   bool unique() const;
 
 private:
+  bool next_from_stdin();
+  bool next_from_directory();
+
   source source_;
   bool is_unique_;
   std::vector<std::string> files_;
   std::vector<std::string>::size_type pos; // current iteration position
   sccs_name name_;
+  cssc_linebuf linebuf_;
+  // The directories being read; the innermost one is at the back.
+  std::vector<std::unique_ptr<directory_reader>> dirs_;
+  bool recursive_;
+  bool inode_order_;
+
+  sccs_file_iterator(const sccs_file_iterator&) = delete;
+  sccs_file_iterator& operator=(const sccs_file_iterator&) = delete;
 };
 
 #endif /* __FILEITER_H__ */
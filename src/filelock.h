@@ -28,6 +28,8 @@
 #ifndef CSSC__FILELOCK_H__
 #define CSSC__FILELOCK_H__
 
+#include <chrono>
+#include <cstdio>
 #include <memory>
 #include <string>
 
@@ -38,6 +40,9 @@
 class file_lock : private cleanup {
         cssc::optional<cssc::Failure> lock_state_;
         std::string name_;
+        FILE *f_;		// the lock file, held open while locked.
+        double wait_seconds_;
+        std::chrono::steady_clock::time_point acquired_;
 
         // TODO: consider a more modern kind of cleanup object.
 	void do_cleanup() override { this->~file_lock(); }
@@ -51,6 +56,8 @@ public:
 	    }
 	  return cssc::make_failure(cssc::errorcode::LockNotHeld);
 	}
+	// The time we spent waiting for another process to release the lock.
+	double wait_seconds() const { return wait_seconds_; }
 	~file_lock();
 };
 
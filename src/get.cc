@@ -32,19 +32,18 @@
 #include <errno.h>
 
 #include "cssc.h"
-#include "delta-table.h"
 #include "failure.h"
 #include "fileiter.h"
+#include "parallel.h"
 #include "sccsfile.h"
-#include "seqstate.h"
 #include "delta.h"
 #include "pfile.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "version.h"
 #include "except.h"
 #include "file.h"
 #include "privs.h"
-#include "subst-parms.h"
 
 #include <limits.h>
 
@@ -71,10 +70,10 @@ print_id_list(FILE *fp, const char *s, std::vector<sid> const &list)
 }
 
 void
-usage() {
+get_usage() {
         fprintf(stderr,
 "usage: %s [-begkmnpstLV] [-c date] [-r SID] [-i range] [-w string]\n"
-"\t[-x range] [-G gfile] file ...\n",
+"\t[-x range] [-G gfile] [-j jobs] file ...\n",
                 prg_name);
 }
 
@@ -92,7 +91,7 @@ using cssc::Update;
 using cssc::Failure;
 using cssc::FailureOr;
 int
-main(int argc, char **argv)
+get_main(int argc, char **argv)
 {
   Cleaner arbitrary_name;
   int retval = 0;
@@ -119,6 +118,7 @@ main(int argc, char **argv)
   bool delta_summary = false;	        /* -L, -l */
   bool create_lfile = false;            /* -l */
   FILE *commentary = stdout;
+  int max_jobs = 1;                     /* -j */
 
   if (argc > 0)
       set_prg_name(argv[0]);
@@ -128,7 +128,7 @@ main(int argc, char **argv)
   ASSERT(!rid.valid());
   ASSERT(!org_rid.valid());
 
-  class CSSC_Options opts(argc, argv, "r!c!i!x!ebkl!psmngtw!a!DVG!L",
+  class CSSC_Options opts(argc, argv, "r!c!i!x!ebkl!psmngtw!a!DVG!Lj!",
                           EXITVAL_INVALID_OPTION);
   for(c = opts.next();
       c != CSSC_Options::END_OF_ARGUMENTS;
@@ -283,6 +283,15 @@ main(int argc, char **argv)
           debug = 1;
           break;
 
+        case 'j':
+          max_jobs = atoi(opts.getarg());
+          if (max_jobs < 1)
+            {
+              errormsg("Invalid number of jobs: '%s'", opts.getarg());
+              return EXITVAL_INVALID_OPTION;
+            }
+          break;
+
         case 'V':
           version();
           break;
@@ -333,7 +342,8 @@ main(int argc, char **argv)
       return 1;
     }
 
-  while (iter.next())
+  parallel_jobs jobs(max_jobs);
+  while (jobs.next(iter, retval))
     {
       try
         {
@@ -593,170 +603,20 @@ main(int argc, char **argv)
   return retval;
 }
 
-/* Output the specified version to a file with possible modifications.
-   Most of the actual work is done with a seqstate object that
-   figures out whether or not given line of the SCCS file body
-   should be included in the output file. */
-cssc::FailureOr<get_status>
-sccs_file::get(FILE *out, const std::string& gname,
-	       FILE *summary_file,
-	       sid id, sccs_date cutoff_date,
-               sid_list include, sid_list exclude,
-               bool keywords, cssc::optional<std::string> wstring,
-               bool show_sid, bool show_module, bool debug,
-	       bool for_edit)
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
 {
-  ASSERT(nullptr != delta_table_);
-
-  seq_state state(highest_delta_seqno());
-  const delta *d = find_delta(id);
-  ASSERT(d != NULL);
-
-  ASSERT(nullptr != delta_table_);
-
-  cssc::Failure edit_allowed = edit_mode_permitted(for_edit);
-  if (!edit_allowed.ok())	// "get -e" on BK files is not allowed
-    return edit_allowed;
-
-  prepare_seqstate(state, d->seq(), include, exclude, cutoff_date);
-
-  // Fix by Mark Fortescue.
-  // Fix Cutoff Date Problem
-  const delta *dparm;
-  bool set=false;
-
-  for (seq_no s = d->seq(); s>0; s--)
-    {
-      if (delta_table_->delta_at_seq_exists(s))
-	{
-	    const struct delta & del = delta_table_->delta_at_seq(s);
-
-	    if (!state.is_excluded(s) && !set)
-	      {
-		dparm = find_delta(del.id());
-		set = true;
-	      }
-	}
-    }
-  if ( !set ) dparm = d;
-  // End of fix
-
-  if (getenv("CSSC_SHOW_SEQSTATE"))
-    {
-      for (seq_no s = d->seq(); s>0; s--)
-        {
-          if (!delta_table_->delta_at_seq_exists(s))
-            {
-              /* skip non-existent seq number */
-              continue;
-            }
-
-          fprintf(stderr, "%4d (", s);
-          delta_table_->delta_at_seq(s).id().dprint(stderr);
-          fprintf(stderr, ") ");
-
-          if (state.is_explicitly_tagged(s))
-            {
-              fprintf(stderr, "explicitly ");
-            }
-
-          if (state.is_ignored(s))
-            {
-              fprintf(stderr, "ignored\n");
-            }
-          else if (state.is_included(s))
-            {
-              fprintf(stderr, "included\n");
-            }
-          else if (state.is_excluded(s))
-            {
-              fprintf(stderr, "excluded");
-            }
-          else
-            {
-              fprintf(stderr, "irrelevant\n");
-            }
-        }
-    }
-
-  if (summary_file)
-    {
-      bool first = true;
-
-      for (seq_no s = d->seq(); s>0; s--)
-        {
-          if (delta_table_->delta_at_seq_exists(s)
-	      && state.is_included(s))
-	    {
-	      const struct delta & it = delta_table_->delta_at_seq(s);
-
-	      fprintf (summary_file, "%s    ",
-		       first ? "" : "\n");
-	      first = false;
-	      it.id().print(summary_file);
-	      fprintf (summary_file, "\t");
-	      it.date().print(summary_file);
-	      fprintf (summary_file, " %s\n", it.user().c_str());
-
-	      for (const std::string& comment : it.comments())
-		{
-		  fprintf (summary_file, "\t%s\n", comment.c_str());
-		}
-	    }
-	}
-      fputc ('\n', summary_file);
-    }
-
-
-
-  // The subst_parms here may not be the Whole Truth since
-  // the cutoff date may affect which version is actually
-  // gotten.  That's taken care of; the correct delta is
-  // passed as a parameter to the substitution function.
-  // (eugh...)
-  // Changed to use dparm not d to deal with Cutoff Date (Mark Fortescue)
-  struct subst_parms parms(gname, get_module_name(),
-			   out, wstring, *dparm,
-                           0, sccs_date::now());
-
-
-  cssc::Failure got = do_get(gname, state, parms, keywords, show_sid, show_module, debug,
-			     false, false);
-  if (!got.ok())
-    {
-      // TODO: verify whether or not we need to delete the g-file.
-      return got;
-    }
-
-  // only issue a warning about there being no keywords
-  // substituted, IF keyword substitution was being done.
-  if (keywords && !parms.found_id)
-    {
-      no_id_keywords(name_.c_str());
-      // this function normally returns.
-    }
-
-  /* Set the return status. */
-  struct get_status goodstatus;
-  goodstatus.lines = parms.out_lineno;
-
-  seq_no seq;
-  for(seq = 1; seq <= highest_delta_seqno(); seq++)
-    {
-      if (state.is_explicitly_tagged(seq))
-        {
-          const sid id_of_this_seq = seq_to_sid(seq);
-
-          if (state.is_included(seq))
-            goodstatus.included.push_back(id_of_this_seq);
-          else if (state.is_excluded(seq))
-            goodstatus.excluded.push_back(id_of_this_seq);
-        }
-    }
-  return goodstatus;
+  get_usage();
 }
 
-
+int
+main(int argc, char **argv)
+{
+  return get_main(argc, argv);
+}
+#endif
 
 /* Local variables: */
 /* mode: c++ */
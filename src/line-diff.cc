@@ -0,0 +1,568 @@
+/*
+ * line-diff.cc: Part of GNU CSSC.
+ *
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * The comparison uses the O(ND) algorithm described in Eugene
+ * W. Myers, "An O(ND) Difference Algorithm and Its Variations",
+ * Algorithmica 1 (1986) 251-266, in its linear-space form (as also
+ * used by GNU diff).
+ */
+#include "config.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+#include "cssc.h"
+#include "bodyio.h"
+#include "cssc-assert.h"
+#include "ioerr.h"
+#include "line-diff.h"
+#include "trace.h"
+
+
+line_list::line_list()
+  : text_(), starts_(1u, 0u), missing_final_newline_(false),
+    has_id_keywords_(false)
+{
+}
+
+void
+line_list::append(const char *s, size_t len)
+{
+  ASSERT(!missing_final_newline_);
+  text_.append(s, len);
+  text_.push_back('\n');
+  starts_.push_back(text_.size());
+}
+
+cssc::Failure
+line_list::read_file(FILE *f)
+{
+  ASSERT(!missing_final_newline_);
+  enum { BufSize = 65536 };
+  std::unique_ptr<char[]> buf(new char[BufSize]);
+  size_t scan_from = text_.size();
+  size_t nread;
+  while ((nread = fread(buf.get(), 1, BufSize, f)) != 0)
+    {
+      text_.append(buf.get(), nread);
+    }
+  if (ferror(f))
+    {
+      return cssc::make_failure_from_errno(errno);
+    }
+
+  const char *base = text_.data();
+  const size_t len = text_.size();
+  while (scan_from < len)
+    {
+      const void *nl = memchr(base + scan_from, '\n', len - scan_from);
+      const size_t line_end =
+	nl ? static_cast<size_t>(static_cast<const char*>(nl) - base) : len;
+      // An ID keyword cannot span lines, so we can look for one in
+      // each line while it is in the cache.
+      if (!has_id_keywords_
+	  && check_id_keywords(base + scan_from, line_end - scan_from))
+	{
+	  has_id_keywords_ = true;
+	}
+      if (nullptr == nl)
+	{
+	  // The last line has no newline.
+	  text_.push_back('\n');
+	  starts_.push_back(text_.size());
+	  missing_final_newline_ = true;
+	  break;
+	}
+      scan_from = line_end + 1u;
+      starts_.push_back(scan_from);
+    }
+  return cssc::Failure::Ok();
+}
+
+
+namespace
+{
+  // Assigns the same number to all identical lines, so that the
+  // comparison itself only needs to compare integers.  A final line
+  // without a newline never matches a line which has one.
+  class line_classifier
+  {
+  public:
+    line_classifier() : classes_(), members_() {}
+
+    size_t classify(const line_list& lines, size_t i)
+    {
+      const bool incomplete =
+	lines.missing_final_newline() && i + 1u == lines.size();
+      const char *s = lines.line(i);
+      const size_t len = lines.length(i);
+      const size_t h = hash(s, len, incomplete);
+      auto range = classes_.equal_range(h);
+      for (auto it = range.first; it != range.second; ++it)
+	{
+	  const member& m = members_[it->second];
+	  if (m.incomplete == incomplete
+	      && m.lines->length(m.index) == len
+	      && 0 == memcmp(m.lines->line(m.index), s, len))
+	    {
+	      return it->second;
+	    }
+	}
+      const size_t id = members_.size();
+      members_.push_back(member{&lines, i, incomplete});
+      classes_.insert(std::make_pair(h, id));
+      return id;
+    }
+
+    size_t count() const { return members_.size(); }
+
+  private:
+    struct member
+    {
+      const line_list *lines;
+      size_t index;
+      bool incomplete;
+    };
+
+    static size_t hash(const char *s, size_t len, bool incomplete)
+    {
+      // FNV-1a.
+      unsigned long long h = 14695981039346656037ULL;
+      for (size_t i = 0; i < len; ++i)
+	{
+	  h ^= static_cast<unsigned char>(s[i]);
+	  h *= 1099511628211ULL;
+	}
+      if (incomplete)
+	h = ~h;
+      return static_cast<size_t>(h);
+    }
+
+    std::unordered_multimap<size_t, size_t> classes_;
+    std::vector<member> members_;
+  };
+
+  // Finds the changed lines between two sequences of line classes,
+  // marking them in the vectors deleted_ and inserted_.
+  class myers_diff
+  {
+  public:
+    myers_diff(const std::vector<long>& a, const std::vector<long>& b,
+	       std::vector<bool>& deleted, std::vector<bool>& inserted)
+      : a_(a), b_(b), deleted_(deleted), inserted_(inserted),
+	fdiag_(a.size() + b.size() + 3u), bdiag_(a.size() + b.size() + 3u),
+	fd_(fdiag_.data() + b.size() + 1u), bd_(bdiag_.data() + b.size() + 1u)
+    {
+    }
+
+    void compare(long xoff, long xlim, long yoff, long ylim);
+
+  private:
+    void find_middle_snake(long xoff, long xlim, long yoff, long ylim,
+			   long *xmid, long *ymid);
+
+    const std::vector<long>& a_;
+    const std::vector<long>& b_;
+    std::vector<bool>& deleted_;
+    std::vector<bool>& inserted_;
+    std::vector<long> fdiag_;
+    std::vector<long> bdiag_;
+    // fd_ and bd_ are indexed by diagonal number (x - y), which may
+    // be negative.
+    long *fd_;
+    long *bd_;
+  };
+
+  void
+  myers_diff::find_middle_snake(long xoff, long xlim, long yoff, long ylim,
+				long *xmid, long *ymid)
+  {
+    const long dmin = xoff - ylim;
+    const long dmax = xlim - yoff;
+    const long fmid = xoff - yoff;
+    const long bmid = xlim - ylim;
+    long fmin = fmid, fmax = fmid;
+    long bmin = bmid, bmax = bmid;
+    const bool odd = (fmid - bmid) & 1;
+
+    fd_[fmid] = xoff;
+    bd_[bmid] = xlim;
+
+    for (;;)
+      {
+	// Extend the forward search by one edit.
+	if (fmin > dmin)
+	  fd_[--fmin - 1] = -1;
+	else
+	  ++fmin;
+	if (fmax < dmax)
+	  fd_[++fmax + 1] = -1;
+	else
+	  --fmax;
+	for (long d = fmax; d >= fmin; d -= 2)
+	  {
+	    const long tlo = fd_[d - 1], thi = fd_[d + 1];
+	    long x = (tlo >= thi) ? tlo + 1 : thi;
+	    long y = x - d;
+	    while (x < xlim && y < ylim && a_[x] == b_[y])
+	      {
+		++x;
+		++y;
+	      }
+	    fd_[d] = x;
+	    if (odd && bmin <= d && d <= bmax && bd_[d] <= x)
+	      {
+		*xmid = x;
+		*ymid = y;
+		return;
+	      }
+	  }
+
+	// Extend the backward search by one edit.
+	if (bmin > dmin)
+	  bd_[--bmin - 1] = LONG_MAX;
+	else
+	  ++bmin;
+	if (bmax < dmax)
+	  bd_[++bmax + 1] = LONG_MAX;
+	else
+	  --bmax;
+	for (long d = bmax; d >= bmin; d -= 2)
+	  {
+	    const long tlo = bd_[d - 1], thi = bd_[d + 1];
+	    long x = (tlo < thi) ? tlo : thi - 1;
+	    long y = x - d;
+	    while (xoff < x && yoff < y && a_[x - 1] == b_[y - 1])
+	      {
+		--x;
+		--y;
+	      }
+	    bd_[d] = x;
+	    if (!odd && fmin <= d && d <= fmax && x <= fd_[d])
+	      {
+		*xmid = x;
+		*ymid = y;
+		return;
+	      }
+	  }
+      }
+  }
+
+  void
+  myers_diff::compare(long xoff, long xlim, long yoff, long ylim)
+  {
+    // Slide down the bottom initial diagonal, and up the top one.
+    while (xoff < xlim && yoff < ylim && a_[xoff] == b_[yoff])
+      {
+	++xoff;
+	++yoff;
+      }
+    while (xoff < xlim && yoff < ylim && a_[xlim - 1] == b_[ylim - 1])
+      {
+	--xlim;
+	--ylim;
+      }
+
+    if (xoff == xlim)
+      {
+	while (yoff < ylim)
+	  inserted_[yoff++] = true;
+      }
+    else if (yoff == ylim)
+      {
+	while (xoff < xlim)
+	  deleted_[xoff++] = true;
+      }
+    else
+      {
+	long xmid, ymid;
+	find_middle_snake(xoff, xlim, yoff, ylim, &xmid, &ymid);
+	compare(xoff, xmid, yoff, ymid);
+	compare(xmid, xlim, ymid, ylim);
+      }
+  }
+}  // namespace
+
+
+std::vector<diff_hunk>
+diff_lines(const line_list& old_lines, const line_list& new_lines)
+{
+  const size_t n = old_lines.size();
+  const size_t m = new_lines.size();
+  trace_phase phase("diff", std::string());
+  phase.count("old_lines", n);
+  phase.count("new_lines", m);
+
+  line_classifier classifier;
+  std::vector<size_t> old_class(n), new_class(m);
+  for (size_t i = 0; i < n; ++i)
+    old_class[i] = classifier.classify(old_lines, i);
+  for (size_t j = 0; j < m; ++j)
+    new_class[j] = classifier.classify(new_lines, j);
+
+  // A line which occurs in only one of the files is certainly a
+  // change.  Leaving such lines out of the comparison keeps it fast
+  // when large parts of the file have been replaced.
+  std::vector<bool> in_old(classifier.count()), in_new(classifier.count());
+  for (size_t i = 0; i < n; ++i)
+    in_old[old_class[i]] = true;
+  for (size_t j = 0; j < m; ++j)
+    in_new[new_class[j]] = true;
+
+  std::vector<bool> deleted(n), inserted(m);
+  std::vector<long> a, b;
+  std::vector<size_t> a_index, b_index;
+  for (size_t i = 0; i < n; ++i)
+    {
+      if (in_new[old_class[i]])
+	{
+	  a.push_back(static_cast<long>(old_class[i]));
+	  a_index.push_back(i);
+	}
+      else
+	{
+	  deleted[i] = true;
+	}
+    }
+  for (size_t j = 0; j < m; ++j)
+    {
+      if (in_old[new_class[j]])
+	{
+	  b.push_back(static_cast<long>(new_class[j]));
+	  b_index.push_back(j);
+	}
+      else
+	{
+	  inserted[j] = true;
+	}
+    }
+
+  std::vector<bool> a_deleted(a.size()), b_inserted(b.size());
+  myers_diff(a, b, a_deleted, b_inserted)
+    .compare(0, static_cast<long>(a.size()), 0, static_cast<long>(b.size()));
+  for (size_t i = 0; i < a.size(); ++i)
+    {
+      if (a_deleted[i])
+	deleted[a_index[i]] = true;
+    }
+  for (size_t j = 0; j < b.size(); ++j)
+    {
+      if (b_inserted[j])
+	inserted[b_index[j]] = true;
+    }
+
+  // Unchanged lines correspond one-to-one in order, so we can collect
+  // the hunks by walking both files in step.
+  std::vector<diff_hunk> hunks;
+  size_t i = 0, j = 0;
+  while (i < n || j < m)
+    {
+      if (i < n && j < m && !deleted[i] && !inserted[j])
+	{
+	  ++i;
+	  ++j;
+	  continue;
+	}
+      diff_hunk h;
+      h.old_start = i;
+      h.new_start = j;
+      while (i < n && deleted[i])
+	++i;
+      while (j < m && inserted[j])
+	++j;
+      h.old_count = i - h.old_start;
+      h.new_count = j - h.new_start;
+      ASSERT(h.old_count || h.new_count);
+      hunks.push_back(h);
+    }
+  phase.count("hunks", hunks.size());
+  return hunks;
+}
+
+
+namespace
+{
+  // Write line i of |lines|, preceded by |prefix|.
+  cssc::Failure write_diff_line(FILE *out, const char *prefix,
+				const line_list& lines, size_t i)
+  {
+    if (fputs_failed(fputs(prefix, out)))
+      return cssc::make_failure_from_errno(errno);
+    const size_t len = lines.length(i);
+    cssc::Failure written = fwrite_failed(fwrite(lines.line(i), 1, len, out),
+					  len);
+    if (!written.ok())
+      return written;
+    if (lines.missing_final_newline() && i + 1u == lines.size())
+      {
+	if (fputs_failed(fputs("\\ No newline at end of file\n", out)))
+	  return cssc::make_failure_from_errno(errno);
+      }
+    return cssc::Failure::Ok();
+  }
+
+  cssc::Failure write_diff_lines(FILE *out, const char *prefix,
+				 const line_list& lines,
+				 size_t start, size_t count)
+  {
+    for (size_t i = start; i < start + count; ++i)
+      {
+	cssc::Failure written = write_diff_line(out, prefix, lines, i);
+	if (!written.ok())
+	  return written;
+      }
+    return cssc::Failure::Ok();
+  }
+
+  // Line ranges as written in the normal format: "5", "5,7", or for
+  // an empty range, the number of the line before it.
+  std::string normal_range(size_t start, size_t count)
+  {
+    char buf[64];
+    if (count > 1u)
+      snprintf(buf, sizeof(buf), "%lu,%lu",
+	       static_cast<unsigned long>(start + 1u),
+	       static_cast<unsigned long>(start + count));
+    else
+      snprintf(buf, sizeof(buf), "%lu",
+	       static_cast<unsigned long>(start + count));
+    return buf;
+  }
+
+  // Line ranges as written in the unified format: "5", "5,3" or
+  // "4,0".
+  std::string unified_range(size_t start, size_t count)
+  {
+    char buf[64];
+    if (1u == count)
+      snprintf(buf, sizeof(buf), "%lu", static_cast<unsigned long>(start + 1u));
+    else
+      snprintf(buf, sizeof(buf), "%lu,%lu",
+	       static_cast<unsigned long>(count ? start + 1u : start),
+	       static_cast<unsigned long>(count));
+    return buf;
+  }
+}  // unnamed namespace
+
+cssc::Failure
+write_normal_diff(FILE *out,
+		  const line_list& old_lines,
+		  const line_list& new_lines,
+		  const std::vector<diff_hunk>& hunks)
+{
+  for (const auto& h : hunks)
+    {
+      const char cmd = (0 == h.old_count) ? 'a' : (0 == h.new_count) ? 'd' : 'c';
+      if (fprintf_failed(fprintf(out, "%s%c%s\n",
+				 normal_range(h.old_start, h.old_count).c_str(),
+				 cmd,
+				 normal_range(h.new_start, h.new_count).c_str())))
+	return cssc::make_failure_from_errno(errno);
+
+      cssc::Failure written = write_diff_lines(out, "< ", old_lines,
+					       h.old_start, h.old_count);
+      if (!written.ok())
+	return written;
+      if ('c' == cmd && fputs_failed(fputs("---\n", out)))
+	return cssc::make_failure_from_errno(errno);
+      written = write_diff_lines(out, "> ", new_lines,
+				 h.new_start, h.new_count);
+      if (!written.ok())
+	return written;
+    }
+  return cssc::Failure::Ok();
+}
+
+cssc::Failure
+write_unified_diff(FILE *out,
+		   const std::string& old_label,
+		   const std::string& new_label,
+		   const line_list& old_lines,
+		   const line_list& new_lines,
+		   const std::vector<diff_hunk>& hunks,
+		   size_t context)
+{
+  if (hunks.empty())
+    return cssc::Failure::Ok();
+  if (fprintf_failed(fprintf(out, "--- %s\n+++ %s\n",
+			     old_label.c_str(), new_label.c_str())))
+    return cssc::make_failure_from_errno(errno);
+
+  size_t first = 0;
+  while (first < hunks.size())
+    {
+      // Changes separated by no more than twice the context are
+      // shown together.
+      size_t last = first;
+      while (last + 1u < hunks.size()
+	     && (hunks[last + 1u].old_start
+		 - (hunks[last].old_start + hunks[last].old_count)
+		 <= 2u * context))
+	{
+	  ++last;
+	}
+
+      const diff_hunk& fh = hunks[first];
+      const diff_hunk& lh = hunks[last];
+      const size_t lead = std::min(context, fh.old_start);
+      const size_t old_end = lh.old_start + lh.old_count;
+      const size_t trail = std::min(context, old_lines.size() - old_end);
+      const size_t old_lo = fh.old_start - lead;
+      const size_t new_lo = fh.new_start - lead;
+      const size_t old_len = old_end + trail - old_lo;
+      const size_t new_len = lh.new_start + lh.new_count + trail - new_lo;
+
+      if (fprintf_failed(fprintf(out, "@@ -%s +%s @@\n",
+				 unified_range(old_lo, old_len).c_str(),
+				 unified_range(new_lo, new_len).c_str())))
+	return cssc::make_failure_from_errno(errno);
+
+      size_t pos = old_lo;
+      for (size_t k = first; k <= last; ++k)
+	{
+	  const diff_hunk& h = hunks[k];
+	  cssc::Failure written =
+	    write_diff_lines(out, " ", old_lines, pos, h.old_start - pos);
+	  if (written.ok())
+	    written = write_diff_lines(out, "-", old_lines,
+				       h.old_start, h.old_count);
+	  if (written.ok())
+	    written = write_diff_lines(out, "+", new_lines,
+				       h.new_start, h.new_count);
+	  if (!written.ok())
+	    return written;
+	  pos = h.old_start + h.old_count;
+	}
+      cssc::Failure written = write_diff_lines(out, " ", old_lines, pos, trail);
+      if (!written.ok())
+	return written;
+      first = last + 1u;
+    }
+  return cssc::Failure::Ok();
+}
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
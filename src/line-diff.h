@@ -0,0 +1,105 @@
+/*
+ * line-diff.h: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * In-memory line-by-line comparison, used by delta instead of
+ * running an external diff program.
+ */
+#ifndef CSSC__LINE_DIFF_H__
+#define CSSC__LINE_DIFF_H__
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "failure.h"
+
+// A sequence of lines held in memory.  Every line is stored with a
+// terminating newline; if the last line of the input had none,
+// missing_final_newline() is true.  The stored lines are not
+// NUL-terminated, so they may contain NUL characters.
+//
+// While read_file() splits the text into lines, it also looks for
+// SCCS ID keywords, so that delta does not need to read the working
+// file a second time to check for them.
+class line_list
+{
+public:
+  line_list();
+
+  void append(const char *s, size_t len);
+  cssc::Failure read_file(FILE *f);
+
+  size_t size() const { return starts_.size() - 1u; }
+  const char *line(size_t i) const { return text_.data() + starts_[i]; }
+  // The length of line i, including its newline.
+  size_t length(size_t i) const { return starts_[i+1u] - starts_[i]; }
+
+  bool missing_final_newline() const { return missing_final_newline_; }
+  // True if the text read by read_file() contained an ID keyword.
+  bool has_id_keywords() const { return has_id_keywords_; }
+
+private:
+  std::string text_;
+  std::vector<size_t> starts_;
+  bool missing_final_newline_;
+  bool has_id_keywords_;
+};
+
+// A contiguous block of changed lines.  Line numbers are zero-based.
+// If old_count is zero, the hunk inserts new lines after the first
+// old_start lines of the old file; if new_count is zero, old lines
+// are deleted.
+struct diff_hunk
+{
+  size_t old_start;
+  size_t old_count;
+  size_t new_start;
+  size_t new_count;
+};
+
+// Compute a minimal set of hunks transforming old_lines into
+// new_lines, in order of increasing line number.
+std::vector<diff_hunk> diff_lines(const line_list& old_lines,
+				  const line_list& new_lines);
+
+// Write the hunks to |out| in the format used by diff(1) when it is
+// given no options.
+cssc::Failure write_normal_diff(FILE *out,
+				const line_list& old_lines,
+				const line_list& new_lines,
+				const std::vector<diff_hunk>& hunks);
+
+// Write the hunks to |out| in the unified format of "diff -u", with
+// |context| unchanged lines around each change.  The labels are used
+// in the "---" and "+++" header lines.
+cssc::Failure write_unified_diff(FILE *out,
+				 const std::string& old_label,
+				 const std::string& new_label,
+				 const line_list& old_lines,
+				 const line_list& new_lines,
+				 const std::vector<diff_hunk>& hunks,
+				 size_t context);
+
+#endif /* CSSC__LINE_DIFF_H__ */
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
@@ -27,9 +27,11 @@
 #include "config.h"
 
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
-#include <climits>
+#include <new>
 #include <system_error>
+#include <sys/types.h>
 
 #include "cssc.h"
 #include "bodyio.h"
@@ -39,57 +41,88 @@
 #include "ioerr.h"
 
 
-// Use a small chunk size for testing...
-#define CONFIG_LINEBUF_CHUNK_SIZE (1024u)
-
-cssc_linebuf::cssc_linebuf()
-  : buf_(new char[CONFIG_LINEBUF_CHUNK_SIZE]),
-    buflen_(CONFIG_LINEBUF_CHUNK_SIZE)
+namespace
 {
+  // The size of a new buffer.  Buffers grow as needed.
+  const size_t initial_buffer_size = 1024u;
+
+  // Buffers given up by cssc_linebuf objects, kept so that the next
+  // cssc_linebuf (for example the one reading the next SCCS file)
+  // starts with the capacity an earlier one has already grown to.
+  // The CSSC programs are single-threaded.  These are plain arrays
+  // so that they outlive any static cssc_linebuf.
+  const size_t max_spare_buffers = 4u;
+  char *spare_buf[max_spare_buffers];
+  size_t spare_len[max_spare_buffers];
+  size_t spare_count = 0u;
 }
 
 
-cssc::Failure
-cssc_linebuf::read_line(FILE *f)
+cssc_linebuf::cssc_linebuf()
+  : buf_(nullptr),
+    buflen_(0u),
+    len_(0u)
 {
-  ASSERT(CONFIG_LINEBUF_CHUNK_SIZE > 2u);
-  buf_[buflen_ - 2u] = '\0';
-
-  ASSERT(buflen_ < INT_MAX);
-  char *s = fgets(buf_, static_cast<int>(buflen_), f);
-  while (s != NULL)
+  if (spare_count)
     {
-      char c = buf_[buflen_ - 2u];
-      if (c == '\0' || c == '\n')
-	return cssc::Failure::Ok();
-
-//
-// Add another chunk
-//
+      --spare_count;
+      buf_ = spare_buf[spare_count];
+      buflen_ = spare_len[spare_count];
+    }
+  else
+    {
+      buf_ = static_cast<char*>(malloc(initial_buffer_size));
+      if (nullptr == buf_)
+	throw std::bad_alloc();
+      buflen_ = initial_buffer_size;
+    }
+  buf_[0] = '\0';
+}
 
-      char *temp_buf = new char[CONFIG_LINEBUF_CHUNK_SIZE + buflen_];
-      memcpy( temp_buf, buf_, buflen_);
-      delete [] buf_;
-      buf_ = temp_buf;
+cssc_linebuf::~cssc_linebuf()
+{
+  if (spare_count < max_spare_buffers)
+    {
+      spare_buf[spare_count] = buf_;
+      spare_len[spare_count] = buflen_;
+      ++spare_count;
+    }
+  else
+    {
+      free(buf_);
+    }
+  buf_ = nullptr;
+}
 
-      s = buf_ + buflen_ - 1u;
-      buflen_ += CONFIG_LINEBUF_CHUNK_SIZE;
-      buf_[buflen_ - 2u] = '\0';
 
-      s = fgets(s, CONFIG_LINEBUF_CHUNK_SIZE + 1u, f); // fill the new chunk
-    }
-  if (ferror(f))
+// getdelim() grows the buffer geometrically, so reading a very long
+// line takes time proportional to its length, and it tells us how
+// many bytes it read, so lines containing NUL bytes are read
+// correctly.
+cssc::Failure
+cssc_linebuf::read_line(FILE *f)
+{
+  const ssize_t n = getdelim(&buf_, &buflen_, '\n', f);
+  if (n < 0)
     {
-      return cssc::make_failure_from_errno(errno);
+      if (ferror(f))
+	return cssc::make_failure_from_errno(errno);
+      return cssc::make_failure(cssc::errorcode::UnexpectedEOF);
     }
-  return cssc::make_failure(cssc::errorcode::UnexpectedEOF);
+  len_ = static_cast<size_t>(n);
+  return cssc::Failure::Ok();
 }
 
 
 cssc::Failure cssc_linebuf::write(FILE *f) const
 {
-  size_t len = strlen(buf_);
-  return fwrite_failed(fwrite(buf_, sizeof(char), len, f), len);
+  return fwrite_failed(fwrite(buf_, sizeof(char), len_, f), len_);
+}
+
+void cssc_linebuf::truncate(size_t len)
+{
+  ASSERT(len <= len_);
+  buf_[len_ = len] = '\0';
 }
 
 int
@@ -125,7 +158,7 @@ set_char(unsigned offset, char value)
 
 bool cssc_linebuf::check_id_keywords() const
 {
-  return ::check_id_keywords(buf_, strlen(buf_));	// TODO: make NUL-safe!
+  return ::check_id_keywords(buf_, len_);
 }
 
 std::unique_ptr<cssc_linebuf> make_unique_linebuf()
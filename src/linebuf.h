@@ -39,8 +39,9 @@
 class cssc_linebuf
 {
   // TODO: use some STL data structure, or a Cord, to hold the data.
-  char *buf_;
+  char *buf_;			// allocated with malloc(), for getdelim().
   size_t buflen_;
+  size_t len_;			// length of the line in buf_.
 
 public:
   cssc_linebuf();
@@ -51,8 +52,17 @@ public:
   cssc_linebuf& operator=(const cssc_linebuf&) = delete;
   cssc_linebuf(const cssc_linebuf&) = delete;
 
+  // Reads a line, including its newline.  The line may contain NUL
+  // bytes; length() says where it ends.
   cssc::Failure read_line(FILE *f);
 
+  // The length of the line, not counting the terminating NUL which
+  // c_str() provides.
+  size_t length() const { return len_; }
+
+  // Shortens the line to LEN bytes (for example, to remove the newline).
+  void truncate(size_t len);
+
   // TODO: Reduce the use of c_str() in favour of operations that more
   // directly reflect what the program actually needs (perhaps for
   // example a string_view).
@@ -79,7 +89,8 @@ public:
   char *operator +(int index) const { return buf_ + index; }
 #endif
 
-  ~cssc_linebuf() { delete[] buf_; buf_ = nullptr; }
+  // The buffer is kept for reuse by the next cssc_linebuf.
+  ~cssc_linebuf();
 };
 
 std::unique_ptr<cssc_linebuf> make_unique_linebuf();
@@ -0,0 +1,64 @@
+/*
+ * lock-log.h: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Defines the class lock_log_record, which records how long we spent
+ * waiting for and holding locks.
+ */
+#ifndef CSSC__LOCK_LOG_H__
+#define CSSC__LOCK_LOG_H__
+
+#include <string>
+
+#include "cssc.h"
+#include "event-log.h"
+
+/* If the environment variable CSSC_LOCK_LOG names a file, each
+ * record is appended to it (see event-log.h), for example
+ *
+ *   {"time":1571234567.123456,"pid":1234,"program":"delta",
+ *    "event":"lock","file":"/src/SCCS/z.foo","attempts":3,"wait":1.502,
+ *    "holder":"1230"}
+ *
+ * The "file" member of the record is the absolute name of the z-file
+ * or p-file concerned, even if it was named by a relative path.
+ */
+class lock_log_record : public event_record
+{
+public:
+  lock_log_record(const char *event, const std::string& file)
+    : event_record(lock_log_file(), event)
+  {
+    add_file("file", file);
+  }
+
+  // Returns true if records are being logged.
+  static bool enabled()
+  {
+    const char *name = lock_log_file();
+    return name != nullptr && *name != '\0';
+  }
+};
+
+#endif /* CSSC__LOCK_LOG_H__ */
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
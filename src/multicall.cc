@@ -0,0 +1,113 @@
+/*
+ * multicall.cc: Part of GNU CSSC.
+ *
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ *
+ * Dispatches to the programs linked into the sccs driver in the
+ * multicall build.  This file is not part of libcssc.a, since only
+ * the multicall build provides the *_main functions it refers to.
+ */
+#include "config.h"
+
+#include <cstring>
+
+#include "cssc.h"
+#include "except.h"
+#include "multicall.h"
+#include "quit.h"
+#include "sfile-cache.h"
+
+namespace
+{
+  struct builtin_program
+  {
+    const char *name;
+    int (*main)(int argc, char **argv);
+    void (*usage)();
+  };
+
+  const builtin_program builtins[] =
+    {
+      { "admin", admin_main, admin_usage },
+      { "cdc",   cdc_main,   cdc_usage   },
+      { "comb",  comb_main,  comb_usage  },
+      { "delta", delta_main, delta_usage },
+      { "get",   get_main,   get_usage   },
+      { "prs",   prs_main,   prs_usage   },
+      { "prt",   prt_main,   prt_usage   },
+      { "rmdel", rmdel_main, rmdel_usage },
+      { "sccsdiff", sccsdiff_main, sccsdiff_usage },
+      { "sact",  sact_main,  sact_usage  },
+      { "unget", unget_main, unget_usage },
+      { "val",   val_main,   val_usage   },
+      { "what",  what_main,  what_usage  },
+    };
+
+  const builtin_program *current = NULL;
+}  // unnamed namespace
+
+
+// The option processor calls this when it sees an invalid option.
+void
+usage()
+{
+  if (current)
+    current->usage();
+}
+
+int
+cssc_run_builtin(const char *name, char *const argv[], int *status)
+{
+  for (const auto& prog : builtins)
+    {
+      if (0 != strcmp(prog.name, name))
+	continue;
+
+      int argc = 0;
+      while (argv[argc])
+	++argc;
+
+      current = &prog;
+      try
+	{
+	  // Our caller exits once the program has finished, so it
+	  // does not matter if the program changes argv.
+	  *status = prog.main(argc, const_cast<char**>(argv));
+	}
+      catch (CsscExitvalException& e)
+	{
+	  *status = e.exitval;
+	}
+      current = NULL;
+      return 1;
+    }
+  return 0;
+}
+
+void
+cssc_prime_sfile(const char *name)
+{
+  sfile_header_cache::prime(name);
+}
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
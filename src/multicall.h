@@ -0,0 +1,80 @@
+/*
+ * multicall.h: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The entry points of the CSSC programs.  Normally each program is
+ * linked on its own, but with --enable-multicall they are also linked
+ * into the sccs driver, which then runs them without executing a
+ * separate program.  This header is included by sccs.c, so the part
+ * outside __cplusplus must remain valid C.
+ */
+#ifndef CSSC__MULTICALL_H__
+#define CSSC__MULTICALL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* If NAME is one of the programs linked into this executable, run it
+ * with the null-terminated argument list ARGV, store its exit status
+ * in *STATUS and return nonzero.  Otherwise, return zero.
+ */
+int cssc_run_builtin(const char *name, char *const argv[], int *status);
+
+/* Read the SCCS file NAME into the cache of parsed files, if it is
+ * not already there.  The cache is inherited by child processes, so
+ * "sccs batch" calls this before running each command.
+ */
+void cssc_prime_sfile(const char *name);
+
+#ifdef __cplusplus
+}
+
+int admin_main(int argc, char **argv);
+int cdc_main(int argc, char **argv);
+int comb_main(int argc, char **argv);
+int delta_main(int argc, char **argv);
+int get_main(int argc, char **argv);
+int prs_main(int argc, char **argv);
+int prt_main(int argc, char **argv);
+int rmdel_main(int argc, char **argv);
+int sccsdiff_main(int argc, char **argv);
+int sact_main(int argc, char **argv);
+int unget_main(int argc, char **argv);
+int val_main(int argc, char **argv);
+int what_main(int argc, char **argv);
+
+void admin_usage();
+void cdc_usage();
+void comb_usage();
+void delta_usage();
+void get_usage();
+void prs_usage();
+void prt_usage();
+void rmdel_usage();
+void sccsdiff_usage();
+void sact_usage();
+void unget_usage();
+void val_usage();
+void what_usage();
+#endif
+
+#endif /* CSSC__MULTICALL_H__ */
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
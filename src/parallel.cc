@@ -0,0 +1,318 @@
+/*
+ * parallel.cc: Part of GNU CSSC.
+ *
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ *
+ * Members of the class parallel_jobs.
+ *
+ */
+#include "config.h"
+
+#include <cstdio>
+#include <errno.h>
+
+#include "cssc.h"
+#include "cleanup.h"
+#include "fileiter.h"
+#include "parallel.h"
+#include "quit.h"
+#include "sysdep.h"
+
+namespace
+{
+  // Each running job may be followed by this many others whose
+  // output is waiting to be written out.  This limits the number of
+  // temporary files we have open when one file takes much longer
+  // than the others.
+  const size_t window_factor = 4;
+
+  void copy_captured(FILE *from, FILE *to)
+  {
+    char buf[BUFSIZ];
+    size_t n;
+
+    rewind(from);
+    while ((n = fread(buf, 1, sizeof(buf), from)) > 0)
+      {
+	if (fwrite(buf, 1, n, to) != n)
+	  break;
+      }
+    fflush(to);
+  }
+
+  bool same_file(int fd1, int fd2)
+  {
+#ifdef HAVE_FSTAT
+    struct stat st1, st2;
+    if (fstat(fd1, &st1) != 0 || fstat(fd2, &st2) != 0)
+      return false;
+    return st1.st_dev == st2.st_dev && st1.st_ino == st2.st_ino;
+#else
+    (void) fd1;
+    (void) fd2;
+    return false;
+#endif
+  }
+}  // unnamed namespace
+
+
+parallel_jobs::parallel_jobs(int max_jobs)
+  : max_jobs_(max_jobs),
+    started_(false),
+    in_child_(false),
+    combined_output_(false),
+    jobs_()
+{
+#ifndef HAVE_FORK
+  max_jobs_ = 1;
+#endif
+  if (max_jobs_ > 1)
+    {
+      // If stdout and stderr go to the same place, capture them
+      // together so that their relative order is kept.
+      combined_output_ = same_file(fileno(stdout), fileno(stderr));
+    }
+}
+
+parallel_jobs::~parallel_jobs()
+{
+  if (!in_child_)
+    {
+      int ignored = 0;
+      finish_all(ignored);
+    }
+}
+
+size_t
+parallel_jobs::running() const
+{
+  size_t n = 0;
+  for (const auto& j : jobs_)
+    {
+      if (!j.finished)
+	++n;
+    }
+  return n;
+}
+
+bool
+parallel_jobs::next(sccs_file_iterator& iter, int& retval)
+{
+  return next(iter, retval, skip_predicate());
+}
+
+// Advances ITER to the next file which SKIP does not reject.
+bool
+parallel_jobs::next_wanted(sccs_file_iterator& iter,
+			   const skip_predicate& skip)
+{
+  while (iter.next())
+    {
+      if (!skip || !skip(iter.get_name().c_str()))
+	return true;
+    }
+  return false;
+}
+
+bool
+parallel_jobs::next(sccs_file_iterator& iter, int& retval,
+		    const skip_predicate& skip)
+{
+  if (in_child_)
+    {
+      // This child process has finished with its file.  Release
+      // anything (such as lock files) that would otherwise have been
+      // cleaned up by the Cleaner in main().
+      cleanup::run_cleanups();
+      fflush(stdout);
+      fflush(stderr);
+      _exit(retval);
+    }
+
+  if (max_jobs_ <= 1 || !started_)
+    {
+      started_ = true;
+      return next_wanted(iter, skip);
+    }
+
+  while (next_wanted(iter, skip))
+    {
+      if (start(iter.get_name().c_str(), retval))
+	{
+	  // Either we are the child process, or we could not start
+	  // one and so the caller must process this file itself.
+	  return true;
+	}
+    }
+  finish_all(retval);
+  return false;
+}
+
+// Returns true if the caller should process the current file
+// (because we are the child process), or false if a child process
+// has been started to do it.
+bool
+parallel_jobs::start(const std::string& name, int& retval)
+{
+#ifdef HAVE_FORK
+  while (running() >= static_cast<size_t>(max_jobs_)
+	 || jobs_.size() >= window_factor * max_jobs_)
+    {
+      wait_for_one();
+      write_finished(retval);
+    }
+
+  FILE *out = tmpfile();
+  FILE *err = (out && !combined_output_) ? tmpfile() : NULL;
+  if (NULL == out || (!combined_output_ && NULL == err))
+    {
+      errormsg_with_errno("Cannot create a temporary file, "
+			  "processing %s in this process", name.c_str());
+      if (out)
+	fclose(out);
+      finish_all(retval);
+      return true;
+    }
+
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid < 0)
+    {
+      errormsg_with_errno("fork() failed, processing %s in this process",
+			  name.c_str());
+      fclose(out);
+      if (err)
+	fclose(err);
+      finish_all(retval);
+      return true;
+    }
+
+  if (0 == pid)
+    {
+      in_child_ = true;
+      for (const auto& j : jobs_)
+	{
+	  fclose(j.out);
+	  if (j.err)
+	    fclose(j.err);
+	}
+      jobs_.clear();
+
+      // Prompting (which only happens for the first file) is done
+      // by the parent, so the children do not need stdin.
+      FILE *devnull = fopen("/dev/null", "r");
+      if (devnull)
+	{
+	  dup2(fileno(devnull), fileno(stdin));
+	  fclose(devnull);
+	}
+
+      dup2(fileno(out), fileno(stdout));
+      dup2(fileno(err ? err : out), fileno(stderr));
+      fclose(out);
+      if (err)
+	fclose(err);
+      if (combined_output_)
+	setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+      retval = 0;
+      return true;
+    }
+
+  jobs_.push_back(job{pid, name, out, err, false, 0});
+  return false;
+#else
+  (void) name;
+  (void) retval;
+  return true;
+#endif
+}
+
+void
+parallel_jobs::wait_for_one()
+{
+#ifdef HAVE_FORK
+  int status;
+  pid_t pid = wait(&status);
+  if (pid < 0)
+    {
+      if (EINTR == errno)
+	return;
+      fatal_quit(errno, "wait() failed.");
+    }
+  for (auto& j : jobs_)
+    {
+      if (j.pid == pid)
+	{
+	  j.finished = true;
+	  j.status = status;
+	  return;
+	}
+    }
+#endif
+}
+
+void
+parallel_jobs::write_finished(int& retval)
+{
+  while (!jobs_.empty() && jobs_.front().finished)
+    {
+      job& j = jobs_.front();
+      copy_captured(j.out, stdout);
+      fclose(j.out);
+      if (j.err)
+	{
+	  copy_captured(j.err, stderr);
+	  fclose(j.err);
+	}
+
+      int exitval;
+      if (WIFEXITED(j.status))
+	{
+	  exitval = WEXITSTATUS(j.status);
+	}
+      else
+	{
+	  errormsg("%s: processing was terminated by signal %d",
+		   j.name.c_str(),
+		   WIFSIGNALED(j.status) ? WTERMSIG(j.status) : 0);
+	  exitval = 1;
+	}
+      if (exitval > retval)
+	retval = exitval;
+      jobs_.pop_front();
+    }
+}
+
+void
+parallel_jobs::finish_all(int& retval)
+{
+  while (!jobs_.empty())
+    {
+      if (!jobs_.front().finished)
+	wait_for_one();
+      write_finished(retval);
+    }
+}
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
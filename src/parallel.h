@@ -0,0 +1,104 @@
+/*
+ * parallel.h: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Defines the class parallel_jobs, which processes the SCCS files
+ * named on the command line in several processes at once (the -j
+ * option).
+ */
+#ifndef CSSC__PARALLEL_H__
+#define CSSC__PARALLEL_H__
+
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+
+class sccs_file_iterator;
+
+/* A tool's main loop normally looks like this:
+ *
+ *    while (iter.next())
+ *      {
+ *        ...process iter.get_name(), updating retval...
+ *      }
+ *
+ * To process the files in parallel, replace the loop condition with
+ * jobs.next(iter, retval).  Each file after the first is then
+ * processed by a child process.  The output of each child is held
+ * back until the output for all the files before it has been
+ * written, so the output is the same as that of a serial run.  The
+ * exit status of each child is merged into retval by taking the
+ * maximum, as the tools themselves do for CsscExitvalException.
+ *
+ * The first file is always processed by the calling process, so that
+ * any prompting for comments or MRs happens once, just as it would
+ * without the -j option.
+ *
+ * If SKIP is given, files for which it returns true are passed over
+ * without starting a process for them.  It is always called in the
+ * calling process, so it can keep count of what it does.
+ */
+class parallel_jobs
+{
+public:
+  explicit parallel_jobs(int max_jobs);
+  ~parallel_jobs();
+
+  typedef std::function<bool(const std::string&)> skip_predicate;
+
+  bool next(sccs_file_iterator& iter, int& retval);
+  bool next(sccs_file_iterator& iter, int& retval,
+	    const skip_predicate& skip);
+
+private:
+  struct job
+  {
+    pid_t pid;
+    std::string name;
+    FILE *out;			// captured stdout
+    FILE *err;			// captured stderr (NULL if same as out)
+    bool finished;
+    int status;			// as returned by wait()
+  };
+
+  bool next_wanted(sccs_file_iterator& iter, const skip_predicate& skip);
+  bool start(const std::string& name, int& retval);
+  void wait_for_one();
+  void write_finished(int& retval);
+  void finish_all(int& retval);
+  size_t running() const;
+
+  int max_jobs_;
+  bool started_;
+  bool in_child_;
+  bool combined_output_;
+  std::deque<job> jobs_;
+
+  parallel_jobs(const parallel_jobs&) = delete;
+  parallel_jobs& operator=(const parallel_jobs&) = delete;
+};
+
+#endif /* CSSC__PARALLEL_H__ */
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
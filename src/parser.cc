@@ -38,6 +38,8 @@
 #include "file.h"
 #include "linebuf.h"
 #include "quit.h"
+#include "sfile-cache.h"
+#include "trace.h"
 
 namespace
 {
@@ -120,13 +122,24 @@ sccs_file_parser::open_sccs_file(const std::string& name,
 				 sccs_file_open_mode mode,
 				 ParserOptions opts)
 {
-  auto failure_or_file = do_open_sccs_file(name.c_str(), mode, opts);
-  if (!failure_or_file.ok() )
+  FILE *f;
+  {
+    trace_phase phase("open", name);
+    auto failure_or_file = do_open_sccs_file(name.c_str(), mode, opts);
+    if (!failure_or_file.ok() )
+      {
+	return failure_or_file.fail();
+      }
+    f = *failure_or_file;
+  }
+  ASSERT(f != NULL);
+
+  if (sfile_header_cache::enabled())
     {
-      return failure_or_file.fail();
+      auto cached = sfile_header_cache::lookup(name, f);
+      if (cached)
+	return cached;
     }
-  FILE * f = *failure_or_file;
-  ASSERT(f != NULL);
 
   auto p = make_unique_sccs_file_parser(name, mode, f);
   // TODO: having an f_ member in a base class and passing in the same
@@ -134,6 +147,10 @@ sccs_file_parser::open_sccs_file(const std::string& name,
   auto open_result = p->parse_header(f, opts);
   if (open_result)
     {
+      // A result without a computed checksum must not be handed to
+      // a later command which expects one.
+      if (sfile_header_cache::enabled() && !opts.defer_checksum())
+	sfile_header_cache::store(f, *open_result);
       open_result->parser = std::move(p);
     }
   return open_result;
@@ -523,10 +540,14 @@ sccs_file_parser::parse_header(FILE *f_local, ParserOptions opts)
 
   int sum = 0u;
   /* Read the whole file and compute the checksum. */
+  if (!opts.defer_checksum())
   {
+    trace_phase phase("checksum", this->name());
     int c;
     while ((c=getc(f_local)) != EOF)
       sum += static_cast<char>(c);    // Yes, I mean plain char, not signed, not unsigned.
+    if (phase.active())
+      phase.count("bytes_read", static_cast<unsigned long>(ftell(f_local)));
 
     if (ferror(f_local))
       {
@@ -559,6 +580,7 @@ sccs_file_parser::parse_header(FILE *f_local, ParserOptions opts)
     }
 #endif
 
+  trace_phase header_phase("header", this->name());
   std::unique_ptr<open_result> result = make_unique_open_result();
   result->computed_sum = sum & 0xFFFFu;
   result->is_bk = is_bk;
@@ -630,8 +652,10 @@ sccs_file_parser::parse_header(FILE *f_local, ParserOptions opts)
 	}
 
       given_sum &= 0xFFFFu;
-      result->checksum_valid_ = (result->stored_sum == result->computed_sum);
-      if (!result->checksum_valid_ && !opts.silent_checksum_error())
+      result->checksum_valid_ = !opts.defer_checksum()
+	&& (result->stored_sum == result->computed_sum);
+      if (!result->checksum_valid_ && !opts.silent_checksum_error()
+	  && !opts.defer_checksum())
 	{
 	  warning("%s: bad checksum "
 		  "(expected=%d, calculated %d).\n",
@@ -740,6 +764,10 @@ sccs_file_parser::parse_header(FILE *f_local, ParserOptions opts)
       errormsg_with_errno("ftell() failed.");
       return nullptr;
     }
+  result->body_offset = body_offset;
+  result->body_line_number = here().line_number();
+  header_phase.count("deltas",
+		     result->delta_table ? result->delta_table->size() : 0u);
   // The body scanner takes ownership of f_local.
   result->body_scanner =
     make_unique_sccs_file_body_scanner(this->name(), f_local,
@@ -56,7 +56,8 @@ class ParserOptions
 {
 public:
   explicit ParserOptions()
-  : silent_checksum_error_(false)
+  : silent_checksum_error_(false),
+    defer_checksum_(false)
   {
   }
 
@@ -73,8 +74,23 @@ public:
     return silent_checksum_error_;
   }
 
+  // Do not read the whole file to compute its checksum when opening
+  // it; the caller will check the checksum itself (as val -b does,
+  // while reading the body).  checksum_valid_ is then false.
+  ParserOptions& set_defer_checksum(bool state)
+  {
+    defer_checksum_ = state;
+    return *this;
+  }
+
+  bool defer_checksum() const
+  {
+    return defer_checksum_;
+  }
+
 private:
   bool silent_checksum_error_;
+  bool defer_checksum_;
 };
 
 
@@ -107,6 +123,8 @@ public:
     std::vector<parsed_flag> flags;
     std::vector<std::string> comments;
     std::unique_ptr<sccs_file_body_scanner> body_scanner;
+    long body_offset;		// where the body starts,
+    long body_line_number;	// and its line number.
 
     open_result()
       : parser(),
@@ -119,7 +137,9 @@ public:
 	users(),
 	flags(),
 	comments(),
-	body_scanner()
+	body_scanner(),
+	body_offset(0L),
+	body_line_number(0L)
     {
     }
   };
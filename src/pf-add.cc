@@ -35,7 +35,8 @@
 cssc::Failure
 sccs_pfile::add_lock(sid got, sid delta,
 		     sid_list &included, sid_list &excluded) {
-        ASSERT(pmode_ == pfile_mode::PFILE_APPEND);
+        // "delta -e" adds a lock to the p-file it has just updated.
+        ASSERT(pmode_ != pfile_mode::PFILE_READ);
 	struct edit_lock new_lock;
 	bool pfile_already_exists;
 
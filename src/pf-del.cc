@@ -27,13 +27,17 @@
  */
 #include "config.h"
 
+#include <chrono>
 #include <string>
 #include <utility>
 
 #include "cssc.h"
 #include "pfile.h"
+#include "cleanup.h"
+#include "edit-registry.h"
 #include "except.h"
 #include "file.h"
+#include "lock-log.h"
 
 
 std::pair<sccs_pfile::find_status, sccs_pfile::iterator>
@@ -134,6 +138,22 @@ sccs_pfile::update(bool pfile_already_exists) const
 {
   const std::string q_name(name_.qfile());
 
+  // Record the time taken to rewrite the p-file in the lock log.
+  const auto start = std::chrono::steady_clock::now();
+  long locks_written = -1;	// unchanged if we fail.
+  ResourceCleanup logger([this, start, &locks_written]() {
+      if (!lock_log_record::enabled())
+	return;
+      const std::chrono::duration<double> taken =
+	std::chrono::steady_clock::now() - start;
+      lock_log_record record(locks_written < 0 ? "pfile-update-failed"
+			     : "pfile-update", pname_);
+      record.add("duration", taken.count());
+      if (locks_written >= 0)
+	record.add("locks", locks_written);
+      record.write();
+    });
+
   cssc::FailureOr<FILE*> fof = fcreate(q_name.c_str(), CREATE_EXCLUSIVE);
   if (!fof.ok())
     {
@@ -199,8 +219,34 @@ sccs_pfile::update(bool pfile_already_exists) const
   auto rewrite_result = rewrite();
   if (!rewrite_result.ok())
     return rewrite_result;
-  else
-    return qfile_deletion_result;
+  if (qfile_deletion_result.ok())
+    {
+      locks_written = static_cast<long>(edit_locks.size());
+
+      // We still hold the lock on the SCCS file, so the lines for
+      // this file appear in the registry in the same order as the
+      // changes to its p-file.  The p-file is what counts, so a
+      // failure here, which the registry has already reported, does
+      // not stop us.
+      (void) register_edit_locks();
+    }
+  return qfile_deletion_result;
+}
+
+// Records the edit locks in the registry, if there is one.
+cssc::Failure
+sccs_pfile::register_edit_locks() const
+{
+  if (!edit_registry::enabled())
+    return cssc::Failure::Ok();
+  std::vector<edit_registry::lock> locks;
+  for (const auto& it : edit_locks)
+    {
+      locks.push_back(edit_registry::lock{it.got.as_string(),
+					  it.delta.as_string(),
+					  it.user, it.date.as_string()});
+    }
+  return edit_registry::record(name_.sfile(), locks);
 }
 
 /* Local variables: */
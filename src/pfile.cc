@@ -71,8 +71,7 @@ sccs_pfile::sccs_pfile(sccs_name &n, pfile_mode m)
                 int lineno = 0;
                 while (linebuf.read_line(pf).ok()) {
                   // chomp the newline
-                  // TODO: make me 8-bit clean!
-                  linebuf[strlen(linebuf.c_str()) - 1] = '\0';
+                  linebuf.truncate(linebuf.length() - 1u);
                         lineno++;
 
                         char *args[7];
@@ -165,6 +165,10 @@ public:
 
   cssc::Failure update(bool pfile_already_exists) const;
 
+  // Records the edit locks in the registry (see edit-registry.h),
+  // if there is one.  update() does this itself.
+  cssc::Failure register_edit_locks() const;
+
   ~sccs_pfile();
 };
 
@@ -30,22 +30,24 @@
 #include "cssc.h"
 #include "failure.h"
 #include "fileiter.h"
+#include "parallel.h"
 #include "sccsfile.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "version.h"
 #include "delta.h"
 #include "except.h"
 
 
 void
-usage() {
+prs_usage() {
 	fprintf(stderr,
 "usage: %s [-aelDRV] [-c cutoff] [-d format] [-r SID] file ...\n",
 		prg_name);
 }
 
 int
-main(int argc, char **argv)
+prs_main(int argc, char **argv)
 {
   Cleaner arbitrary_name;
   int c;
@@ -55,6 +57,7 @@ main(int argc, char **argv)
   delta_selector selector = delta_selector::current; // -a
   sccs_date cutoff_date;
   int default_processing = 1;
+  int max_jobs = 1;		// -j
 
   if (argc > 0)
     set_prg_name(argv[0]);
@@ -63,7 +66,7 @@ main(int argc, char **argv)
 
   ASSERT(!rid.valid());
 
-  CSSC_Options opts(argc, argv, "d!Dr!elc!aV");
+  CSSC_Options opts(argc, argv, "d!Dr!elc!aVj!");
   for(c = opts.next();
       c != CSSC_Options::END_OF_ARGUMENTS;
       c = opts.next())
@@ -125,6 +128,15 @@ main(int argc, char **argv)
 	  selector = delta_selector::all;
 	  break;
 
+	case 'j':
+	  max_jobs = atoi(opts.getarg());
+	  if (max_jobs < 1)
+	    {
+	      errormsg("Invalid number of jobs: '%s'", opts.getarg());
+	      return 2;
+	    }
+	  break;
+
 	case 'V':
 	  version();
 	  break;
@@ -153,7 +165,8 @@ main(int argc, char **argv)
 
   int retval = 0;
 
-  while (iter.next())
+  parallel_jobs jobs(max_jobs);
+  while (jobs.next(iter, retval))
     {
       try
 	{
@@ -195,6 +208,21 @@ main(int argc, char **argv)
   return retval;
 }
 
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  prs_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return prs_main(argc, argv);
+}
+#endif
+
 /* Local variables: */
 /* mode: c++ */
 /* End: */
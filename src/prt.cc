@@ -32,13 +32,14 @@
 #include "fileiter.h"
 #include "sccsfile.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "version.h"
 #include "delta.h"
 #include "except.h"
 
 
 void
-usage()
+prt_usage()
 {
   fprintf(stderr,
 	  "usage: %s %s", prg_name,
@@ -51,7 +52,7 @@ usage()
  * example, -y affects the output mode as well.
  */
 int
-main(int argc, char **argv)
+prt_main(int argc, char **argv)
 {
   Cleaner arbitrary_name;
   delta_selector selector = delta_selector::current; // -a
@@ -218,6 +219,20 @@ main(int argc, char **argv)
   return retval;
 }
 
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  prt_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return prt_main(argc, argv);
+}
+#endif
 
 /* Local variables: */
 /* mode: c++ */
@@ -32,6 +32,7 @@
 #include "sccsfile.h"
 #include "pfile.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "version.h"
 #include "delta.h"
 #include "except.h"
@@ -40,7 +41,7 @@
 
 
 void
-usage() {
+rmdel_usage() {
 	fprintf(stderr,
 "usage: %s [-V] -r SID file ...\n",
 		prg_name);
@@ -63,7 +64,7 @@ is_locked(sccs_name& name, sid rid)
 
 
 int
-main(int argc, char **argv)
+rmdel_main(int argc, char **argv)
 {
   Cleaner arbitrary_name;
   int c;
@@ -141,6 +142,21 @@ main(int argc, char **argv)
   return retval;
 }
 
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  rmdel_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return rmdel_main(argc, argv);
+}
+#endif
+
 /* Local variables: */
 /* mode: c++ */
 /* End: */
@@ -27,22 +27,87 @@
  */
 
 #include <config.h>
+
+#include <string>
+#include <vector>
+
 #include "cssc.h"
+#include "edit-registry.h"
 #include "fileiter.h"
+#include "parallel.h"
 #include "pfile.h"
 #include "version.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "except.h"
 
 void
-usage() {
+sact_usage() {
 	fprintf(stderr,
-"usage: %s [-V] file ...\n",
-		prg_name);
+"usage: %s [-UV] [-uuser] file ...\n"
+"       %s -R [-uuser] [file-or-directory ...]\n",
+		prg_name, prg_name);
 }
 
+namespace
+{
+  // Returns true if the SCCS file SFILE is one of PATHS, or is under
+  // one of them, or if PATHS is empty.
+  bool
+  wanted(const std::string& sfile, const std::vector<std::string>& paths)
+  {
+    if (paths.empty())
+      return true;
+    for (const auto& path : paths)
+      {
+	if (sfile == path
+	    || (sfile.compare(0, path.size(), path) == 0
+		&& (path == "/" || sfile[path.size()] == '/')))
+	  return true;
+      }
+    return false;
+  }
+
+  // Lists the edit locks in the registry on the files named in PATHS
+  // (or on every file) held by USER (or by anybody).
+  int
+  list_registered_edits(const char *user, const std::vector<std::string>& paths)
+  {
+    cssc::FailureOr<edit_registry::contents> got = edit_registry::read();
+    if (!got.ok())
+      {
+	errormsg("%s", got.to_string().c_str());
+	return 1;
+      }
+
+    std::vector<std::string> canonical_paths;
+    for (const auto& path : paths)
+      canonical_paths.push_back(edit_registry::canonical_name(path));
+
+    for (const auto& entry : *got)
+      {
+	if (!wanted(entry.first, canonical_paths))
+	  continue;
+	bool first = true;
+	for (const auto& lock : entry.second)
+	  {
+	    if (user && lock.user != user)
+	      continue;
+	    if (first)
+	      {
+		printf("\n%s:\n", entry.first.c_str());
+		first = false;
+	      }
+	    printf("%s %s %s %s\n", lock.got.c_str(), lock.delta.c_str(),
+		   lock.user.c_str(), lock.date.c_str());
+	  }
+      }
+    return 0;
+  }
+}  // unnamed namespace
+
 int
-main(int argc, char **argv)
+sact_main(int argc, char **argv)
 {
   Cleaner arbitrary_name;
   if (argc > 0)
@@ -51,8 +116,12 @@ main(int argc, char **argv)
     set_prg_name("sact");
 
 
-  class CSSC_Options opts(argc, argv, "V");
+  class CSSC_Options opts(argc, argv, "RUVj!u!");
   int c;
+  int max_jobs = 1;		/* -j */
+  bool from_registry = false;	/* -R */
+  bool to_registry = false;	/* -U */
+  const char *user = NULL;	/* -u */
   for (c = opts.next(); c != CSSC_Options::END_OF_ARGUMENTS; c = opts.next())
     {
       switch (c)
@@ -60,9 +129,44 @@ main(int argc, char **argv)
 	case 'V':
 	  version();
 	  break;
+
+	case 'R':
+	  from_registry = true;
+	  break;
+
+	case 'U':
+	  to_registry = true;
+	  break;
+
+	case 'u':
+	  user = opts.getarg();
+	  break;
+
+	case 'j':
+	  max_jobs = atoi(opts.getarg());
+	  if (max_jobs < 1)
+	    {
+	      errormsg("Invalid number of jobs: '%s'", opts.getarg());
+	      return 1;
+	    }
+	  break;
 	}
     }
 
+  if ((from_registry || to_registry) && !edit_registry::enabled())
+    {
+      errormsg("The -%c option needs CSSC_EDIT_REGISTRY to name "
+	       "the registry of edit locks.", from_registry ? 'R' : 'U');
+      return 1;
+    }
+  if (from_registry)
+    {
+      std::vector<std::string> paths;
+      for (int i = opts.get_index(); i < opts.get_argc(); ++i)
+	paths.push_back(opts.get_argv()[i]);
+      return list_registered_edits(user, paths);
+    }
+
   int retval = 0;
   sccs_file_iterator iter(opts);
   if (iter.empty())
@@ -71,19 +175,32 @@ main(int argc, char **argv)
       return 1;
     }
 
-  while (iter.next())
+  parallel_jobs jobs(max_jobs);
+  while (jobs.next(iter, retval))
     {
       try
 	{
 	  sccs_name &name = iter.get_name();
-	  sccs_pfile pfile(name, sccs_pfile::pfile_mode::PFILE_READ);
-
+	  // With -U we hold the lock on the SCCS file, as get -e, delta
+	  // and unget do while they change the p-file and registry, so
+	  // that we cannot register locks which have just changed.
+	  sccs_pfile pfile(name, to_registry
+			   ? sccs_pfile::pfile_mode::PFILE_UPDATE
+			   : sccs_pfile::pfile_mode::PFILE_READ);
+	  if (to_registry)
+	    {
+	      // The registry has already said what went wrong.
+	      if (!pfile.register_edit_locks().ok())
+		retval = 1;
+	    }
 
 	  bool first = true;
 	  for (sccs_pfile::const_iterator it = pfile.begin();
 	       it != pfile.end();
 	       ++it)
 	    {
+	      if (user && it->user != user)
+		continue;
 	      if (first) // first lock on this file...
 		{
 		  /*
@@ -120,6 +237,21 @@ main(int argc, char **argv)
   return retval;
 }
 
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  sact_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return sact_main(argc, argv);
+}
+#endif
+
 /* Local variables: */
 /* mode: c++ */
 /* End: */
@@ -53,6 +53,7 @@ static const char filever[] = "$Id: sccs.c,v 1.44 2007/12/19 00:21:14 jay Exp $"
 #include <sys/wait.h>
 #include <sys/param.h>          /* TODO: this does what? */
 #include <sys/stat.h>
+#include <fcntl.h>              /* open() */
 #include <signal.h>             /* TODO: consider using sigaction(). */
 #include <errno.h>              /* TODO: same as in parent directory. */
 #include <pwd.h>                /* getpwuid() */
@@ -68,6 +69,9 @@ static const char filever[] = "$Id: sccs.c,v 1.44 2007/12/19 00:21:14 jay Exp $"
 
 #include "dirent-safer.h"
 #include "progname.h"
+#ifdef CSSC_MULTICALL
+#include "multicall.h"
+#endif
 
 #ifndef _PATH_BSHELL
 #define _PATH_BSHELL "/bin/sh"
@@ -204,8 +208,10 @@ static const char filever[] = "$Id: sccs.c,v 1.44 2007/12/19 00:21:14 jay Exp $"
    **           edit            Macro for "get -e".
    **           unedit          Removes a file being edited, knowing
    **                           about p-files, etc.
-   **           delget          Macro for "delta" followed by "get".
-   **           deledit         Macro for "delta" followed by "get -e".
+   **           delget          Macro for "delta" followed by "get"
+   **                           (just "delta -o" where possible).
+   **           deledit         Macro for "delta" followed by "get -e"
+   **                           (just "delta -e" where possible).
    **           branch          Macro for "get -b -e", followed by "delta
    **                           -s -n", followd by "get -e -t -g".
    **           diffs           "diff" the specified version of files
@@ -219,6 +225,8 @@ static const char filever[] = "$Id: sccs.c,v 1.44 2007/12/19 00:21:14 jay Exp $"
    **                           use in makefiles.
    **           fix             Remove a top delta & reedit, but save
    **                           the previous changes in that delta.
+   **           batch           Read commands from a file (or stdin),
+   **                           one per line, and run each of them.
    **
    **   Compilation Flags:
    **           SCCSDIR -- if defined, forces the -d flag to take on
@@ -279,7 +287,7 @@ struct sccsprog
     short sccsoper;             /* opcode, see below */
     short sccsflags;            /* flags, see below */
     const char *sccspath;       /* pathname of binary implementing */
-    int   clean_mode;           /* mode for do_clean(). */
+    int   clean_mode;           /* mode for clean(). */
   };
 
 /* values for sccsoper */
@@ -294,6 +302,7 @@ struct sccsprog
 #define DIFFS           6       /* diff between sccs & file out */
 #define DODIFF          7       /* internal call to diff program */
 #define ENTER           8       /* enter new files */
+#define BATCH           9       /* run commands read from a file */
 
 /* bits for sccsflags */
 #define NO_SDOT 0001            /* no s. on front of args */
@@ -320,7 +329,7 @@ const struct sccsprog SccsProg[] =
 {
   {"admin", PROG, REALUSER, _PATH_SCCSADMIN, 0 },
   {"cdc", PROG, 0, _PATH_SCCSCDC, 0 },
-  {"comb", PROG, WARN_MISSING, _PATH_SCCSCOMB, 0 },
+  {"comb", PROG, REALUSER, _PATH_SCCSCOMB, 0 },
   {"delta", PROG, 0, _PATH_SCCSDELTA, 0 },
   {"get", PROG, 0, _PATH_SCCSGET, 0 },
   {"unget", PROG, 0, _PATH_SCCSUNGET, 0 },
@@ -346,9 +355,34 @@ const struct sccsprog SccsProg[] =
   {"branch", CMACRO, NO_SDOT, "get:ixrc -e -b/delta: -s -n -ybranch-place-holder/get:pl -e -t -g", 0 },
   {"enter", ENTER, NO_SDOT, NULL, 0 },
   {"create", CMACRO, NO_SDOT, "enter/get:ixeskcl -t", 0 },
+  {"batch", BATCH, NO_SDOT, NULL, 0 },
   {NULL, -1, 0, NULL, 0 },
 };
 
+/*
+   **  Macros which a single program can carry out by itself.  The
+   **   delget and deledit macros run delta and then get, which has
+   **   to read the SCCS file that delta has just written all over
+   **   again; "delta -o" and "delta -e" do the same job in one
+   **   pass.  The fused command is used only if every option given
+   **   is one of those listed, which are the ones that the macro
+   **   passes to delta.
+ */
+
+struct fusedmacro
+  {
+    const char *sccsname;       /* name of the macro */
+    const char *options;        /* options the fused command accepts */
+    const char *command;        /* the fused command */
+  };
+
+const struct fusedmacro FusedMacros[] =
+{
+  {"delget", "mysrp", "delta:mysrp -o" },
+  {"deledit", "mysrp", "delta:mysrp -e" },
+  {NULL, NULL, NULL },
+};
+
 /* one line from a p-file */
 struct pfile
   {
@@ -388,6 +422,7 @@ void putpfent (register const struct pfile *pf, register FILE * f);
 bool safepath (register const char *p);
 bool isdir (const char *name);
 const struct sccsprog *lookup (const char *name);
+const char *fused_command (const char *name, char **argv);
 bool unedit (const char *fn);
 char *makefile (const char *name);
 const char *tail (register const char *fn);
@@ -403,11 +438,12 @@ static char *gstrcat (char *to, const char *from, size_t length);
 static char *gstrncat (char *to, const char *from, size_t n, size_t length);
 static char *gstrcpy (char *to, const char *from, size_t length);
 static void gstrbotch (const char *str1, const char *str2);
-static void  gstrbotchn (int avail, const char *, int, const char *, int);
 static int absolute_pathname (const char *);
 
 static char *str_dup (const char *);
 static void childwait(int pid, int *status_ptr, int ignoreintr);
+static int child_exit_status(int st, const char *name);
+static int do_batch(char *const argv[]);
 
 
 /* #define      FBUFSIZ BUFSIZ */
@@ -532,9 +568,11 @@ static void cleanup_environment(void)
 {
   const char * binary_support = "CSSC_BINARY_SUPPORT";
   const char * max_line_len   = "CSSC_MAX_LINE_LENGTH";
+  const char * edit_registry  = "CSSC_EDIT_REGISTRY";
 #ifdef HAVE_UNSETENV
   unsetenv(binary_support);
   unsetenv(max_line_len);
+  unsetenv(edit_registry);
 #else
 
   /* XXX: not ideal.  We'd like just to turn them off, but
@@ -543,6 +581,8 @@ static void cleanup_environment(void)
   pfail = getenv(binary_support);
   if (NULL == pfail)
     pfail = getenv(max_line_len);
+  if (NULL == pfail)
+    pfail = getenv(edit_registry);
 
   if (pfail)
     {
@@ -1103,6 +1143,13 @@ command (char *argv[], bool forkflag, const char *arg0)
       {
         const char *s;
 
+        s = fused_command (cmd->sccsname, &ap[1]);
+        if (s != NULL)
+          {
+            rval = command (&ap[1], forkflag, s);
+            break;
+          }
+
         /* step through & execute each part of the macro */
         for (s = cmd->sccspath; *s != '\0'; s++)
           {
@@ -1226,6 +1273,10 @@ command (char *argv[], bool forkflag, const char *arg0)
       np = do_enter(argv, np, ap, &rval);
       break;
 
+    case BATCH:         /* run commands read from a file */
+      rval = do_batch (&ap[1]);
+      break;
+
     default:
       {
         syserr ("Unexpected oper %d", cmd->sccsoper);
@@ -1269,6 +1320,43 @@ lookup (const char *name)
   return NULL;
 }
 
+/*
+   **  FUSED_COMMAND -- find a single command to do a macro's job
+   **
+   **   Parameters:
+   **           name -- the name of the macro.
+   **           argv -- the arguments given to it.
+   **
+   **   Returns:
+   **           the command which can be used instead of the macro,
+   **           or NULL if the macro must be run as it stands.
+   **
+   **   Side Effects:
+   **           none.
+ */
+
+const char *
+fused_command (const char *name, char **argv)
+{
+  register const struct fusedmacro *fm;
+
+  for (fm = FusedMacros; fm->sccsname != NULL; fm++)
+    {
+      if (strcmp (fm->sccsname, name) == 0)
+        break;
+    }
+  if (fm->sccsname == NULL)
+    return NULL;
+
+  for (; *argv != NULL; argv++)
+    {
+      const char *p = *argv;
+      if (*p == '-' && p[1] != '\0' && my_index (fm->options, p[1]) == NULL)
+        return NULL;
+    }
+  return fm->command;
+}
+
 /*
  * childwait()
  *
@@ -1341,6 +1429,265 @@ do_fork(void)
 }
 
 
+/*
+ * child_exit_status()
+ *
+ * Convert the status of a child process (as returned by waitpid())
+ * into an exit value, reporting the signal which killed it if any.
+ */
+static int
+child_exit_status(int st, const char *name)
+{
+  if (WIFEXITED(st))            /* normal exit. */
+    {
+      return WEXITSTATUS(st);
+    }
+  else                          /* child exited via signal */
+    {
+      int sigcode = WTERMSIG(st);
+      if (sigcode != SIGINT && sigcode != SIGPIPE)
+        {
+          char sigmsgbuf[11];
+          fprintf (stderr,
+                   "%s: %s: %s%s\n",
+                   program_name,
+                   name,
+                   get_sig_name(sigcode, sigmsgbuf),
+                   (WCOREDUMP(st) ? " (core dumped)" : "") );
+        }
+      return CSSC_EX_SOFTWARE;
+    }
+}
+
+
+/*
+   **  SPLIT_BATCH_LINE -- split a line of "sccs batch" input into words.
+   **
+   **   Words are separated by blanks.  Within a word, text inside
+   **   single or double quotes is taken literally, and outside
+   **   single quotes a backslash quotes the next character.  A line
+   **   whose first word starts with "#" is a comment.
+   **
+   **   Parameters:
+   **           line -- the line, which is modified in place.
+   **           words -- the array to fill in.
+   **           maxwords -- the number of elements of words, which
+   **                   includes the terminating NULL.
+   **
+   **   Returns:
+   **           The number of words, or -1 if the line is not valid.
+ */
+static int
+split_batch_line (char *line, char *words[], int maxwords)
+{
+  char *p = line;
+  char *q;
+  int n = 0;
+
+  for (;;)
+    {
+      char quote = '\0';
+
+      while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        p++;
+      if (*p == '\0' || (n == 0 && *p == '#'))
+        break;
+      if (n + 1 >= maxwords)
+        {
+          usrerr ("too many arguments");
+          return -1;
+        }
+      words[n++] = q = p;
+      for (; *p != '\0'; p++)
+        {
+          if (quote)
+            {
+              if (*p == quote)
+                quote = '\0';
+              else if (*p == '\\' && quote == '"' && p[1] != '\0')
+                *q++ = *++p;
+              else
+                *q++ = *p;
+            }
+          else if (*p == '\'' || *p == '"')
+            quote = *p;
+          else if (*p == '\\' && p[1] != '\0')
+            *q++ = *++p;
+          else if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+            break;
+          else
+            *q++ = *p;
+        }
+      if (quote)
+        {
+          usrerr ("unterminated %c", quote);
+          return -1;
+        }
+      if (*p != '\0')
+        p++;
+      *q = '\0';
+    }
+  words[n] = NULL;
+  return n;
+}
+
+
+/*
+   **  RUN_BATCH_COMMAND -- run one command for "sccs batch".
+   **
+   **   The command runs in a child process, exactly as if it had
+   **   been given on the command line of a separate sccs process.
+   **
+   **   Parameters:
+   **           words -- the command and its arguments.
+   **           in -- the stream from which the commands are read.
+   **
+   **   Returns:
+   **           The exit status of the command.
+ */
+static int
+run_batch_command (char *words[], FILE *in)
+{
+  pid_t pid;
+  int st;
+
+#ifdef CSSC_MULTICALL
+  /* The child inherits our cache of parsed SCCS files, so read the
+   * files the command names into it first.  Only the built-in
+   * programs use the cache.
+   */
+  if (TrustEnvironment && NULL == subprogram_exec_prefix)
+    {
+      char **w;
+      for (w = &words[1]; *w != NULL; w++)
+        {
+          if (**w != '-')
+            {
+              char *name = makefile (*w);
+              if (name != NULL)
+                {
+                  cssc_prime_sfile (name);
+                  free (name);
+                }
+            }
+        }
+    }
+#endif
+
+  fflush (stdout);
+  fflush (stderr);
+  pid = do_fork ();
+  if (pid < 0)
+    {
+      syserr ("cannot fork");
+      return CSSC_EX_OSERR;
+    }
+  else if (pid == 0)
+    {
+      /* The commands must not read our input.  Exiting closes
+       * every stream, and closing an input stream may reset the
+       * file offset, which we share with the child.  So we replace
+       * the file descriptor underneath the stream.
+       */
+      int fd = open ("/dev/null", O_RDONLY);
+      if (fd < 0 || dup2 (fd, fileno (in)) < 0
+          || (in == stdin && NULL == freopen ("/dev/null", "r", stdin)))
+        {
+          syserr ("cannot open /dev/null");
+          exit (CSSC_EX_OSERR);
+        }
+      close (fd);
+      exit (command (words, FALSE, ""));
+    }
+  childwait (pid, &st, 0);
+  return child_exit_status (st, words[0]);
+}
+
+
+/*
+   **  DO_BATCH -- run commands read from a file.
+   **
+   **   Each line of the file is a command (without the leading
+   **   "sccs").  After each command has finished, a line consisting
+   **   of a ^A character followed by the command's exit status is
+   **   written to the standard output.  A ^A cannot start a line of
+   **   a text file under SCCS control, so this cannot be confused
+   **   with the output of (for example) "get -p".
+   **
+   **   Parameters:
+   **           argv -- the name of the file to read; if there is
+   **                   none (or it is "-"), the standard input is
+   **                   read.
+   **
+   **   Returns:
+   **           zero if all the input was read, else an error status.
+ */
+static int
+do_batch (char *const argv[])
+{
+  FILE *in;
+  const char *name;
+  char line[FBUFSIZ];
+  char *words[256];
+  int rval = CSSC_EX_OK;
+
+  if (argv[0] != NULL && argv[1] != NULL)
+    {
+      usrerr ("usage: batch [file]");
+      return CSSC_EX_USAGE;
+    }
+  if (argv[0] == NULL || 0 == strcmp (argv[0], "-"))
+    {
+      in = stdin;
+      name = "standard input";
+    }
+  else
+    {
+      in = fopen (argv[0], "r");
+      name = argv[0];
+      if (NULL == in)
+        {
+          perror (name);
+          return CSSC_EX_NOINPUT;
+        }
+    }
+
+  while (fgets (line, sizeof (line), in) != NULL)
+    {
+      int n, status;
+
+      if (NULL == my_index (line, '\n') && !feof (in))
+        {
+          int ch;
+          usrerr ("input line too long");
+          while ((ch = getc (in)) != EOF && ch != '\n')
+            continue;
+          n = -1;
+        }
+      else
+        {
+          n = split_batch_line (line, words, sizeof (words) / sizeof (words[0]));
+        }
+
+      if (n == 0)
+        continue;
+      status = (n < 0) ? CSSC_EX_USAGE : run_batch_command (words, in);
+      fflush (stderr);
+      printf ("\001%d\n", status);
+      fflush (stdout);
+    }
+
+  if (ferror (in))
+    {
+      perror (name);
+      rval = CSSC_EX_IOERR;
+    }
+  if (in != stdin)
+    fclose (in);
+  return rval;
+}
+
+
 /*
    **  CALLPROG -- call a program
    **
@@ -1391,6 +1738,11 @@ callprog (const char *progpath,
       if (Debug)
         printf ("%s", "Forking\n");
 #endif
+      /* Flush our output first, so that the child (which may not
+       * exec another program) does not write it out a second time.
+       */
+      fflush (stdout);
+      fflush (stderr);
       i = do_fork ();
       if (i < 0)
         {
@@ -1402,26 +1754,7 @@ callprog (const char *progpath,
           int st;
 
           childwait(i, &st, 0); /* don't block SIGINT. */
-
-          if (WIFEXITED(st))    /* normal exit. */
-            {
-              st = WEXITSTATUS(st);
-            }
-          else                  /* child exited via signal */
-            {
-              int sigcode = WTERMSIG(st);
-              if (sigcode != SIGINT && sigcode != SIGPIPE)
-                {
-                  char sigmsgbuf[11];
-                  fprintf (stderr,
-                           "%s: %s: %s%s\n",
-                           program_name,
-                           argv[0],
-                           get_sig_name(sigcode, sigmsgbuf),
-                           (WCOREDUMP(st) ? " (core dumped)" : "") );
-                }
-              st = CSSC_EX_SOFTWARE;
-            }
+          st = child_exit_status (st, argv[0]);
 
           if (OutFile >= 0)
             {
@@ -1460,6 +1793,20 @@ callprog (const char *progpath,
       close (OutFile);
     }
 
+#ifdef CSSC_MULTICALL
+  /* If the program is linked into this one, just call it.  We don't
+   * do this when running setuid (so that the program runs exactly as
+   * installed) or when the user has asked for a specific version of
+   * the programs with --prefix.
+   */
+  if (TrustEnvironment && NULL == subprogram_exec_prefix)
+    {
+      int status;
+      if (cssc_run_builtin (progpath, argv, &status))
+        exit (status);
+    }
+#endif
+
   /* call real SCCS program */
   try_to_exec (progpath, argv);
   exit (CSSC_EX_UNAVAILABLE);
@@ -1652,24 +1999,318 @@ safepath (register const char *p)
   return FALSE;
 }
 
+/*
+   **  A sorted list of the names in a directory, so that we can
+   **  look names up without a system call for each one.
+ */
+struct name_list
+{
+  char **names;
+  size_t count;
+  size_t allocated;
+};
+
 static void
-form_gname(char *buf, size_t bufsize, struct dirent *dir)
+name_list_add (struct name_list *list, const char *name)
 {
-  size_t len = strlen (dir->d_name);
-  size_t gname_len = len-2u;
+  if (list->count == list->allocated)
+    {
+      size_t n = list->allocated ? 2u * list->allocated : 64u;
+      char **p = realloc (list->names, n * sizeof (*p));
+      if (NULL == p)
+        oom ();
+      list->names = p;
+      list->allocated = n;
+    }
+  list->names[list->count++] = str_dup (name);
+}
+
+static int
+compare_names (const void *a, const void *b)
+{
+  return strcmp (*(char *const *) a, *(char *const *) b);
+}
+
+static void
+name_list_sort (struct name_list *list)
+{
+  if (list->count > 1u)
+    qsort (list->names, list->count, sizeof (list->names[0]), compare_names);
+}
 
-  if (gname_len >= bufsize)
+static bool
+name_list_contains (const struct name_list *list, const char *name)
+{
+  return list->count > 0u
+    && NULL != bsearch (&name, list->names, list->count,
+                        sizeof (list->names[0]), compare_names);
+}
+
+static void
+name_list_free (struct name_list *list)
+{
+  size_t i;
+  for (i = 0; i < list->count; ++i)
+    free (list->names[i]);
+  free (list->names);
+  list->names = NULL;
+  list->count = list->allocated = 0;
+}
+
+/* Returns the malloc()ed name DIR/NAME, or just NAME if DIR is empty. */
+static char *
+path_join (const char *dir, const char *name)
+{
+  size_t dlen = strlen (dir);
+  size_t nlen = strlen (name);
+  char *p = malloc (dlen + nlen + 2u);
+  if (NULL == p)
+    oom ();
+  if (dlen)
     {
-      gstrbotchn(bufsize, dir->d_name, len, (char*)0, 0);
+      memcpy (p, dir, dlen);
+      p[dlen++] = '/';
+    }
+  memcpy (p + dlen, name, nlen + 1u);
+  return p;
+}
+
+/* Returns TRUE if the entry NAME of directory DIR is itself a
+ * directory.  Where readdir() tells us the type of the entry we
+ * believe it, so that we don't need to stat() every file.  Symbolic
+ * links are not followed.
+ */
+static bool
+entry_is_dir (const char *dir, const struct dirent *d)
+{
+  struct stat st;
+  char *path;
+  bool result;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+  if (d->d_type != DT_UNKNOWN)
+    return d->d_type == DT_DIR;
+#endif
+  path = path_join (dir, d->d_name);
+  result = (0 == lstat (path, &st) && S_ISDIR (st.st_mode));
+  free (path);
+  return result;
+}
+
+static bool
+is_dot_or_dotdot (const char *name)
+{
+  return '.' == name[0]
+    && ('\0' == name[1] || ('.' == name[1] && '\0' == name[2]));
+}
+
+struct clean_options
+{
+  int mode;
+  bool nobranch;
+  bool recursive;
+  const char *usernm;
+};
+
+/*
+   **  CLEAN_DIR -- clean (or report on) one directory
+   **
+   **   Parameters:
+   **           opts -- the command and its flags.
+   **           sdir -- the directory containing the SCCS directory
+   **                   ("" for the current directory).
+   **           gdir -- the directory containing the g-files
+   **                   ("" for the current directory).
+   **           prefix -- prepended to the names we print.
+   **           gotedit -- set to TRUE if any file is being edited.
+   **           top -- TRUE for the directory named on the command
+   **                   line, which must have an SCCS directory
+   **                   unless we are recursing.
+   **
+   **   Returns:
+   **           An exit status.
+   **
+   **   Side Effects:
+   **           As for clean().
+   **
+   **   Each directory is read only once.  We remember the names
+   **   of the p-files so that we only try to open those which
+   **   exist, and (when the g-files live next to the SCCS
+   **   directory) the names of the g-files so that we only unlink
+   **   those which exist.
+ */
+static int
+clean_dir (const struct clean_options *opts, const char *sdir,
+           const char *gdir, const char *prefix, bool *gotedit, bool top)
+{
+  struct dirent *dir;
+  DIR *dirp;
+  char *sccsdir;
+  size_t i;
+  int retval = CSSC_EX_OK;
+  struct name_list snames = { NULL, 0, 0 };
+  struct name_list pnames = { NULL, 0, 0 };
+  struct name_list gnames = { NULL, 0, 0 };
+  struct name_list subdirs = { NULL, 0, 0 };
+  /* The g-files are beside the SCCS directory unless PROJECTDIR
+   * puts the SCCS files somewhere else.
+   */
+  const bool gfiles_here = (0 == strcmp (sdir, gdir));
+  const bool want_gnames = (opts->mode == CLEANC && gfiles_here);
+  bool listed = FALSE;
+
+  /*
+     **  Read the directory itself if we need its subdirectories
+     **   or the names of its g-files.
+   */
+  if (opts->recursive || want_gnames)
+    {
+      dirp = opendir (sdir[0] ? sdir : ".");
+      if (dirp != NULL)
+        {
+          listed = TRUE;
+          while (NULL != (dir = readdir (dirp)))
+            {
+              if (is_dot_or_dotdot (dir->d_name))
+                continue;
+              if (opts->recursive && entry_is_dir (sdir, dir))
+                {
+                  if (0 != strcmp (dir->d_name, SccsPath))
+                    name_list_add (&subdirs, dir->d_name);
+                }
+              else if (want_gnames)
+                {
+                  name_list_add (&gnames, dir->d_name);
+                }
+            }
+          closedir (dirp);
+          name_list_sort (&gnames);
+          name_list_sort (&subdirs);
+        }
+    }
+
+  /*
+     **  Scan the SCCS directory looking for s. and p. files.
+   */
+  sccsdir = path_join (sdir, SccsPath);
+  dirp = opendir (sccsdir[0] ? sccsdir : ".");
+  if (dirp == NULL)
+    {
+      /* When recursing, the starting directory need not have an
+       * SCCS directory of its own.
+       */
+      if (top && opts->recursive && !listed)
+        {
+          usrerr ("cannot open %s", sdir[0] ? sdir : ".");
+          retval = CSSC_EX_NOINPUT;
+        }
+      else if (top && !opts->recursive)
+        {
+          usrerr ("cannot open %s", sccsdir);
+          retval = CSSC_EX_NOINPUT;
+        }
     }
   else
     {
-      memcpy(buf, dir->d_name+2, gname_len);
-      buf[gname_len] = 0; /* terminate the string. */
+      while (NULL != (dir = readdir (dirp)))
+        {
+          const char *name = dir->d_name;
+          if (('s' != name[0] && 'p' != name[0]) ||
+              '.' != name[1] ||
+              0 == name[2])
+            continue;
+#ifdef _DIRENT_HAVE_D_TYPE
+          if (dir->d_type == DT_DIR)
+            continue;
+#endif
+          if ('s' == name[0])
+            name_list_add (&snames, name + 2);
+          else
+            name_list_add (&pnames, name + 2);
+        }
+      closedir (dirp);
+      name_list_sort (&pnames);
+    }
+
+  for (i = 0; i < snames.count; ++i)
+    {
+      const char *basefile = snames.names[i];
+      char *shown = path_join (prefix, basefile);
+      bool gotpfent = FALSE;
+
+      /*
+         **  open and scan the p-file.
+         **   'gotpfent' tells if we have found a valid p-file
+         **           entry.
+       */
+      if (name_list_contains (&pnames, basefile))
+        {
+          char *pname = malloc (strlen (sccsdir) + strlen (basefile) + 4u);
+          FILE *pfp;
+          if (NULL == pname)
+            oom ();
+          sprintf (pname, "%s%sp.%s", sccsdir, sccsdir[0] ? "/" : "",
+                   basefile);
+          pfp = fopen (pname, "r");
+          free (pname);
+          if (pfp != NULL)
+            {
+              const struct pfile *pf;
+              /* the file exists -- report it's contents */
+              while ((pf = getpfent (pfp)) != NULL)
+                {
+                  if (opts->nobranch && isbranch (pf->p_nsid))
+                    continue;
+                  if (opts->usernm != NULL
+                      && strcmp (opts->usernm, pf->p_user) != 0
+                      && opts->mode != CLEANC)
+                    continue;
+                  *gotedit = TRUE;
+                  gotpfent = TRUE;
+                  if (opts->mode == TELLC)
+                    {
+                      printf ("%s\n", shown);
+                      break;
+                    }
+                  printf ("%12s: being edited: ", shown);
+                  putpfent (pf, stdout);
+                }
+              fclose (pfp);
+            }
+        }
+
+      /* the s. file exists and no p. file exists -- unlink the g-file */
+      if (opts->mode == CLEANC && !gotpfent
+          && (!want_gnames || name_list_contains (&gnames, basefile)))
+        {
+          char *gname = path_join (gdir, basefile);
+          unlink (gname);
+          free (gname);
+        }
+      free (shown);
+    }
+
+  /* Descend into the subdirectories. */
+  for (i = 0; i < subdirs.count; ++i)
+    {
+      char *sub_s = path_join (sdir, subdirs.names[i]);
+      char *sub_g = path_join (gdir, subdirs.names[i]);
+      char *sub_prefix = path_join (prefix, subdirs.names[i]);
+      clean_dir (opts, sub_s, sub_g, sub_prefix, gotedit, FALSE);
+      free (sub_s);
+      free (sub_g);
+      free (sub_prefix);
     }
+
+  free (sccsdir);
+  name_list_free (&snames);
+  name_list_free (&pnames);
+  name_list_free (&gnames);
+  name_list_free (&subdirs);
+  return retval;
 }
 
-
+
 /*
    **  CLEAN -- clean out recreatable files
    **
@@ -1688,29 +2329,27 @@ form_gname(char *buf, size_t bufsize, struct dirent *dir)
    **           Removes files in the current directory.
    **           Prints information regarding files being edited.
    **           Exits if a "check" command.
+   **           With -r, does the same for each subdirectory.
  */
 int
-do_clean (int mode, char *const *argv, char buf[FBUFSIZ])
+clean (int mode, char *const *argv)
 {
-  struct dirent *dir;
-  register DIR *dirp;
-  char *bufend;
-  register char *basefile;
-  bool gotedit;
-  bool gotpfent;
-  FILE *pfp;
-  bool nobranch = FALSE;
-  register const struct pfile *pf;
   register char *const *ap;
-  const char *usernm = NULL;
   const char *subdir = NULL;
-  const char *cmdname;
+  struct clean_options opts;
+  char *sdir;
+  bool gotedit;
+  int retval;
+
+  opts.mode = mode;
+  opts.nobranch = FALSE;
+  opts.recursive = FALSE;
+  opts.usernm = NULL;
 
   /*
      **  Process the argv
    */
 
-  cmdname = *argv;
   for (ap = argv; *++ap != NULL;)
     {
       if (**ap == '-')
@@ -1719,16 +2358,20 @@ do_clean (int mode, char *const *argv, char buf[FBUFSIZ])
           switch ((*ap)[1])
             {
             case 'b':
-              nobranch = TRUE;
+              opts.nobranch = TRUE;
+              break;
+
+            case 'r':
+              opts.recursive = TRUE;
               break;
 
             case 'u':
               if ((*ap)[2] != '\0')
-                usernm = &(*ap)[2];
+                opts.usernm = &(*ap)[2];
               else if (ap[1] != NULL && ap[1][0] != '-')
-                usernm = *++ap;
+                opts.usernm = *++ap;
               else
-                usernm = username ();
+                opts.usernm = username ();
               break;
             }
         }
@@ -1742,119 +2385,32 @@ do_clean (int mode, char *const *argv, char buf[FBUFSIZ])
     }
 
   /*
-     **  Find and open the SCCS directory.
-   */
-
-  gstrcpy (buf, SccsDir, FBUFSIZ);
-  if (buf[0] != '\0')
-    gstrcat (buf, "/", FBUFSIZ);
-  if (subdir != NULL)
-    {
-      gstrcat (buf, subdir, FBUFSIZ);
-      gstrcat (buf, "/", FBUFSIZ);
-    }
-  gstrcat (buf, SccsPath, FBUFSIZ);
-  bufend = &buf[strlen (buf)];
-
-  dirp = opendir (buf);
-  if (dirp == NULL)
-    {
-      usrerr ("cannot open %s", buf);
-      return (CSSC_EX_NOINPUT);
-    }
-
-  /*
-     **  Scan the SCCS directory looking for s. files.
-     **   gotedit tells whether we have tried to clean any
-     **           files that are being edited.
+     **  The SCCS directory is SccsDir/subdir/SccsPath, and the
+     **  g-files are in subdir (or the current directory).
    */
+  sdir = subdir ? path_join (SccsDir, subdir) : str_dup (SccsDir);
 
   gotedit = FALSE;
-  while (NULL != (dir = readdir (dirp)))
-    {
-      if ('s' != dir->d_name[0] ||
-	  '.' != dir->d_name[1] ||
-	  0 == dir->d_name[2])
-        continue;
-
-      /* got an s. file -- see if the p. file exists */
-      gstrcat (buf, "/p.", FBUFSIZ);/* XXX: BUG: wrong size limit. */
-      basefile = bufend + 3;
-      form_gname(basefile, FBUFSIZ-strlen(buf), dir);
-
+  retval = clean_dir (&opts, sdir, subdir ? subdir : "", "", &gotedit, TRUE);
+  free (sdir);
+  if (retval != CSSC_EX_OK)
+    return retval;
 
-      /*
-         **  open and scan the p-file.
-         **   'gotpfent' tells if we have found a valid p-file
-         **           entry.
-       */
-
-      pfp = fopen (buf, "r");
-      gotpfent = FALSE;
-      if (pfp != NULL)
-        {
-          /* the file exists -- report it's contents */
-          while ((pf = getpfent (pfp)) != NULL)
-            {
-              if (nobranch && isbranch (pf->p_nsid))
-                continue;
-              if (usernm != NULL && strcmp (usernm, pf->p_user) != 0 && mode != CLEANC)
-                continue;
-              gotedit = TRUE;
-              gotpfent = TRUE;
-              if (mode == TELLC)
-                {
-                  printf ("%s\n", basefile);
-                  break;
-                }
-              printf ("%12s: being edited: ", basefile);
-              putpfent (pf, stdout);
-            }
-          fclose (pfp);
-        }
-
-      /* the s. file exists and no p. file exists -- unlink the g-file */
-      if (mode == CLEANC && !gotpfent)
-        {
-          char unlinkbuf[FBUFSIZ];
-          form_gname(unlinkbuf, FBUFSIZ, dir);
-          unlink (unlinkbuf);
-        }
-    }
-
-  /* cleanup & report results */
-  closedir (dirp);
+  /* report results */
   if (!gotedit && mode == INFOC)
     {
       printf ("Nothing being edited");
-      if (nobranch)
+      if (opts.nobranch)
         printf (" (on trunk)");
-      if (usernm == NULL)
+      if (opts.usernm == NULL)
         printf ("\n");
       else
-        printf (" by %s\n", usernm);
+        printf (" by %s\n", opts.usernm);
     }
   if (mode == CHECKC)
     exit (gotedit);
   return (CSSC_EX_OK);
 }
-
-int
-clean (int mode, char *const *argv)
-{
-  int retval = CSSC_EX_OK;
-  char *buf = malloc(FBUFSIZ);
-  if (NULL == buf)
-    {
-      oom();
-    }
-  else
-    {
-      retval = do_clean(mode, argv, buf);
-      free(buf);
-    }
-  return retval;
-}
 
 /*
    **  ISBRANCH -- is the SID a branch?
@@ -2392,22 +2948,3 @@ gstrbotch (const char *str1, const char *str2)
           (str2 ? str2 : ""));
   exit(CSSC_EX_SOFTWARE);
 }
-
-static void
-gstrbotchn (int navail,
-            const char *str1, int len1, const char *str2, int len2)
-{
-  fprintf(stderr, "Filename%s too long: ", (str1 && str2) ? "s" :"");
-  if (str1)
-    {
-      fwrite(str1, len1, 1, stderr);
-      putc(' ', stderr);
-    }
-  if (str2)
-    {
-      fwrite(str2, len2, 1, stderr);
-    }
-  putc('\n', stderr);
-  fprintf(stderr, "Only %d characters available.\n", navail);
-  exit(CSSC_EX_SOFTWARE);
-}
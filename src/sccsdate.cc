@@ -128,6 +128,14 @@ is_digit(char ch)
   return isdigit(static_cast<unsigned char>(ch));
 }
 
+// Unlike isdigit(), this does not depend on the locale, and so needs
+// no function call.
+static inline bool
+is_ascii_digit(char ch)
+{
+  return ch >= '0' && ch <= '9';
+}
+
 static inline int
 get_digit(char ch)
 {
@@ -185,9 +193,7 @@ count_digits(const char *s)
 
 // Construct a date as specified on the command line.
 sccs_date::sccs_date(const char *s)
-  : year_(-1), month_(-1), month_day_(-1),
-    hour_(-1), minute_(-1), second_(-1),
-    yearday_(-1)
+  : packed_(0)
 {
   ASSERT(s != nullptr);
   /* if (s == 0) return; */
@@ -200,7 +206,8 @@ sccs_date::sccs_date(const char *s)
   const int n_digits = count_digits(s);
 
   // Get and check the year part.
-  if ( (year_ = get_part(s, -1)) == -1)
+  int yr = get_part(s, -1);
+  if (-1 == yr)
     return;
 
 #if 1
@@ -228,32 +235,58 @@ sccs_date::sccs_date(const char *s)
       if (isdigit(static_cast<unsigned char>(s[0])) &&
           isdigit((static_cast<unsigned char>(s[1]))))
         {
-          const int century_field_val = year_;
-          year_ =  (century_field_val * 100) + get_two_digits(&s[0]);
+          const int century_field_val = yr;
+          yr =  (century_field_val * 100) + get_two_digits(&s[0]);
           s += 2;               // this consumes exactly two characters.
         }
     }
   else
     {
-      year_ = y2k_window(year_);
+      yr = y2k_window(yr);
     }
 #endif
 
-  month_     = get_part(s, 12);
-  month_day_ = get_part(s, days_in_month(month_, year_));
-  hour_      = get_part(s, 23);
-  minute_    = get_part(s, 59);
-  second_    = get_part(s, 59);
+  const int mth = get_part(s, 12);
+  const int day = get_part(s, days_in_month(mth, yr));
+  const int hr  = get_part(s, 23);
+  const int min = get_part(s, 59);
+  const int sec = get_part(s, 59);
 
-  update_yearday();
+  set(yr, mth, day, hr, min, sec);
+}
+
+// Parse a date and time in the usual form of a delta line in an SCCS
+// file, "YY/MM/DD" and "hh:mm:ss".  Returns false (having changed
+// nothing) if they are in any other form.
+bool
+sccs_date::parse_fixed(const char *date, const char *time)
+{
+  // The "1" in the if() is just there to make Emacs align the columns.
+  if (!(1
+	&& is_ascii_digit(date[0]) && is_ascii_digit(date[1]) && date[2] == '/'
+	&& is_ascii_digit(date[3]) && is_ascii_digit(date[4]) && date[5] == '/'
+	&& is_ascii_digit(date[6]) && is_ascii_digit(date[7]) && date[8] == '\0'
+
+	&& is_ascii_digit(time[0]) && is_ascii_digit(time[1]) && time[2] == ':'
+	&& is_ascii_digit(time[3]) && is_ascii_digit(time[4]) && time[5] == ':'
+	&& is_ascii_digit(time[6]) && is_ascii_digit(time[7]) && time[8] == '\0'))
+    return false;
+
+  // We have checked the digits already.
+  auto two = [](const char *p) { return (p[0] - '0') * 10 + (p[1] - '0'); };
+  set(y2k_window(two(&date[0])), two(&date[3]), two(&date[6]),
+      two(&time[0]), two(&time[3]), two(&time[6]));
+  return true;
 }
 
 // Construct a date as specified in an SCCS file.
 sccs_date::sccs_date(const char *date_arg, const char *time)
-  : year_(-1), month_(-1), month_day_(-1),
-    hour_(-1), minute_(-1), second_(-1),
-    yearday_(-1)
+  : packed_(0)
 {
+  // Nearly every date is in the usual form.
+  if (parse_fixed(date_arg, time))
+    return;
+
   std::string date(date_arg);
   int century;
 
@@ -310,13 +343,7 @@ sccs_date::sccs_date(const char *date_arg, const char *time)
       && is_digit(time[3]) && is_digit(time[4]) && time[5] == ':'
       && is_digit(time[6]) && is_digit(time[7]) && time[8] == '\0')
     {
-      year_      = get_two_digits(date, 0);
-      month_     = get_two_digits(date, 3);
-      month_day_ = get_two_digits(date, 6);
-
-      hour_      = get_two_digits(&time[0]);
-      minute_    = get_two_digits(&time[3]);
-      second_    = get_two_digits(&time[6]);
+      int year_  = get_two_digits(date, 0);
 
       if (century)
       {
@@ -332,104 +359,137 @@ sccs_date::sccs_date(const char *date_arg, const char *time)
 	// for more details).
 	year_ = y2k_window(year_);
       }
-      update_yearday();
+      set(year_, get_two_digits(date, 3), get_two_digits(date, 6),
+	  get_two_digits(&time[0]), get_two_digits(&time[3]),
+	  get_two_digits(&time[6]));
     }
 }
 
-cssc::Failure
-sccs_date::printf(FILE *f, char fmt) const
+// Write VALUE to BUF as printf's "%02d" would, returning the number
+// of characters written.
+static size_t
+put_two_digits(char *buf, int value)
 {
-  const int yy = year_ % 100;
-
-  switch(fmt)
+  if (value >= 0 && value < 100)
     {
-    case 'D':
-      return fprintf_failure(fprintf(f, "%02d/%02d/%02d",
-				     yy, month_, month_day_));
-    case 'H':
-      return fprintf_failure(fprintf(f, "%02d/%02d/%02d",
-				     month_, month_day_, yy));
-
-    case 'T':
-      return fprintf_failure(fprintf(f, "%02d:%02d:%02d",
-				     hour_, minute_, second_));
+      buf[0] = static_cast<char>('0' + value / 10);
+      buf[1] = static_cast<char>('0' + value % 10);
+      return 2u;
     }
+  return static_cast<size_t>(sprintf(buf, "%02d", value));
+}
+
+static size_t
+put_triple(char *buf, int a, char sep, int b, int c)
+{
+  size_t n = put_two_digits(buf, a);
+  buf[n++] = sep;
+  n += put_two_digits(buf + n, b);
+  buf[n++] = sep;
+  return n + put_two_digits(buf + n, c);
+}
+
+// Format the part of the date selected by FMT (as for printf) into
+// BUF, which must have room for 40 characters.  Returns the number
+// of characters written, or zero if FMT is not valid.  We do this
+// ourselves rather than with sprintf since prs and keyword
+// substitution print dates very often.
+size_t
+sccs_date::format(char fmt, char *buf) const
+{
+  const int yy = year() % 100;
 
-  int value = 0;
   switch (fmt)
     {
+    case 'D':
+      return put_triple(buf, yy, '/', month(), month_day());
+    case 'H':
+      return put_triple(buf, month(), '/', month_day(), yy);
+    case 'T':
+      return put_triple(buf, hour(), ':', minute(), second());
     case 'y':
-      value = yy;
-      break;
-
+      return put_two_digits(buf, yy);
     case 'o':
-      value = month_;
-      break;
-
+      return put_two_digits(buf, month());
     case 'd':
-      value = month_day_;
-      break;
-
+      return put_two_digits(buf, month_day());
     case 'h':
-      value = hour_;
-      break;
-
+      return put_two_digits(buf, hour());
     case 'm':
-      value = minute_;
-      break;
-
+      return put_two_digits(buf, minute());
     case 's':
-      value = second_;
-      break;
+      return put_two_digits(buf, second());
+    }
+  return 0u;
+}
 
-    default:
+cssc::Failure
+sccs_date::printf(FILE *f, char fmt) const
+{
+  char buf[40];
+  const size_t len = format(fmt, buf);
+  if (0u == len)
+    {
       ASSERT(!"sccs_date::printf: Invalid format");
       /* This line is reached when ASSERT expands to nothing. */
       return cssc::make_failure_builder_from_errno(EINVAL)
 	.diagnose() << "sccs_date::printf: Invalid format letter '"
 		    << fmt << "'";
     }
-  return fprintf_failure(fprintf(f, "%02d", value));
+  return fwrite_failed(fwrite(buf, 1, len, f), len);
 }
 
 cssc::Failure
 sccs_date::print(FILE *f) const
 {
-  cssc::Failure fail = this->printf(f, 'D');
-  fail = Update(fail, fputc_failure(' ', f));
-  fail = Update(fail, this->printf(f, 'T'));
-  return fail;
+  char buf[80];
+  size_t len = format('D', buf);
+  buf[len++] = ' ';
+  len += format('T', buf + len);
+  return fwrite_failed(fwrite(buf, 1, len, f), len);
 }
 
 
 std::string
 sccs_date::as_string() const
 {
-  char buf[18];
-  const int yy = year_ % 100;
-
-  sprintf(buf, "%02d/%02d/%02d %02d:%02d:%02d",
-          yy, month_, month_day_,
-          hour_, minute_, second_);
-
-  return std::string(buf);
+  char buf[80];
+  size_t len = format('D', buf);
+  buf[len++] = ' ';
+  len += format('T', buf + len);
+  return std::string(buf, len);
 }
 
 sccs_date::sccs_date(int yr, int mth, int day,
                      int hr, int min, int sec)
-  : year_(yr), month_(mth), month_day_(day),
-    hour_(hr), minute_(min), second_(sec),
-    yearday_(-1)
+  : packed_(0)
 {
-  update_yearday();
+  set(yr, mth, day, hr, min, sec);
 }
 
 sccs_date::sccs_date()
-  : year_(-1), month_(-1), month_day_(-1),
-    hour_(-1), minute_(-1), second_(-1), yearday_(-1)
+  : packed_(0)
 {
 }
 
+void
+sccs_date::set(int yr, int mth, int day, int hr, int min, int sec)
+{
+  // Each value is stored plus one; see sccsdate.h.
+  ASSERT(yr >= -1 && yr < 0xFFFF);
+  ASSERT(mth >= -1 && mth < 0xFF);
+  ASSERT(day >= -1 && day < 0xFF);
+  ASSERT(hr >= -1 && hr < 0xFF);
+  ASSERT(min >= -1 && min < 0xFF);
+  ASSERT(sec >= -1 && sec < 0xFF);
+  packed_ = (static_cast<uint64_t>(yr + 1) << year_shift)
+    | (static_cast<uint64_t>(mth + 1) << month_shift)
+    | (static_cast<uint64_t>(day + 1) << day_shift)
+    | (static_cast<uint64_t>(hr + 1) << hour_shift)
+    | (static_cast<uint64_t>(min + 1) << minute_shift)
+    | (static_cast<uint64_t>(sec + 1) << second_shift);
+}
+
 sccs_date
 sccs_date::now()                // static member.
 {
@@ -451,82 +511,21 @@ sccs_date::now()                // static member.
                    ptm->tm_hour, ptm->tm_min, ptm->tm_sec);
 }
 
-void
-sccs_date::update_yearday()
-{
-  int m=1, d=1;
-
-  yearday_ = 1;
-
-  while (m < month_)
-    yearday_ += days_in_month(m++, year_);
-
-  while (d++ < month_day_)
-    yearday_++;
-}
-
-
-int sccs_date::compare(const sccs_date& d) const
-{
-  ASSERT(valid());
-  ASSERT(d.valid());
-
-  int diff;
-
-  if ( (diff = year_ - d.year_) != 0 )
-    return diff;
-  else if ( (diff = yearday_ - d.yearday_) != 0)
-    return diff;
-
-  /* The implementation below can compute an incorrect result when
-     comparing dates on a day when there is a clock change.  For
-     example, suppose the clock is put pack an hour the first time it
-     reaches 02:00 on this day.  Let t1 be a time 3602 seconds into
-     this day, and t2 be a time 7201 seconds into this day.  For both,
-     hour_=1 and minute_=0 but t1 has second_=2 and t2 has second_=1.
-     This function will decide that t1 > t2 while in reality t2 > t1.
-
-     So in theory this implementation is incorrect.  However, since
-     the SCCS date format does not include time zone information, we
-     cannot receive t2 as input in this case (it would bre represnted
-     as the time 01:00::01 and would be understood to represent a time
-     3601 seconds into the day).
-   */
-  if ((diff = hour_ - d.hour_) != 0)
-    return diff;
-  else if ((diff = minute_ - d.minute_) != 0)
-    return diff;
-  else
-    return second_ - d.second_;
-}
-
-bool sccs_date::operator >(sccs_date const & d) const
-{
-  return compare(d) > 0;
-}
-
-bool sccs_date::operator <(sccs_date const &d) const
-{
-  return compare(d) < 0;
-}
-
-bool sccs_date::operator <=(sccs_date const &d) const
-{
-  return compare(d) <= 0;
-}
-
 bool
 sccs_date::valid() const
 {
   // Allow the seconds field to get as high as 61, since that is what
   // the ANSI C spec for struct tm says, and we have to use a struct
   // tm with localtime().
-  return year_ >= 0
-    && month_ > 0 && month_ < 13
-    && month_day_ > 0 && month_day_ <= days_in_month(month_, year_)
-    && hour_ >= 0 && hour_ < 24
-    && minute_ >= 0 && minute_ < 60
-    && second_ >= 0 && second_ <= 61;
+  const int yr = year();
+  const int mth = month();
+  const int day = month_day();
+  return yr >= 0
+    && mth > 0 && mth < 13
+    && day > 0 && day <= days_in_month(mth, yr)
+    && hour() >= 0 && hour() < 24
+    && minute() >= 0 && minute() < 60
+    && second() >= 0 && second() <= 61;
 }
 
 
@@ -30,22 +30,25 @@
 
 #include <string>
 #include <cstdio>
+#include <cstdint>
 
 #include "failure.h"
 #include "quit.h"
 
 class sccs_date
 {
-  int year_;
-  int month_;
-  int month_day_;
+  // All six fields are packed into one integer, most significant
+  // first, so that comparing two dates is a single integer
+  // comparison.  Each field holds its value plus one, so that a
+  // field which has not been set (-1) is held as zero.
+  static constexpr int year_shift = 40;
+  static constexpr int month_shift = 32;
+  static constexpr int day_shift = 24;
+  static constexpr int hour_shift = 16;
+  static constexpr int minute_shift = 8;
+  static constexpr int second_shift = 0;
 
-  int hour_;
-  int minute_;
-  int second_;
-
-  // derived data
-  int yearday_;			// days since start of year.
+  uint64_t packed_;
 
 public:
   sccs_date();
@@ -62,13 +65,26 @@ public:
   cssc::Failure printf(FILE *f, char fmt) const;
   cssc::Failure print(FILE *f) const;
 
-  bool operator >(sccs_date const &) const;
-  bool operator <(sccs_date const &) const;
-  bool operator <=(sccs_date const &) const;
+  // Dates which are not valid() compare consistently with each
+  // other, but not meaningfully.
+  bool operator >(sccs_date const &d) const { return packed_ > d.packed_; }
+  bool operator <(sccs_date const &d) const { return packed_ < d.packed_; }
+  bool operator <=(sccs_date const &d) const { return packed_ <= d.packed_; }
 
 private:
-  inline int compare(sccs_date const &) const;
-  void update_yearday();
+  void set(int yr, int mth, int day, int hr, int min, int sec);
+  bool parse_fixed(const char *date, const char *time);
+  int field(int shift, unsigned mask) const
+  {
+    return static_cast<int>((packed_ >> shift) & mask) - 1;
+  }
+  int year() const { return field(year_shift, 0xFFFFu); }
+  int month() const { return field(month_shift, 0xFFu); }
+  int month_day() const { return field(day_shift, 0xFFu); }
+  int hour() const { return field(hour_shift, 0xFFu); }
+  int minute() const { return field(minute_shift, 0xFFu); }
+  int second() const { return field(second_shift, 0xFFu); }
+  size_t format(char fmt, char *buf) const;
 };
 
 
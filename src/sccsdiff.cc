@@ -0,0 +1,444 @@
+/*
+ * sccsdiff.cc: Part of GNU CSSC.
+ *
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ *
+ * Compares two versions stored in an SCCS file.  This used to be a
+ * shell script which ran get twice, and then diff and pr.  Both
+ * versions are now reconstructed in one pass over the body, and
+ * unless diff options we do not implement ourselves are given, the
+ * differences are found in memory too.
+ */
+
+#include <config.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cssc.h"
+#include "bodyio.h"
+#include "cleanup.h"
+#include "except.h"
+#include "ioerr.h"
+#include "line-diff.h"
+#include "multicall.h"
+#include "sccsfile.h"
+#include "sccsname.h"
+#include "sysdep.h"
+#include "version.h"
+
+#ifndef CONFIG_PR_COMMAND
+#define CONFIG_PR_COMMAND "pr"
+#endif
+
+
+static void
+print_usage(FILE *f)
+{
+  fprintf(f,
+	  "usage: %s [-p] -rsid -rsid [diff-options] s.filename "
+	  "[s.secondfile...]\n",
+	  prg_name);
+}
+
+void
+sccsdiff_usage()
+{
+  print_usage(stderr);
+}
+
+
+namespace
+{
+  struct diff_format
+  {
+    bool native;		// false if we must run diff(1).
+    bool unified;
+    size_t context;
+  };
+
+  // Decide whether we can produce the output asked for by the diff
+  // options ourselves.  We can for the default format and for -u
+  // and -UN; anything else is passed to diff(1).
+  diff_format
+  choose_format(const std::vector<std::string>& options)
+  {
+    diff_format fmt = { true, false, 3 };
+    for (const auto& opt : options)
+      {
+	if ("-u" == opt)
+	  {
+	    fmt.unified = true;
+	  }
+	else if (opt.size() > 2 && 0 == opt.compare(0, 2, "-U")
+		 && opt.find_first_not_of("0123456789", 2) == std::string::npos)
+	  {
+	    fmt.unified = true;
+	    fmt.context = strtoul(opt.c_str() + 2, NULL, 10);
+	  }
+	else
+	  {
+	    fmt.native = false;
+	  }
+      }
+    return fmt;
+  }
+
+  // Write a version of the file as "get -k" would.
+  cssc::Failure
+  write_version(FILE *out, const line_list& lines, bool encoded)
+  {
+    for (size_t i = 0; i < lines.size(); ++i)
+      {
+	size_t len = lines.length(i);
+	if (encoded)
+	  {
+	    char outbuf[80];
+	    const size_t n = decode_line(lines.line(i), outbuf);
+	    cssc::Failure written = fwrite_failed(fwrite(outbuf, 1, n, out), n);
+	    if (!written.ok())
+	      return written;
+	    continue;
+	  }
+	if (lines.missing_final_newline() && i + 1u == lines.size())
+	  --len;
+	cssc::Failure written =
+	  fwrite_failed(fwrite(lines.line(i), 1, len, out), len);
+	if (!written.ok())
+	  return written;
+      }
+    return cssc::Failure::Ok();
+  }
+
+  // Run a program with its standard input and output connected to IN
+  // and OUT (if they are not NULL).  Returns its exit status, or -1
+  // if it could not be run.
+  int
+  run_program(const std::vector<std::string>& args, FILE *in, FILE *out)
+  {
+#ifdef HAVE_FORK
+    std::vector<char*> argv;
+    for (const auto& arg : args)
+      argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(NULL);
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0)
+      {
+	errormsg_with_errno("fork() failed");
+	return -1;
+      }
+    if (0 == pid)
+      {
+	if (in)
+	  dup2(fileno(in), 0);
+	if (out)
+	  dup2(fileno(out), 1);
+	execvp(argv[0], argv.data());
+	errormsg_with_errno("cannot run %s", argv[0]);
+	_exit(127);
+      }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0)
+      {
+	if (EINTR != errno)
+	  {
+	    errormsg_with_errno("waitpid() failed");
+	    return -1;
+	  }
+      }
+    if (WIFEXITED(status) && 127 != WEXITSTATUS(status))
+      return WEXITSTATUS(status);
+    return -1;
+#else
+    errormsg("Cannot run %s on this system", args[0].c_str());
+    return -1;
+#endif
+  }
+
+  // Compare the two versions with diff(1), writing its output to OUT.
+  bool
+  run_diff(const std::vector<std::string>& options,
+	   const line_list& first, const line_list& second,
+	   bool encoded, FILE *out)
+  {
+    const char *tmpdir = getenv("TMPDIR");
+    std::string dir = (tmpdir && *tmpdir) ? tmpdir : "/tmp";
+    std::vector<std::string> names;
+    ResourceCleanup remover([&names]()
+			    {
+			      for (const auto& n : names)
+				remove(n.c_str());
+			    });
+
+    const line_list* versions[] = { &first, &second };
+    for (const line_list* version : versions)
+      {
+	std::string name = dir + "/sccsdiff.XXXXXX";
+	const int fd = mkstemp(&name[0]);
+	if (fd < 0)
+	  {
+	    errormsg_with_errno("cannot create a temporary file in %s",
+				dir.c_str());
+	    return false;
+	  }
+	names.push_back(name);
+	FILE *f = fdopen(fd, "w");
+	if (NULL == f)
+	  {
+	    close(fd);
+	    errormsg_with_errno("%s", name.c_str());
+	    return false;
+	  }
+	cssc::Failure written = write_version(f, *version, encoded);
+	if (fclose_failed(fclose(f)) && written.ok())
+	  written = cssc::make_failure_from_errno(errno);
+	if (!written.ok())
+	  {
+	    errormsg("write error on %s: %s", name.c_str(),
+		     written.to_string().c_str());
+	    return false;
+	  }
+      }
+
+    std::vector<std::string> args;
+    args.push_back(CONFIG_DIFF_COMMAND);
+    args.insert(args.end(), options.begin(), options.end());
+    args.insert(args.end(), names.begin(), names.end());
+    // diff returns 1 if the files differ, and 2 for trouble.
+    const int status = run_program(args, NULL, out);
+    return status == 0 || status == 1;
+  }
+
+  // Copy the rest of IN to OUT.
+  bool
+  copy_stream(FILE *in, FILE *out)
+  {
+    char buf[BUFSIZ];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+      {
+	if (fwrite(buf, 1, n, out) != n)
+	  return false;
+      }
+    return !ferror(in);
+  }
+}  // unnamed namespace
+
+
+int
+sccsdiff_main(int argc, char **argv)
+{
+  Cleaner arbitrary_name;
+
+  if (argc > 0)
+    set_prg_name(argv[0]);
+  else
+    set_prg_name("sccsdiff");
+
+  // We do not use CSSC_Options here, since any option we do not
+  // know is passed on to diff, as the shell script did.
+  bool use_pr = false;
+  std::vector<std::string> sids;
+  std::vector<std::string> diff_options;
+  int i;
+  for (i = 1; i < argc; ++i)
+    {
+      const char *arg = argv[i];
+      if (0 == strcmp(arg, "--help"))
+	{
+	  print_usage(stdout);
+	  return 0;
+	}
+      else if (0 == strcmp(arg, "--version"))
+	{
+	  version();
+	  return 0;
+	}
+      else if (0 == strcmp(arg, "-p"))
+	{
+	  use_pr = true;
+	}
+      else if (0 == strncmp(arg, "-r", 2))
+	{
+	  // Cope with "-r 1.1" as well as "-r1.1".
+	  if ('\0' == arg[2] && i + 1 < argc)
+	    arg = argv[++i];
+	  else
+	    arg += 2;
+	  if (sids.size() == 2u)
+	    {
+	      sccsdiff_usage();
+	      errormsg("Too many -r options.");
+	      return 1;
+	    }
+	  sids.push_back(arg);
+	}
+      else if ('-' == arg[0])
+	{
+	  diff_options.push_back(arg);
+	}
+      else
+	{
+	  break;		// the first SCCS file.
+	}
+    }
+
+  if (sids.size() != 2u)
+    {
+      errormsg("Two SIDs must be specified with the -r option.");
+      sccsdiff_usage();
+      return 1;
+    }
+  sid requested[2] = { sid(sids[0].c_str()), sid(sids[1].c_str()) };
+  for (int k = 0; k < 2; ++k)
+    {
+      if (!requested[k].valid())
+	{
+	  errormsg("Invalid SID: '%s'", sids[k].c_str());
+	  return 1;
+	}
+    }
+  const diff_format fmt = choose_format(diff_options);
+
+  for (; i < argc; ++i)
+    {
+      try
+	{
+	  sccs_name name;
+	  name = argv[i];
+	  if (!name.valid())
+	    name.make_valid();
+	  sccs_file file(name, READ);
+
+	  sid found[2];
+	  for (int k = 0; k < 2; ++k)
+	    {
+	      if (!file.find_requested_sid(requested[k], found[k]))
+		{
+		  errormsg("%s: Requested SID not found.", name.c_str());
+		  errormsg("Failed to get version %s from %s",
+			   sids[k].c_str(), argv[i]);
+		  return 1;
+		}
+	    }
+
+	  line_list versions[2];
+	  cssc::Failure got = file.get_versions(found[0], found[1],
+						&versions[0], &versions[1]);
+	  if (!got.ok())
+	    {
+	      errormsg("%s: %s", name.c_str(), got.to_string().c_str());
+	      return 1;
+	    }
+
+	  FILE *dfile = tmpfile();
+	  if (NULL == dfile)
+	    {
+	      errormsg_with_errno("Cannot create a temporary file");
+	      return 2;
+	    }
+	  ResourceCleanup closer([dfile]() { fclose(dfile); });
+
+	  const bool encoded = file.is_encoded();
+	  if (fmt.native && !encoded)
+	    {
+	      const std::vector<diff_hunk> hunks =
+		diff_lines(versions[0], versions[1]);
+	      const std::string base = base_part(name.gfile());
+	      cssc::Failure written = fmt.unified
+		? write_unified_diff(dfile,
+				     base + "\t" + found[0].as_string(),
+				     base + "\t" + found[1].as_string(),
+				     versions[0], versions[1],
+				     hunks, fmt.context)
+		: write_normal_diff(dfile, versions[0], versions[1], hunks);
+	      if (!written.ok())
+		{
+		  errormsg("write error on temporary file: %s",
+			   written.to_string().c_str());
+		  return 2;
+		}
+	    }
+	  else if (!run_diff(diff_options, versions[0], versions[1],
+			     encoded, dfile))
+	    {
+	      return 2;
+	    }
+
+	  fflush(dfile);
+	  if (0 == ftell(dfile))
+	    {
+	      printf("No differences.\n");
+	      continue;
+	    }
+	  rewind(dfile);
+	  if (use_pr)
+	    {
+	      const std::string header = std::string(argv[i]) + ": "
+		+ sids[0] + " vs. " + sids[1];
+	      std::vector<std::string> args { CONFIG_PR_COMMAND, "-h", header };
+	      if (run_program(args, dfile, NULL) != 0)
+		return 2;
+	    }
+	  else
+	    {
+	      printf("\n------- %s -------\n",
+		     base_part(name.gfile()).c_str());
+	      if (!copy_stream(dfile, stdout))
+		{
+		  errormsg_with_errno("write error on stdout");
+		  return 2;
+		}
+	    }
+	}
+      catch (const CsscExitvalException& e)
+	{
+	  return e.exitval;
+	}
+    }
+  return 0;
+}
+
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  sccsdiff_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return sccsdiff_main(argc, argv);
+}
+#endif
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
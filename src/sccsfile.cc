@@ -108,7 +108,7 @@ sccs_file::get_module_name() const
 sccs_file::sccs_file(sccs_name &n, sccs_file_open_mode m,
 		     ParserOptions opts)
   : flags(),
-    name_(n), checksum_valid_(false), mode_(m), xfile_created_(false), edit_mode_ok_(true),
+    name_(n), checksum_valid_(false), stored_sum_(0), mode_(m), xfile_created_(false), edit_mode_ok_(true),
     sfile_executable_(false),
     delta_table_(make_unique_cssc_delta_table()),
     body_scanner_(), users_(), comments_()
@@ -193,6 +193,7 @@ sccs_file::sccs_file(sccs_name &n, sccs_file_open_mode m,
     {
       checksum_valid_ = opened->checksum_valid_;
     }
+  stored_sum_ = opened->stored_sum;
   delta_table_ = std::move(opened->delta_table);
   std::swap(opened->users, users_);
 
@@ -518,6 +519,13 @@ sccs_file::gfile_should_be_executable() const
 }
 
 
+bool
+sccs_file::is_encoded() const
+{
+  return flags.encoded;
+}
+
+
 bool
 sccs_file::sfile_should_be_executable() const
 {
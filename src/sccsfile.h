@@ -27,6 +27,7 @@
 #ifndef CSSC__SCCSFILE_H__
 #define CSSC__SCCSFILE_H__
 
+#include <functional>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -45,6 +46,7 @@
 
 class seq_state;        /* seqstate.h */
 class cssc_linebuf;
+class line_list;          /* line-diff.h */
 class FilePosSaver;             // filepos.h
 
 struct delta;
@@ -62,6 +64,20 @@ struct get_status
   }
 };
 
+// What sccs_file::comb() did, or (for a dry run) would have done.
+struct comb_summary
+{
+  unsigned long deltas_before;
+  unsigned long deltas_after;
+  long bytes_before;
+  long bytes_after;
+
+  comb_summary()
+    : deltas_before(0), deltas_after(0), bytes_before(0), bytes_after(0)
+  {
+  }
+};
+
 class sccs_file
 {
 public:
@@ -122,7 +138,14 @@ public:
 		 sccs_pfile &pfile,
 		 sccs_pfile::iterator it,
                  const std::vector<std::string>& mrs, const std::vector<std::string>& comments,
-                 bool display_diff_output);
+                 bool display_diff_output,
+		 line_list *new_version);
+
+  // Writes out the new version kept by add_delta(), as "get" would.
+  cssc::FailureOr<get_status> get_new_version(FILE *out,
+					      const std::string& gname,
+					      const sid& id,
+					      const line_list& new_version);
 
   // TODO: return cssc::Failure instead of bool?
   bool admin(const char *file_comment,
@@ -152,8 +175,18 @@ public:
   // The caller must check edit_mode_permitted() before calling cdc().
   void cdc(delta*, const std::vector<std::string>& mrs, const std::vector<std::string>& comments);
   cssc::Failure rmdel(sid rid);
+  // Rewrite the file keeping only the deltas for which |keep| is
+  // true (or, if it is empty, those with no successor), and the
+  // deltas at which their lines of descent branch.  Lines which
+  // appear in none of these deltas are dropped.  If |dry_run| is set
+  // the file itself is not changed.
+  cssc::FailureOr<comb_summary> comb(std::function<bool(const delta&)> keep,
+				     bool dry_run);
   // TODO: return cssc::Failure instead of bool?
-  bool validate() const;
+  // If |check_body| is set, the body is checked too, and the checksum
+  // is computed in the same pass (so the file can be opened with
+  // ParserOptions::set_defer_checksum()).
+  bool validate(bool check_body = false) const;
 
   ////////////////////////////////////////////////////////////////////////
 
@@ -188,6 +221,13 @@ public:
   // TODO: return cssc::Failure instead of bool?
   bool test_locks(sid got, const sccs_pfile&) const;
 
+  // Reconstruct two versions of the file in a single pass over the
+  // body, for sccsdiff.  The lines are as stored in the body, that is,
+  // without keyword expansion and (for encoded files) still encoded.
+  cssc::Failure get_versions(sid first, sid second,
+			     line_list *first_lines,
+			     line_list *second_lines);
+
 
   // TODO: return cssc::Failure instead of bool?
   bool update_checksum();
@@ -218,6 +258,7 @@ public:
   void set_expanded_keyword_flag(const char *s);
   void set_type_flag(const char *s);
   bool gfile_should_be_executable() const;
+  bool is_encoded() const;
 
 
   /* Used by get.cc (implemented in sccsfile.cc) */
@@ -233,6 +274,7 @@ public:
   bool validate_seq_lists(const delta_iterator& d) const;
   // TODO: return cssc::Failure instead of bool?
   bool validate_isomorphism() const;
+  bool validate_body() const;
   // TODO: return cssc::Failure instead of bool?
   bool check_loop_free(cssc_delta_table* t,
 		       seq_no starting_seq,
@@ -282,8 +324,6 @@ private:
   /* sf-kw.cc */
   void no_id_keywords(const char name[]) const;
 
-  cssc::Failure check_keywords_in_file(const char *name);
-
   // Because we now have a pointer member, don't use the compiler's
   // default assignment and constructor.
   const sccs_file& operator=(const sccs_file&) = delete; // not allowed to use!
@@ -293,7 +333,7 @@ private:
   static bool is_known_keyword_char(char c);
 
   cssc::FailureOr<bool> emit_keyletter_expansion(FILE *out, struct subst_parms *parms, const delta& d, char c) const;
-  cssc::Failure write_subst(const char *start,
+  cssc::Failure write_subst(const char *start, size_t len,
 			    struct subst_parms *parms,
 			    struct delta const& gotten_delta,
 			    bool force_expansion) const;
@@ -339,6 +379,7 @@ private:
 
   sccs_name& name_;
   bool checksum_valid_;
+  int stored_sum_;
   enum sccs_file_open_mode mode_;
   bool xfile_created_;
   bool edit_mode_ok_;
@@ -80,10 +80,8 @@ public:
   // The sfile is the name of the history file itself.
   std::string sfile() const { return sname_; }
 
-  // The dfile is a temporary file generated during the operation of
-  // "delta" containing the gotten body against which we perform a
-  // diff.
-  // The d-file is created in the SCCS directory (XXX: correct?)
+  // The dfile is where "delta" used to put the previous version for
+  // diff(1).  We no longer create it, but delta still removes it.
   std::string dfile() const { return sub_file('d'); }
 
   // The gfile is the default name of the output of "get".
@@ -125,9 +123,9 @@ public:
     // TODO: assert that it's locked?
     if (--lock_cnt_ == 0)
       {
-	// Releasing the unique_ptr deletes the lock object which
+	// Resetting the unique_ptr deletes the lock object which
 	// releases the lock.
-	lock_.release();
+	lock_.reset();
       }
   }
 
@@ -45,10 +45,9 @@ seq_state::seq_state(seq_no l)
   initial_condition.non_recursive = false;
   initial_condition.active = false;
   initial_condition.command = '\0';
-  for (decltype(last_) i = 0; i <= last_; ++i)
-    {
-      states_.push_back(initial_condition);
-    }
+  // last_ may be the largest seq_no there is, so we must not count
+  // up to it in a seq_no.
+  states_.assign(static_cast<size_t>(last_) + 1u, initial_condition);
   decide_disposition();
 }
 
@@ -165,8 +164,9 @@ seq_state::decide_disposition()
   seq_no our_highest_delete         = 0u;
   seq_no owner_of_current_insertion = 0u;
 
-  for (seq_no s=0; s <= last_; ++s)
+  for (size_t i = 0; i <= last_; ++i)
     {
+      const seq_no s = static_cast<seq_no>(i);
       const one_state& current = states_[s];
       if (!current.active)
 	{
@@ -0,0 +1,598 @@
+/*
+ * sf-comb.cc: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ *
+ * Members of the class sccs_file used for combing an SCCS file, that
+ * is, rewriting it with fewer deltas.
+ *
+ */
+
+#include <config.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <sys/stat.h>
+
+#include "cssc.h"
+#include "body-scanner.h"
+#include "delta.h"
+#include "delta-table.h"
+#include "failure.h"
+#include "ioerr.h"
+#include "linebuf.h"
+#include "sccsfile.h"
+#include "seqstate.h"
+
+namespace
+{
+  // One group of the deltas kept by comb in which a line appears:
+  // the line is inserted by |top| and deleted by each of |exits|.
+  struct line_owner
+  {
+    size_t top;
+    std::vector<size_t> exits;
+
+    bool operator==(const line_owner& other) const
+    {
+      return top == other.top && exits == other.exits;
+    }
+  };
+
+  // Works out which deltas insert and delete a line which appears in
+  // the kept deltas marked in |visible|.  |parent| gives the index of
+  // the predecessor of each kept delta, or |none|; predecessors come
+  // before their successors.  There is only one group unless some
+  // delta has include or exclude lists.
+  std::vector<line_owner> find_owners(const std::vector<bool>& visible,
+				      const std::vector<size_t>& parent,
+				      size_t none)
+  {
+    std::vector<line_owner> owners;
+    std::vector<size_t> group(parent.size(), 0);
+    for (size_t i = 0; i < parent.size(); ++i)
+      {
+	const size_t p = parent[i];
+	if (visible[i])
+	  {
+	    if (none == p || !visible[p])
+	      {
+		group[i] = owners.size();
+		owners.push_back(line_owner{i, std::vector<size_t>()});
+	      }
+	    else
+	      {
+		group[i] = group[p];
+	      }
+	  }
+	else if (none != p && visible[p])
+	  {
+	    owners[group[p]].exits.push_back(i);
+	  }
+      }
+    return owners;
+  }
+
+  // The kept deltas, numbered in preorder so that we can tell in
+  // constant time whether one is an ancestor of another.  |none| must
+  // be the number of kept deltas.
+  class kept_tree
+  {
+  public:
+    kept_tree(const std::vector<size_t>& parent, size_t none)
+      : first_(parent.size(), 0u), size_(parent.size(), 1u)
+    {
+      ASSERT(none == parent.size());
+      for (size_t i = parent.size(); i-- > 0; )
+	{
+	  if (none != parent[i])
+	    size_[parent[i]] += size_[i];
+	}
+      // next[p] is the first free number in the subtree of p, and
+      // next[none] the first one after all the trees seen so far.
+      std::vector<size_t> next(parent.size() + 1u, 0u);
+      for (size_t i = 0; i < parent.size(); ++i)
+	{
+	  first_[i] = next[parent[i]];
+	  next[parent[i]] += size_[i];
+	  next[i] = first_[i] + 1u;
+	}
+    }
+
+    // Is |a| the same as |b| or one of its ancestors?
+    bool contains(size_t a, size_t b) const
+    {
+      return first_[a] <= first_[b] && first_[b] < first_[a] + size_[a];
+    }
+
+  private:
+    std::vector<size_t> first_, size_;
+  };
+
+  // Follows the control lines of the body and works out the groups of
+  // kept deltas in which each text line appears.
+  class comb_visibility
+  {
+  public:
+    virtual ~comb_visibility()
+    {
+    }
+
+    virtual std::pair<bool, std::string> control(char command, seq_no seq) = 0;
+
+    // The groups in which the current text line appears.
+    virtual const std::vector<line_owner>& owners() = 0;
+  };
+
+  // When no delta has include or exclude lists, each version is made
+  // of its own delta and its ancestors.  A line then appears in a
+  // version if and only if the innermost open insertion belongs to
+  // the version and no deletion within it does.  Each delta belongs to
+  // the ancestors of the kept deltas in one subtree of kept deltas,
+  // so we can read the group off the open blocks directly, and the
+  // cost does not grow with the number of kept deltas.
+  class ancestry_visibility : public comb_visibility
+  {
+  public:
+    // owner[s] is the kept delta whose subtree holds the kept
+    // descendants of serial number s, or |none| if there are none.
+    ancestry_visibility(seq_no highest, const std::vector<size_t>& owner,
+			const kept_tree& tree, size_t none)
+      : owner_(owner), tree_(tree), none_(none),
+	active_(highest + 1u, 0), inserting_(), deleting_(),
+	owners_(), stale_(true)
+    {
+    }
+
+    std::pair<bool, std::string> control(char command, seq_no seq) override
+    {
+      stale_ = true;
+      if ('E' == command)
+	{
+	  if (0 == active_[seq])
+	    return std::make_pair(false, std::string("unmatched ^AE"));
+	  std::vector<seq_no>& blocks =
+	    ('I' == active_[seq]) ? inserting_ : deleting_;
+	  blocks.erase(std::find(blocks.begin(), blocks.end(), seq));
+	  active_[seq] = 0;
+	}
+      else
+	{
+	  if (0 != active_[seq])
+	    return std::make_pair(false, std::string("block is already open"));
+	  active_[seq] = command;
+	  ('I' == command ? inserting_ : deleting_).push_back(seq);
+	}
+      return std::make_pair(true, std::string());
+    }
+
+    const std::vector<line_owner>& owners() override
+    {
+      if (stale_)
+	{
+	  stale_ = false;
+	  owners_.clear();
+	  seq_no top_seq = 0;
+	  for (seq_no s : inserting_)
+	    top_seq = std::max(top_seq, s);
+	  if (0 == top_seq || none_ == owner_[top_seq])
+	    return owners_;
+
+	  line_owner group{owner_[top_seq], std::vector<size_t>()};
+	  for (seq_no s : deleting_)
+	    {
+	      // Only deletions inside the insertion matter.
+	      if (s < top_seq || none_ == owner_[s])
+		continue;
+	      const size_t e = owner_[s];
+	      if (tree_.contains(e, group.top))
+		return owners_;	// Deleted wherever it is inserted.
+	      if (tree_.contains(group.top, e))
+		group.exits.push_back(e);
+	    }
+	  // Keep only the outermost deletions.  Ancestors come first.
+	  std::sort(group.exits.begin(), group.exits.end());
+	  std::vector<size_t> outer;
+	  for (size_t e : group.exits)
+	    {
+	      bool inside = false;
+	      for (size_t o : outer)
+		inside = inside || tree_.contains(o, e);
+	      if (!inside)
+		outer.push_back(e);
+	    }
+	  group.exits.swap(outer);
+	  owners_.push_back(group);
+	}
+      return owners_;
+    }
+
+  private:
+    const std::vector<size_t>& owner_;
+    const kept_tree& tree_;
+    size_t none_;
+    std::vector<char> active_;
+    std::vector<seq_no> inserting_, deleting_;
+    std::vector<line_owner> owners_;
+    bool stale_;
+  };
+
+  // With include or exclude lists, we follow the body once for each
+  // kept delta, as get would.
+  class listed_visibility : public comb_visibility
+  {
+  public:
+    listed_visibility(std::vector<std::unique_ptr<seq_state> > states,
+		      const std::vector<size_t>& parent, size_t none)
+      : states_(std::move(states)), parent_(parent), none_(none),
+	visible_(states_.size(), false), owners_(), stale_(true)
+    {
+    }
+
+    std::pair<bool, std::string> control(char command, seq_no seq) override
+    {
+      stale_ = true;
+      for (auto& state : states_)
+	{
+	  std::pair<bool, std::string> outcome =
+	    ('E' == command) ? state->end(seq) : state->start(seq, command);
+	  if (!outcome.first)
+	    return outcome;
+	}
+      return std::make_pair(true, std::string());
+    }
+
+    const std::vector<line_owner>& owners() override
+    {
+      if (stale_)
+	{
+	  stale_ = false;
+	  for (size_t i = 0; i < states_.size(); ++i)
+	    visible_[i] = states_[i]->include_line() != 0;
+	  owners_ = find_owners(visible_, parent_, none_);
+	}
+      return owners_;
+    }
+
+  private:
+    std::vector<std::unique_ptr<seq_state> > states_;
+    const std::vector<size_t>& parent_;
+    size_t none_;
+    std::vector<bool> visible_;
+    std::vector<line_owner> owners_;
+    bool stale_;
+  };
+
+  cssc::Failure write_control(FILE *out, char c, size_t seq)
+  {
+    if (fprintf(out, "\001%c %lu\n", c, static_cast<unsigned long>(seq)) < 0)
+      return cssc::make_failure_from_errno(errno);
+    return cssc::Failure::Ok();
+  }
+
+  // The kept delta with index i has the serial number i + 1.
+  cssc::Failure open_owner(FILE *out, const line_owner& owner)
+  {
+    cssc::Failure done = write_control(out, 'I', owner.top + 1u);
+    for (size_t e : owner.exits)
+      {
+	if (!done.ok())
+	  break;
+	done = write_control(out, 'D', e + 1u);
+      }
+    return done;
+  }
+
+  cssc::Failure close_owner(FILE *out, const line_owner& owner)
+  {
+    cssc::Failure done = cssc::Failure::Ok();
+    for (auto e = owner.exits.crbegin(); done.ok() && e != owner.exits.crend(); ++e)
+      done = write_control(out, 'E', *e + 1u);
+    if (done.ok())
+      done = write_control(out, 'E', owner.top + 1u);
+    return done;
+  }
+}
+
+cssc::FailureOr<comb_summary>
+sccs_file::comb(std::function<bool(const delta&)> keep, bool dry_run)
+{
+  if (!dry_run)
+    {
+      cssc::Failure can_edit = edit_mode_permitted(true);
+      if (!can_edit.ok())
+	return can_edit;
+    }
+
+  comb_summary summary;
+  struct stat st;
+  if (0 == stat(name_.c_str(), &st))
+    summary.bytes_before = static_cast<long>(st.st_size);
+  summary.deltas_before = delta_table_->size();
+
+  // Choose the deltas to keep.  Serial numbers are visited from the
+  // highest down, so each delta is seen after all its successors.
+  const seq_no highest = highest_delta_seqno();
+  std::vector<bool> kept(highest + 1u, false);
+  std::vector<bool> has_successor(highest + 1u, false);
+  for (size_t i = 0; i < delta_table_->size(); ++i)
+    {
+      const delta& d = delta_table_->at(i);
+      if (!d.removed())
+	has_successor[d.prev_seq()] = true;
+    }
+  for (size_t i = 0; i < delta_table_->size(); ++i)
+    {
+      const delta& d = delta_table_->at(i);
+      if (!d.removed())
+	kept[d.seq()] = keep ? keep(d) : !has_successor[d.seq()];
+    }
+  // We also keep each delta which has kept deltas in more than one
+  // of its lines of descent, so that the lines of descent still meet.
+  std::vector<unsigned> kept_lines(highest + 1u, 0u);
+  for (seq_no s = highest; s > 0; --s)
+    {
+      if (!delta_table_->delta_at_seq_exists(s))
+	continue;
+      if (kept_lines[s] > 1u)
+	kept[s] = true;
+      if (kept[s] || kept_lines[s])
+	++kept_lines[delta_table_->delta_at_seq(s).prev_seq()];
+    }
+
+  std::vector<seq_no> kept_seqs;
+  std::vector<size_t> index_of(highest + 1u, 0);
+  for (unsigned s = 1; s <= highest; ++s)
+    {
+      if (kept[s])
+	{
+	  index_of[s] = kept_seqs.size();
+	  kept_seqs.push_back(seq_no(s));
+	}
+    }
+  const size_t n = kept_seqs.size();
+  if (0 == n)
+    {
+      return cssc::make_failure_builder(cssc::errorcode::UsagePreconditionFailureSidNotFound)
+	.diagnose() << "no deltas of " << name_.sfile() << " would be kept";
+    }
+  const size_t none = n;
+  std::vector<size_t> parent(n, none);
+  for (size_t i = 0; i < n; ++i)
+    {
+      seq_no p = delta_table_->delta_at_seq(kept_seqs[i]).prev_seq();
+      while (p > 0 && !kept[p])
+	p = delta_table_->delta_at_seq(p).prev_seq();
+      if (p > 0)
+	parent[i] = index_of[p];
+    }
+
+  // owner[s] is the kept delta which is s or the nearest kept
+  // descendant of s; it is unique, as we keep the deltas where lines
+  // of descent meet.
+  std::vector<size_t> owner(highest + 1u, none);
+  bool any_lists = false;
+  for (seq_no s = highest; s > 0; --s)
+    {
+      if (!delta_table_->delta_at_seq_exists(s))
+	continue;
+      const delta& d = delta_table_->delta_at_seq(s);
+      if (kept[s])
+	owner[s] = index_of[s];
+      if (none != owner[s] && d.prev_seq() > 0 && !kept[d.prev_seq()])
+	owner[d.prev_seq()] = owner[s];
+      if (!d.removed() && (!d.get_included_seqnos().empty()
+			   || !d.get_excluded_seqnos().empty()
+			   || !d.get_ignored_seqnos().empty()))
+	any_lists = true;
+    }
+  const kept_tree tree(parent, none);
+
+  // Include and exclude lists make the versions depend on more than
+  // ancestry, and then we fall back on one seq_state per kept delta.
+  // This takes time proportional to the number of kept deltas times
+  // the number of deltas for each control line.
+  auto make_visibility = [&]() -> std::unique_ptr<comb_visibility>
+    {
+      if (!any_lists)
+	{
+	  return std::unique_ptr<comb_visibility>(
+	      new ancestry_visibility(highest, owner, tree, none));
+	}
+      std::vector<std::unique_ptr<seq_state> > states;
+      for (seq_no s : kept_seqs)
+	{
+	  states.emplace_back(new seq_state(highest));
+	  prepare_seqstate(*states.back(), s, sid_list(), sid_list(),
+			   sccs_date());
+	}
+      return std::unique_ptr<comb_visibility>(
+	  new listed_visibility(std::move(states), parent, none));
+    };
+
+  // The first pass counts the lines each kept delta will insert and
+  // delete.  A kept delta differs from its parent only in those lines,
+  // so that gives us the lines it leaves unchanged too.
+  std::vector<unsigned long> inserted(n, 0ul), deleted(n, 0ul), seen(n, 0ul);
+  std::unique_ptr<comb_visibility> visibility = make_visibility();
+  cssc::Failure scanned =
+    body_scanner_->scan_body(highest,
+			     [&](char command, seq_no seq)
+			     {
+			       return visibility->control(command, seq);
+			     },
+			     [&](const cssc_linebuf&)
+			     {
+			       for (const auto& o : visibility->owners())
+				 {
+				   ++inserted[o.top];
+				   for (size_t e : o.exits)
+				     ++deleted[e];
+				 }
+			       return cssc::Failure::Ok();
+			     });
+  if (!scanned.ok())
+    return scanned;
+  for (size_t i = 0; i < n; ++i)
+    {
+      const unsigned long before = (none == parent[i]) ? 0ul : seen[parent[i]];
+      seen[i] = before + inserted[i] - deleted[i];
+    }
+
+  // The states for the second pass must be prepared from the
+  // original delta table.
+  visibility = make_visibility();
+  std::unique_ptr<cssc_delta_table> combed = make_unique_cssc_delta_table();
+  for (size_t i = 0; i < delta_table_->size(); ++i)
+    {
+      const delta& d = delta_table_->at(i);
+      if (d.removed() || !kept[d.seq()])
+	continue;
+      const size_t k = index_of[d.seq()];
+      const seq_no new_prev = (none == parent[k]) ? 0 : seq_no(parent[k] + 1u);
+      delta nd('D', d.id(), d.date(), d.user(), seq_no(k + 1u), new_prev,
+	       d.mrs(), d.comments());
+      nd.set_idu(inserted[k], deleted[k], seen[k] - inserted[k]);
+      combed->add(nd);
+    }
+  summary.deltas_after = combed->size();
+  delta_table_.swap(combed);
+
+  FILE *out;
+  if (dry_run)
+    {
+      // Write the result somewhere we can measure it.
+      out = tmpfile();
+      if (nullptr == out)
+	{
+	  return cssc::make_failure_builder_from_errno(errno)
+	    .diagnose() << "cannot create a temporary file";
+	}
+      // Like start_update(), leave room for the checksum.
+      if (fputs_failed(fputs("\001h-----\n", out)))
+	{
+	  const int saved_errno = errno;
+	  fclose(out);
+	  return cssc::make_failure_from_errno(saved_errno);
+	}
+    }
+  else
+    {
+      cssc::FailureOr<FILE*> fof = start_update();
+      if (!fof.ok())
+	return fof.fail();
+      out = *fof;
+    }
+  ASSERT(out != NULL);
+
+  // The second pass writes the new body.  Since lines which appear
+  // in none of the kept deltas are dropped, the lines on either side
+  // of them can often share control lines.
+  bool any_lines = false;
+  bool open = false;
+  line_owner open_group;
+  auto write_line = [&](const cssc_linebuf& line) -> cssc::Failure
+    {
+      const std::vector<line_owner>& owners = visibility->owners();
+      if (owners.empty())
+	return cssc::Failure::Ok();
+
+      cssc::Failure done = cssc::Failure::Ok();
+      const bool single = 1u == owners.size();
+      if (open && !(single && owners.front() == open_group))
+	{
+	  done = close_owner(out, open_group);
+	  open = false;
+	}
+      if (done.ok() && !open && single)
+	{
+	  open_group = owners.front();
+	  done = open_owner(out, open_group);
+	  open = true;
+	}
+
+      any_lines = true;
+      for (const auto& owner : owners)
+	{
+	  if (done.ok() && !open)
+	    done = open_owner(out, owner);
+	  if (done.ok())
+	    done = line.write(out);
+	  if (done.ok() && putc_failed(putc('\n', out)))
+	    done = cssc::make_failure_from_errno(errno);
+	  if (done.ok() && !open)
+	    done = close_owner(out, owner);
+	}
+      return done;
+    };
+
+  cssc::Failure written = write(out);
+  if (written.ok())
+    {
+      written = body_scanner_->scan_body(highest,
+					 [&](char command, seq_no seq)
+					 {
+					   return visibility->control(command, seq);
+					 },
+					 write_line);
+    }
+  if (written.ok() && open)
+    written = close_owner(out, open_group);
+  if (written.ok() && !any_lines)
+    {
+      // Like "admin -n", leave an empty insertion for the first delta.
+      written = write_control(out, 'I', 1u);
+      if (written.ok())
+	written = write_control(out, 'E', 1u);
+    }
+  if (written.ok())
+    {
+      summary.bytes_after = ftell(out);
+      if (summary.bytes_after < 0)
+	written = cssc::make_failure_from_errno(errno);
+    }
+  if (!written.ok())
+    {
+      fclose(out);
+      return cssc::make_failure_builder(written)
+	.diagnose() << "failed to write the combed " << name_.sfile();
+    }
+
+  if (dry_run)
+    {
+      // Nothing in the file was changed.
+      fclose(out);
+      return summary;
+    }
+  cssc::Failure updated = end_update(&out);
+  if (!updated.ok())
+    {
+      return cssc::make_failure_builder(updated)
+	.diagnose() << "failed to complete update";
+    }
+  ASSERT(out == NULL);
+  return summary;
+}
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
@@ -26,6 +26,8 @@
  *
  */
 #include <config.h>
+#include <algorithm>
+#include <limits>
 #include <string>
 
 #include <errno.h>
@@ -42,53 +44,57 @@
 #include "delta-iterator.h"
 #include "bodyio.h"
 #include "file.h"
+#include "line-diff.h"
 #include "subst-parms.h"
+#include "ioerr.h"
 
 #undef JAY_DEBUG
 
 
 using cssc::Failure;
 
-class FileDeleter
+namespace
 {
-  std::string name;
-  bool as_real_user;
-  bool armed;
-
-public:
-  FileDeleter(const std::string& s, bool realuser)
-    : name(s), as_real_user(realuser), armed(true) { }
-
-  ~FileDeleter()
-    {
-      if (armed)
-        {
-          const char *s = name.c_str();
-          if (as_real_user)
-	    {
-	      cssc::Failure deleted = unlink_file_as_real_user(s);
-	      if (!deleted.ok())
-		{
-		  errormsg("%s", deleted.to_string().c_str());
-		}
-	    }
-          else
-	    {
-	      if (remove(s) != 0)
-		{
-		  errormsg("%s", strerror(errno));
-		}
-	    }
-        }
-    }
-  void disarm() { armed = false; }
-};
-
+  // Reads the whole of a binary working file into memory, and stores
+  // it in LINES in encoded form, as it will appear in the body.  An
+  // ID keyword is looked for in the data before it is encoded.
+  cssc::Failure read_encoded(FILE *in, line_list *lines, bool *idkw)
+  {
+    std::string data;
+    char buf[BUFSIZ];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) != 0)
+      data.append(buf, n);
+    if (ferror(in))
+      return cssc::make_failure_from_errno(errno);
+
+    *idkw = check_id_keywords(data.data(), data.size());
+
+    // As for encode_stream(), the last line is an empty one.
+    char outbuf[80];
+    size_t pos = 0;
+    do
+      {
+	const size_t len = std::min(data.size() - pos, size_t(45));
+	const size_t bytes = encode_line(data.data() + pos, outbuf, len);
+	lines->append(outbuf, bytes - 1u); // without the newline
+	pos += len;
+	if (0 == len)
+	  break;
+      }
+    while (1);
+    return cssc::Failure::Ok();
+  }
+}  // unnamed namespace
 
 
-/* Adds a new delta to the SCCS file.  It doesn't add the delta to the
-   delta list in sccs_file object, so this should be the last operation
-   performed before the object is destroyed. */
+/* Adds a new delta to the SCCS file.  If NEW_VERSION is null, it
+   doesn't add the delta to the delta list in sccs_file object, so
+   this should be the last operation performed before the object is
+   destroyed.  Otherwise the new delta is added to the delta list and
+   its text is left in *NEW_VERSION (in encoded form, for an encoded
+   file), so that get_new_version() can write it out without reading
+   the SCCS file again. */
 
 bool
 sccs_file::add_delta(const std::string& gname,
@@ -96,69 +102,11 @@ sccs_file::add_delta(const std::string& gname,
 		     sccs_pfile::iterator it,
                      const std::vector<std::string>& new_mrs,
 		     const std::vector<std::string>& new_comments,
-                     bool display_diff_output)
+                     bool display_diff_output,
+		     line_list *new_version)
 {
   ASSERT(mode_ == UPDATE);
 
-  cssc::Failure checked = check_keywords_in_file(gname.c_str());
-  if (!checked.ok())
-    {
-      // This error message concerns any I/O error on the file.  The
-      // "No id keywords" warning, if it is needed, will already have
-      // been issued.
-      errormsg("%s", checked.to_string().c_str());
-      return false;
-    }
-
-  /*
-   * At this point, encode the contents of "gname", and pass
-   * the name of this encoded file to diff, instead of the
-   * name of the binary file itself.
-   */
-  std::string file_to_diff;
-  bool bFileIsInWorkingDir;
-
-  if (flags.encoded)
-    {
-      cssc::Failure encoded = encode_file(gname.c_str(), name_.ufile().c_str());
-      if (!encoded.ok())
-        {
-          return false;
-        }
-
-      file_to_diff = name_.ufile();
-      bFileIsInWorkingDir = false;
-    }
-  else
-    {
-      file_to_diff = gname;
-      bFileIsInWorkingDir = true;
-    }
-
-
-  /* When this function exits, delete the temporary file.
-   */
-  FileDeleter the_cleaner(file_to_diff, bFileIsInWorkingDir);
-  if (!flags.encoded)
-    the_cleaner.disarm();
-
-
-#ifdef CONFIG_UIDS
-  // To reproduce this error you can do something like this:
-  // admin -n -b s.foo && get -e s.foo && cp /bin/sh foo && ( umask 0444; delta s.foo )
-  if (!is_readable(file_to_diff.c_str()))
-    {
-      // This is the file we just wrote.
-      errormsg("File %s (which we just created) is not readable by user %d! "
-	       "Please check your umask.",
-	       file_to_diff.c_str(),
-	       // TODO: do something better here; uid_t may not be
-	       // signed.
-	       static_cast<int>(geteuid()));
-      return false;
-    }
-#endif
-
   const std::string sid_name = it->got.as_string();
   const delta *got_delta = find_delta(it->got);
   if (got_delta == NULL)
@@ -169,6 +117,17 @@ sccs_file::add_delta(const std::string& gname,
         return false;
     }
 
+  // Every delta needs a sequence number of its own.
+  auto seq_no_left = [this]() -> bool
+    {
+      if (delta_table_->highest_seqno() < std::numeric_limits<seq_no>::max())
+	return true;
+      errormsg("%s: Too many deltas; no more can be added.", name_.c_str());
+      return false;
+    };
+  if (!seq_no_left())
+    return false;
+
   // Remember seq number that will be the predecessor of the
   // one for the delta.
   seq_no predecessor_seq = got_delta->seq();
@@ -179,71 +138,46 @@ sccs_file::add_delta(const std::string& gname,
 		   it->include, it->exclude,
 		   sccs_date());
 
-  /* We used to use fcreate here but as shown by the tests in
-   * tests/delta/errorcase.sh, the prior existence of the
-   * d-file doesn't cause an error.
-   *
-   * XXX: slight departure from SCCS behaviour here.  The real thing
-   * appears to issue an unlink(2) followed by a create(2) to create
-   * the file.  If there is a setuid wrapper, but some ordinary user
-   * has sufficient priveleges to create a symlink in the project
-   * directory, it should be possible to exploit that race condition
-   * to create a file of their choice with contents of their choice,
-   * as the user to which the wrapper program is set-user or set-group
-   * ID.  I believe that using the flag O_EXCL as fcreate() does resolves
-   * that problem.
-   */
-  const int xmode = gfile_should_be_executable() ? CREATE_EXECUTABLE : 0;
-  FILE *get_out;
+  // We no longer write the predecessor to a d-file, but SCCS removes
+  // any d-file left by an earlier delta, and so do we (see
+  // tests/delta/errorcase.sh).
+  remove(name_.dfile().c_str());
+
+  // Read the new version of the file into memory.  The body scanner
+  // reconstructs the predecessor and compares the two without any
+  // temporary files.  Binary files are encoded as they are read.
+  // This is the only time we read the working file; we look for ID
+  // keywords at the same time.
+  line_list new_lines;
+  bool found_id = false;
   if (1)
     {
-      cssc::FailureOr<FILE*> fof = fcreate(name_.dfile(), CREATE_EXCLUSIVE | xmode);
-      if (fof.ok())
+      FILE *in = fopen_as_real_user(gname.c_str(),
+				    flags.encoded ? "rb" : "r");
+      if (nullptr == in)
 	{
-	  get_out = *fof;
+	  errormsg_with_errno("%s: cannot open file", gname.c_str());
+	  return false;
 	}
-      else
+      cssc::Failure read = flags.encoded
+	? read_encoded(in, &new_lines, &found_id)
+	: new_lines.read_file(in);
+      fclose(in);
+      if (!read.ok())
 	{
-	  remove(name_.dfile().c_str());
-	  auto fof2 = fcreate(name_.dfile(), CREATE_EXCLUSIVE | xmode);
-	  if (fof2.ok())
-	    {
-	      get_out = *fof2;
-	    }
-	  else
-	    {
-	      const Failure f = cssc::FailureBuilder(fof2.fail())
-		.diagnose() << "cannot create file " << name_.dfile();
-	      errormsg("%s", f.to_string().c_str());
-	      return false;
-	    }
+	  cssc::Failure f = cssc::make_failure_builder(read)
+	    << "read error on " << gname;
+	  errormsg("%s", f.to_string().c_str());
+	  return false;
 	}
-    }
-  FileDeleter another_cleaner(name_.dfile(), false);
-
-  auto w = cssc::optional<std::string>();
-  const struct delta blankdelta;
-  struct subst_parms parms(name_.dfile(), get_module_name(), get_out,
-			   w, blankdelta,
-                           0, sccs_date());
-  seq_state gsstate(sstate);
-  cssc::Failure got = do_get(name_.dfile(), gsstate, parms, /*do_kw_subst=*/0,
-			     /*show_sid=*/0, /*show_module=*/0, /*debug=*/0,
-			     GET_NO_DECODE, /*for_edit=*/false);
-  if (!got.ok())
-    {
-      cssc::Failure f = cssc::make_failure_builder(got)
-	.diagnose()
-	<< "failed to get " << name_.sfile() << " into " << name_.dfile();
-      warning("%s", f.to_string().c_str());
-      return false;
+      if (!flags.encoded)
+	found_id = new_lines.has_id_keywords();
     }
 
-  if (fclose_failed(fclose(get_out)))
-    {
-      errormsg_with_errno("Failed to close temporary file");
-      return false;
-    }
+  // Issue the "No id keywords" warning (or fail, if the i flag is
+  // set) before we write anything.
+  if (!found_id)
+    no_id_keywords(gname.c_str());
 
   // The delta operation consists of:-
   // 1. Writing out the information for the new delta.
@@ -297,6 +231,8 @@ sccs_file::add_delta(const std::string& gname,
           ASSERT(id.valid());
           // add a new automatic "null" release.  Use the same
           // MRs as for the actual delta (is that right?) but
+          if (!seq_no_left())
+            return false;
           seq_no new_seq = delta_table_->next_seqno();
 
           // Set up for adding the next release.
@@ -321,6 +257,8 @@ sccs_file::add_delta(const std::string& gname,
         }
     }
   // assign a sequence number.
+  if (!seq_no_left())
+    return false;
   seq_no new_seq = delta_table_->next_seqno();
 
 #if 1
@@ -380,7 +318,7 @@ sccs_file::add_delta(const std::string& gname,
     }
 
   delta_result result =
-  body_scanner_->delta(name_.dfile(), file_to_diff, highest_delta_seqno(), new_delta.seq(),
+  body_scanner_->delta(new_lines, highest_delta_seqno(), new_delta.seq(),
 		       &sstate, out, display_diff_output);
 
   // The order of things that we do at this point is quite
@@ -407,10 +345,70 @@ sccs_file::add_delta(const std::string& gname,
   printf("%lu inserted\n%lu deleted\n%lu unchanged\n",
          new_delta.inserted(), new_delta.deleted(), new_delta.unchanged());
 
-  if (pfile.update(true).ok())
-    return true;
-  else
+  if (!pfile.update(true).ok())
     return false;
+
+  if (new_version)
+    {
+      // The SCCS file now ends with the new delta; make our delta
+      // table match it.
+      delta_table_->prepend(new_delta);
+      std::swap(*new_version, new_lines);
+    }
+  return true;
+}
+
+
+/* Writes the version NEW_VERSION of the delta ID, which add_delta()
+   has just made, to OUT as "get" would, but without reading the body
+   of the SCCS file.  Keywords are expanded. */
+cssc::FailureOr<get_status>
+sccs_file::get_new_version(FILE *out, const std::string& gname,
+			   const sid& id, const line_list& new_version)
+{
+  const delta *d = find_delta(id);
+  ASSERT(d != NULL);
+
+  struct subst_parms parms(gname, get_module_name(),
+			   out, cssc::optional<std::string>(), *d,
+			   0, sccs_date::now());
+  const size_t lines = new_version.size();
+  for (size_t i = 0; i < lines; ++i)
+    {
+      const char *start = new_version.line(i);
+      const size_t len = new_version.length(i) - 1u; // without the newline
+      cssc::Failure wrote = cssc::Failure::Ok();
+      ++parms.out_lineno;
+      if (flags.encoded)
+	{
+	  char outbuf[80];
+	  const size_t n = decode_line(start, outbuf);
+	  wrote = fwrite_failed(fwrite(outbuf, sizeof(char), n, out), n);
+	}
+      else
+	{
+	  wrote = write_subst(start, len, &parms, *d, false);
+	  if (wrote.ok())
+	    wrote = fputc_failure('\n', out);
+	}
+      if (!wrote.ok())
+	{
+	  return cssc::make_failure_builder(wrote)
+	    << "failed to write to " << gname;
+	}
+    }
+  if (fflush_failed(fflush(out)))
+    {
+      return cssc::make_failure_builder_from_errno(errno)
+	<< "failed to flush output to " << gname;
+    }
+
+  if (!parms.found_id)
+    no_id_keywords(name_.c_str());
+
+  struct get_status status;
+  status.lines = parms.out_lineno;
+  return status;
 }
 
 
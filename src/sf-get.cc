@@ -41,6 +41,7 @@ using std::string;
 #include "delta-table.h"
 #include "linebuf.h"
 #include "bodyio.h"
+#include "subst-parms.h"
 
 // We use @LIBOBJS@ instead now...
 // #ifndef HAVE_STRSTR
@@ -103,9 +104,11 @@ sccs_file::prepare_seqstate_1(seq_state &state, seq_no seq)
 	}
     }
 
-  // Apply any exclusions
-  for (y=1; y<=seq; ++y)
+  // Apply any exclusions.  We count in a wider type than seq_no,
+  // since seq may be the largest seq_no there is.
+  for (size_t i = 1; i <= seq; ++i)
     {
+      y = static_cast<seq_no>(i);
       if (state.is_included(y))
       {
 	const delta &d = delta_table_->delta_at_seq(y);
@@ -168,8 +171,9 @@ sccs_file::prepare_seqstate_1(seq_state &state, seq_no seq)
 
   if (bDebug)
     {
-      for (y=1; y<=seq; ++y)
+      for (size_t i = 1; i <= seq; ++i)
 	{
+	  y = static_cast<seq_no>(i);
 	  const char *msg;
 	  if (state.is_ignored(y))
 	    msg = "ignored";
@@ -186,6 +190,170 @@ sccs_file::prepare_seqstate_1(seq_state &state, seq_no seq)
     }
 }
 
+/* Output the specified version to a file with possible modifications.
+   Most of the actual work is done with a seqstate object that
+   figures out whether or not given line of the SCCS file body
+   should be included in the output file. */
+cssc::FailureOr<get_status>
+sccs_file::get(FILE *out, const std::string& gname,
+	       FILE *summary_file,
+	       sid id, sccs_date cutoff_date,
+               sid_list include, sid_list exclude,
+               bool keywords, cssc::optional<std::string> wstring,
+               bool show_sid, bool show_module, bool debug,
+	       bool for_edit)
+{
+  ASSERT(nullptr != delta_table_);
+
+  seq_state state(highest_delta_seqno());
+  const delta *d = find_delta(id);
+  ASSERT(d != NULL);
+
+  ASSERT(nullptr != delta_table_);
+
+  cssc::Failure edit_allowed = edit_mode_permitted(for_edit);
+  if (!edit_allowed.ok())	// "get -e" on BK files is not allowed
+    return edit_allowed;
+
+  prepare_seqstate(state, d->seq(), include, exclude, cutoff_date);
+
+  // Fix by Mark Fortescue.
+  // Fix Cutoff Date Problem
+  const delta *dparm;
+  bool set=false;
+
+  for (seq_no s = d->seq(); s>0; s--)
+    {
+      if (delta_table_->delta_at_seq_exists(s))
+	{
+	    const struct delta & del = delta_table_->delta_at_seq(s);
+
+	    if (!state.is_excluded(s) && !set)
+	      {
+		dparm = find_delta(del.id());
+		set = true;
+	      }
+	}
+    }
+  if ( !set ) dparm = d;
+  // End of fix
+
+  if (getenv("CSSC_SHOW_SEQSTATE"))
+    {
+      for (seq_no s = d->seq(); s>0; s--)
+        {
+          if (!delta_table_->delta_at_seq_exists(s))
+            {
+              /* skip non-existent seq number */
+              continue;
+            }
+
+          fprintf(stderr, "%4d (", s);
+          delta_table_->delta_at_seq(s).id().dprint(stderr);
+          fprintf(stderr, ") ");
+
+          if (state.is_explicitly_tagged(s))
+            {
+              fprintf(stderr, "explicitly ");
+            }
+
+          if (state.is_ignored(s))
+            {
+              fprintf(stderr, "ignored\n");
+            }
+          else if (state.is_included(s))
+            {
+              fprintf(stderr, "included\n");
+            }
+          else if (state.is_excluded(s))
+            {
+              fprintf(stderr, "excluded");
+            }
+          else
+            {
+              fprintf(stderr, "irrelevant\n");
+            }
+        }
+    }
+
+  if (summary_file)
+    {
+      bool first = true;
+
+      for (seq_no s = d->seq(); s>0; s--)
+        {
+          if (delta_table_->delta_at_seq_exists(s)
+	      && state.is_included(s))
+	    {
+	      const struct delta & it = delta_table_->delta_at_seq(s);
+
+	      fprintf (summary_file, "%s    ",
+		       first ? "" : "\n");
+	      first = false;
+	      it.id().print(summary_file);
+	      fprintf (summary_file, "\t");
+	      it.date().print(summary_file);
+	      fprintf (summary_file, " %s\n", it.user().c_str());
+
+	      for (const std::string& comment : it.comments())
+		{
+		  fprintf (summary_file, "\t%s\n", comment.c_str());
+		}
+	    }
+	}
+      fputc ('\n', summary_file);
+    }
+
+
+
+  // The subst_parms here may not be the Whole Truth since
+  // the cutoff date may affect which version is actually
+  // gotten.  That's taken care of; the correct delta is
+  // passed as a parameter to the substitution function.
+  // (eugh...)
+  // Changed to use dparm not d to deal with Cutoff Date (Mark Fortescue)
+  struct subst_parms parms(gname, get_module_name(),
+			   out, wstring, *dparm,
+                           0, sccs_date::now());
+
+
+  cssc::Failure got = do_get(gname, state, parms, keywords, show_sid, show_module, debug,
+			     false, false);
+  if (!got.ok())
+    {
+      // TODO: verify whether or not we need to delete the g-file.
+      return got;
+    }
+
+  // only issue a warning about there being no keywords
+  // substituted, IF keyword substitution was being done.
+  if (keywords && !parms.found_id)
+    {
+      no_id_keywords(name_.c_str());
+      // this function normally returns.
+    }
+
+  /* Set the return status. */
+  struct get_status goodstatus;
+  goodstatus.lines = parms.out_lineno;
+
+  const size_t highest = highest_delta_seqno();
+  for (size_t i = 1; i <= highest; i++)
+    {
+      const seq_no seq = static_cast<seq_no>(i);
+      if (state.is_explicitly_tagged(seq))
+        {
+          const sid id_of_this_seq = seq_to_sid(seq);
+
+          if (state.is_included(seq))
+            goodstatus.included.push_back(id_of_this_seq);
+          else if (state.is_excluded(seq))
+            goodstatus.excluded.push_back(id_of_this_seq);
+        }
+    }
+  return goodstatus;
+}
+
 cssc::Failure
 sccs_file::do_get(const string& gname,
 		  class seq_state &state,
@@ -208,16 +376,36 @@ sccs_file::do_get(const string& gname,
   else
     outputfn = output_body_line_text;
 
-  auto subst = [this, &parms](const char *start, struct delta const& gotten_delta,
+  auto subst = [this, &parms](const char *start, size_t len,
+			      struct delta const& gotten_delta,
 			      bool force_expansion) -> cssc::Failure
     {
-      return this->write_subst(start, &parms, gotten_delta, force_expansion);
+      return this->write_subst(start, len, &parms, gotten_delta,
+			       force_expansion);
     };
   return body_scanner_->get(gname, *delta_table_, subst,
 			    outputfn, flags.encoded, state, parms,
 			    do_kw_subst, debug, show_module, show_sid);
 }
 
+cssc::Failure
+sccs_file::get_versions(sid first, sid second,
+			line_list *first_lines, line_list *second_lines)
+{
+  const delta *d1 = find_delta(first);
+  const delta *d2 = find_delta(second);
+  ASSERT(d1 != NULL && d2 != NULL);
+
+  seq_state state1(highest_delta_seqno());
+  prepare_seqstate(state1, d1->seq(), sid_list(), sid_list(), sccs_date());
+  seq_state state2(highest_delta_seqno());
+  prepare_seqstate(state2, d2->seq(), sid_list(), sid_list(), sccs_date());
+
+  return body_scanner_->get_lines(highest_delta_seqno(),
+				  state1, first_lines,
+				  state2, second_lines);
+}
+
 /* Local variables: */
 /* mode: c++ */
 /* End: */
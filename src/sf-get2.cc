@@ -103,6 +103,16 @@ sccs_file::find_requested_sid(sid requested, sid &found, bool get_top_delta) con
   // ASSERT(ncomponents != 0);
   ASSERT(ncomponents <= 4);
 
+  // An exact match can only be the delta having that SID, and the
+  // delta table can find that without a search.
+  if (4 == ncomponents)
+    {
+      const delta *d = delta_table_->find(requested);
+      if (d)
+	found = d->id();
+      return d != NULL;
+    }
+
   // Remember the best so far.
   bool got_best = false;
   sid best;
@@ -33,6 +33,7 @@
 #include "seqstate.h"
 #include "delta-iterator.h"
 #include "file.h"
+#include "trace.h"
 
 /* Prepare a seqstate for use by marking which sequence numbers are to
  * be included and which are to be excluded.
@@ -77,6 +78,7 @@ void sccs_file::prepare_seqstate(seq_state &state, seq_no seq,
                                  sid_list include,
                                  sid_list exclude, sccs_date cutoff_date)
 {
+    trace_phase phase("seqstate", name_.sfile());
     prepare_seqstate_1(state, seq);
     prepare_seqstate_2(state, include, exclude, cutoff_date);
 }
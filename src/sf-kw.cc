@@ -25,11 +25,8 @@
 #include <config.h>
 
 #include "cssc.h"
-#include "cleanup.h"
-#include "failure.h"
 #include "sccsfile.h"
 #include "except.h"
-#include "file.h"
 
 
 void sccs_file::no_id_keywords(const char filename[]) const
@@ -43,54 +40,3 @@ void sccs_file::no_id_keywords(const char filename[]) const
       throw CsscNoKeywordsException();
     }
 }
-
-/* Warns or quits if the new delta doesn't include any id keywords */
-
-cssc::Failure
-sccs_file::check_keywords_in_file(const char *filename)
-{
-  FILE *fp = fopen_as_real_user(filename, "r");
-  if (nullptr == fp)
-    {
-      return cssc::make_failure_builder_from_errno(errno)
-	<< "failed to open " << filename << " for reading";
-    }
-  ResourceCleanup closer([fp](){ fclose(fp); });
-  int ch, last;
-
-  last = '\n';
-  errno = 0;
-  while ( EOF != (ch=getc(fp)) )
-    {
-      if ('%' == last && is_id_keyword_letter(ch))
-	{
-	  const int peek = getc(fp);
-	  if (EOF == peek)
-	    break;
-	  if ('%' == peek)
-	    {
-	      // We found an id keyword.
-	      return cssc::Failure::Ok();
-	    }
-	  // TODO: the ungetc() below may be unnecessary; we know that
-	  // ch is a keyword letter, so it cannot be '%'.  If peek is
-	  // not '%', then we saw '%Wz' or something like it.  There
-	  // is probably no need to unget the 'z' since it cannot
-	  // start an id keyword.
-	  if (EOF == ungetc(peek, fp))
-	    break;
-	}
-      last = ch;
-    }
-  const int saved_errno = ferror(fp) ? errno : 0;
-  // Issue the warning or fatal error.  If it's a warning, this
-  // function needs to return successfully so that the delta
-  // operation continues.
-  no_id_keywords(filename);
-  if (saved_errno)
-    {
-      return cssc::make_failure_builder_from_errno(saved_errno)
-	<< "read error on " << filename;
-    }
-  return cssc::Failure::Ok();
-}
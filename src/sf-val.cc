@@ -31,6 +31,7 @@
 #include "delta.h"
 #include "delta-table.h"
 #include "delta-iterator.h"
+#include "body-scanner.h"
 
 
   // Check that there are no loops on the way from s to the first delta.
@@ -124,7 +125,8 @@ namespace {
 bool
 sccs_file::validate_seq_lists(const delta_iterator& d) const
 {
-  const char *sz_sid = d->id().as_string().c_str();
+  const std::string sid_string = d->id().as_string();
+  const char *sz_sid = sid_string.c_str();
   const seq_no highest_seq = delta_table_->highest_seqno();
   const std::string& sname = name_.sfile();
   return (validate_seq_numbers(sname, d->get_included_seqnos(),
@@ -149,13 +151,113 @@ validate_substituted_flags_list(const std::set<char>&)
   return true;
 }
 
+// Read the whole file, checking the checksum and the body, and
+// check that the line counts in the ^As lines agree with the body.
+bool
+sccs_file::validate_body() const
+{
+  const seq_no highest_seq = delta_table_->highest_seqno();
+  std::vector<body_line_counts> counts;
+  int sum = 0;
+  cssc::Failure scanned = body_scanner_->check_whole_file(highest_seq,
+							  &counts, &sum);
+  if (!scanned.ok())
+    {
+      errormsg("%s: %s", name_.c_str(), scanned.to_string().c_str());
+      return false;
+    }
+  if (sum != stored_sum_)
+    {
+      warning("%s: bad checksum "
+	      "(expected=%d, calculated %d).\n",
+	      name_.c_str(), stored_sum_, sum);
+      return false;
+    }
+
+  // The ^As line records line counts of at most 99999.
+  auto capped = [](unsigned long n) { return n > 99999uL ? 99999uL : n; };
+  bool retval = true;
+  // known_size[s] is set when the number of lines in version s follows
+  // from the ^As lines, which is so unless some delta on the way to
+  // it has an include, exclude or ignore list.
+  std::vector<bool> known_size(highest_seq + 1u, false);
+  for (unsigned long i = 1; i <= highest_seq; ++i)
+    {
+      const seq_no s = static_cast<seq_no>(i);
+      const body_line_counts& c = counts[s];
+      if (!delta_table_->delta_at_seq_exists(s)
+	  || delta_table_->delta_at_seq(s).removed())
+	{
+	  if (c.inserted || c.deleted)
+	    {
+	      errormsg("%s: the body has lines for seqno %u, "
+		       "which is not a current delta",
+		       name_.c_str(), static_cast<unsigned>(s));
+	      retval = false;
+	    }
+	  continue;
+	}
+
+      const delta& d = delta_table_->delta_at_seq(s);
+      const std::string sid_string = d.id().as_string();
+      const char *sz_sid = sid_string.c_str();
+      if (capped(c.inserted) != d.inserted())
+	{
+	  errormsg("%s: SID %s: %lu lines inserted, but the body has %lu",
+		   name_.c_str(), sz_sid, d.inserted(), c.inserted);
+	  retval = false;
+	}
+      // An ^AD block can also contain lines which were not in the
+      // version the delta was made from (lines added on another
+      // branch), so the body can only tell us the most it deleted.
+      if (capped(c.deleted) < d.deleted())
+	{
+	  errormsg("%s: SID %s: %lu lines deleted, but the body has "
+		   "only %lu in its ^AD blocks",
+		   name_.c_str(), sz_sid, d.deleted(), c.deleted);
+	  retval = false;
+	}
+
+      const seq_no p = d.prev_seq();
+      if (!d.get_included_seqnos().empty()
+	  || !d.get_excluded_seqnos().empty()
+	  || !d.get_ignored_seqnos().empty()
+	  || (p && (p >= s || !known_size[p])))
+	continue;
+      known_size[s] = true;
+
+      // The lines of the version this delta was made from are either
+      // unchanged or deleted.
+      unsigned long base = 0;
+      if (p)
+	{
+	  const delta& pd = delta_table_->delta_at_seq(p);
+	  base = pd.unchanged() + pd.inserted();
+	}
+      if (base < 99999uL && d.unchanged() < 99999uL && d.deleted() < 99999uL
+	  && d.unchanged() + d.deleted() != base)
+	{
+	  errormsg("%s: SID %s: %lu lines unchanged and %lu deleted, "
+		   "but its predecessor has %lu lines",
+		   name_.c_str(), sz_sid, d.unchanged(), d.deleted(), base);
+	  retval = false;
+	}
+    }
+  return retval;
+}
+
 
 bool
-sccs_file::validate() const
+sccs_file::validate(bool check_body) const
 {
   bool retval = true;
 
-  if (!checksum_ok())
+  if (check_body)
+    {
+      if (!validate_body())
+	return false;
+    }
+  else if (!checksum_ok())
     {
       return false;
     }
@@ -177,7 +279,8 @@ sccs_file::validate() const
     {
       seq_no s = iter->seq();
 
-      const char *sz_sid = iter->id().as_string().c_str();
+      const std::string sid_string = iter->id().as_string();
+      const char *sz_sid = sid_string.c_str();
 
       // validate that the included/excluded/unchanged line counts are valid.
       if (iter->inserted() > 99999uL)
@@ -343,7 +446,7 @@ sccs_file::validate() const
   // TODO: check for unknown flags
   // TODO: check for boolean flags with non-numeric value.
 
-  // TODO: check the body (unclosed deltas, etc.)
+  // The body is checked by validate_body(), if asked for.
 
   return retval;
 }
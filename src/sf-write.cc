@@ -37,6 +37,7 @@
 #include "delta-table.h"
 #include "ioerr.h"
 #include "linebuf.h"
+#include "trace.h"
 #include "failure.h"
 #include "filepos.h"
 #include "file.h"
@@ -194,6 +195,7 @@ sccs_file::write_delta(FILE *out, struct delta const &d) const
 cssc::Failure
 sccs_file::write(FILE *out) const
 {
+  trace_phase phase("write", name_.sfile());
   cssc::Failure result = [this, out]()
     {
       const_delta_iterator iter(delta_table_.get(), delta_selector::all);
@@ -594,6 +596,7 @@ sccs_file::end_update(FILE **pout)
 
       cssc::Failure retval = cssc::Failure::Ok();
 
+      trace_phase phase("rename", name_.sfile());
       if (mode_ != CREATE && remove(name_.c_str()) == -1)
 	{
 	  return cssc::make_failure_builder_from_errno(errno)
@@ -0,0 +1,243 @@
+/*
+ * sfile-cache.cc: Part of GNU CSSC.
+ *
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ *
+ * Members of the class sfile_header_cache.
+ *
+ */
+#include "config.h"
+
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cssc.h"
+#include "body-scanner.h"
+#include "delta.h"
+#include "delta-table.h"
+#include "except.h"
+#include "file.h"
+#include "sfile-cache.h"
+#include "stat-time.h"
+
+bool sfile_header_cache::enabled_ = false;
+
+namespace
+{
+  struct file_identity
+  {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    struct timespec ctime;
+
+    explicit file_identity(const struct stat& st)
+      : dev(st.st_dev), ino(st.st_ino), size(st.st_size),
+	mtime(get_stat_mtime(&st)), ctime(get_stat_ctime(&st))
+    {
+    }
+
+    bool same_inode(const file_identity& other) const
+    {
+      return dev == other.dev && ino == other.ino;
+    }
+
+    bool operator==(const file_identity& other) const
+    {
+      return same_inode(other)
+	&& size == other.size
+	&& same_time(mtime, other.mtime)
+	&& same_time(ctime, other.ctime);
+    }
+
+    static bool same_time(const struct timespec& a, const struct timespec& b)
+    {
+      return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+    }
+  };
+
+  struct cached_header
+  {
+    file_identity id;
+    unsigned long last_used;
+    int computed_sum;
+    int stored_sum;
+    bool has_delta_table;
+    std::vector<delta> deltas;
+    std::vector<std::string> users;
+    std::vector<parsed_flag> flags;
+    std::vector<std::string> comments;
+    long body_offset;
+    long body_line_number;
+  };
+
+  // We only expect to be working on a handful of files at once.
+  const size_t max_entries = 64;
+  std::vector<cached_header> entries;
+  unsigned long use_count = 0;
+
+  bool identify(FILE *f, struct stat *st)
+  {
+    int fd = fileno(f);
+    return fd >= 0 && 0 == fstat(fd, st);
+  }
+
+  cached_header *find(const file_identity& id)
+  {
+    for (auto& e : entries)
+      {
+	if (e.id == id)
+	  {
+	    e.last_used = ++use_count;
+	    return &e;
+	  }
+      }
+    return nullptr;
+  }
+
+  // Returns the entry to overwrite with a header for the file ID.
+  cached_header *slot_for(const file_identity& id)
+  {
+    cached_header *oldest = nullptr;
+    for (auto& e : entries)
+      {
+	if (e.id.same_inode(id))
+	  return &e;		// an out-of-date version of the same file.
+	if (nullptr == oldest || e.last_used < oldest->last_used)
+	  oldest = &e;
+      }
+    if (entries.size() < max_entries)
+      return nullptr;
+    return oldest;
+  }
+}  // unnamed namespace
+
+
+void
+sfile_header_cache::store(FILE *f, const sccs_file_parser::open_result& header)
+{
+  if (!header.checksum_valid_ || header.is_bk)
+    return;
+  struct stat st;
+  if (!identify(f, &st))
+    return;
+
+  const file_identity id(st);
+  cached_header h{id, ++use_count, header.computed_sum, header.stored_sum,
+		  static_cast<bool>(header.delta_table),
+		  std::vector<delta>(), header.users, header.flags,
+		  header.comments, header.body_offset,
+		  header.body_line_number};
+  if (header.delta_table)
+    {
+      const cssc_delta_table& table = *header.delta_table;
+      h.deltas.reserve(table.size());
+      for (cssc_delta_table::size_type i = 0; i < table.size(); ++i)
+	h.deltas.push_back(table.at(i));
+    }
+
+  cached_header *slot = slot_for(id);
+  if (slot)
+    *slot = std::move(h);
+  else
+    entries.push_back(std::move(h));
+}
+
+std::unique_ptr<sccs_file_parser::open_result>
+sfile_header_cache::lookup(const std::string& name, FILE *f)
+{
+  struct stat st;
+  if (!identify(f, &st))
+    return nullptr;
+  const cached_header *h = find(file_identity(st));
+  if (nullptr == h)
+    return nullptr;
+  if (0 != fseek(f, h->body_offset, SEEK_SET))
+    return nullptr;
+
+  auto result = sccs_file_parser::make_unique_open_result();
+  result->computed_sum = h->computed_sum;
+  result->stored_sum = h->stored_sum;
+  result->checksum_valid_ = true;
+  result->is_bk = false;
+  cssc::FailureOr<bool> got = get_open_file_xbits(f);
+  result->is_executable = got.ok() && *got;
+  if (h->has_delta_table)
+    {
+      result->delta_table = make_unique_cssc_delta_table();
+      for (const auto& d : h->deltas)
+	result->delta_table->add(d);
+    }
+  result->users = h->users;
+  result->flags = h->flags;
+  result->comments = h->comments;
+  result->body_offset = h->body_offset;
+  result->body_line_number = h->body_line_number;
+  // The body scanner takes ownership of f.
+  result->body_scanner =
+    make_unique_sccs_file_body_scanner(name, f, h->body_offset,
+				       h->body_line_number);
+  return result;
+}
+
+void
+sfile_header_cache::prime(const std::string& name)
+{
+  enable();
+  struct stat st;
+  if (0 != stat(name.c_str(), &st) || !S_ISREG(st.st_mode))
+    return;
+  if (find(file_identity(st)))
+    return;
+
+  // Any problem with the file will be reported by the command which
+  // uses it, so we parse it without issuing any messages.
+  fflush(stderr);
+  const int saved_stderr = dup(STDERR_FILENO);
+  const int devnull = open("/dev/null", O_WRONLY);
+  if (saved_stderr < 0 || devnull < 0)
+    {
+      if (saved_stderr >= 0)
+	close(saved_stderr);
+      if (devnull >= 0)
+	close(devnull);
+      return;
+    }
+  dup2(devnull, STDERR_FILENO);
+  close(devnull);
+  try
+    {
+      // open_sccs_file() stores the header in the cache.
+      (void) sccs_file_parser::open_sccs_file(name, READ, ParserOptions());
+    }
+  catch (CsscException&)
+    {
+    }
+  dup2(saved_stderr, STDERR_FILENO);
+  close(saved_stderr);
+}
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
@@ -0,0 +1,78 @@
+/*
+ * sfile-cache.h: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Defines the class sfile_header_cache, which remembers the parsed
+ * headers of SCCS files for a process that opens the same files many
+ * times.
+ */
+#ifndef CSSC__SFILE_CACHE_H__
+#define CSSC__SFILE_CACHE_H__
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "delta-table.h"
+#include "parser.h"
+
+/* The cache is used by "sccs batch" in the multicall build (see
+ * sccs.c).  Before running each command, the driver process calls
+ * prime() for the SCCS files named in it; the command then runs in a
+ * child process which inherits the cache and so does not need to
+ * read and parse the header of those files again.
+ *
+ * An entry is only used if the file's device, inode number, size,
+ * modification time and change time are the same as when it was
+ * parsed.  Files are always updated by renaming a new file over the
+ * old one, so this detects any change to the file.  Files with a bad
+ * checksum and BitKeeper files are not cached, because opening them
+ * produces a warning which the command should issue itself.
+ *
+ * The cache is disabled unless prime() or enable() has been called,
+ * so the individual programs are not affected by it.
+ */
+class sfile_header_cache
+{
+public:
+  static void enable() { enabled_ = true; }
+  static bool enabled() { return enabled_; }
+
+  // Parse the SCCS file NAME (quietly) if it is not already cached.
+  static void prime(const std::string& name);
+
+  // Returns the cached header of the open SCCS file F, with a body
+  // scanner which owns F, or nullptr if F is not in the cache (in
+  // which case F is left open).
+  static std::unique_ptr<sccs_file_parser::open_result>
+  lookup(const std::string& name, FILE *f);
+
+  // Remember the parsed header of the open SCCS file F.
+  static void store(FILE *f, const sccs_file_parser::open_result& header);
+
+private:
+  static bool enabled_;
+};
+
+#endif /* CSSC__SFILE_CACHE_H__ */
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
@@ -35,11 +35,61 @@
 #include "sid.h"
 #include "ioerr.h"
 
+namespace
+{
+  // Write N in decimal to BUF, returning the number of characters
+  // written.
+  size_t
+  put_number(char *buf, int n)
+  {
+    char digits[12];
+    size_t len = 0;
+    unsigned int u = n < 0 ? 0u - static_cast<unsigned int>(n)
+      : static_cast<unsigned int>(n);
+    do
+      {
+	digits[len++] = static_cast<char>('0' + u % 10u);
+	u /= 10u;
+      }
+    while (u);
+
+    size_t pos = 0;
+    if (n < 0)
+      buf[pos++] = '-';
+    while (len)
+      buf[pos++] = digits[--len];
+    return pos;
+  }
+}  // unnamed namespace
+
+// Write the SID in its usual form to BUF, which must have room for
+// 48 characters.  Trailing zero components are omitted.
+size_t
+sid::format(char *buf) const
+{
+  size_t len = put_number(buf, rel());
+  if (level())
+    {
+      buf[len++] = '.';
+      len += put_number(buf + len, level());
+      if (branch())
+	{
+	  buf[len++] = '.';
+	  len += put_number(buf + len, branch());
+	  if (sequence())
+	    {
+	      buf[len++] = '.';
+	      len += put_number(buf + len, sequence());
+	    }
+	}
+    }
+  return len;
+}
+
 std::string sid::as_string() const
 {
-  std::ostringstream oss;
-  oss << (*this);
-  return oss.str();
+  char buf[48];
+  return std::string(buf, format(buf));
 }
 
 short int
@@ -54,7 +104,7 @@ get_id_comp(const char *&s) {
 			s++;
 			return static_cast<short int>(n);
 		}
-		if (isdigit(c)) {
+		if (c >= '0' && c <= '9') {
 			n = n * 10 + (c - '0');
 		} else {
 		  return short(-1);
@@ -71,17 +121,18 @@ sid::null_sid()
 }
 
 sid::sid(const char *s)
-  : rel_(-1), level_(0), branch_(0), sequence_(0) {
+  : packed_(0) {
         ASSERT(s != NULL);
-	rel_ = get_id_comp(s);
-	level_ = get_id_comp(s);
-	branch_ = get_id_comp(s);
-	sequence_ = get_id_comp(s);
+	short rel = get_id_comp(s);
+	const short level = get_id_comp(s);
+	const short branch = get_id_comp(s);
+	const short sequence = get_id_comp(s);
 
-	if (*s != '\0' || rel_ == 0 || sequence_ == -1)
+	if (*s != '\0' || rel == 0 || sequence == -1)
 	  {
-	    rel_ = -1;
+	    rel = -1;
 	  }
+	packed_ = pack(rel, level, branch, sequence);
 }
 
 int
@@ -91,81 +142,17 @@ sid::comparable(sid const &id) const
     {
       return 0;
     }
-  if (branch_ != id.branch_)
+  if (branch() != id.branch())
     {
       return 0;
     }
-  if (branch_ != 0 && rel_ != id.rel_ && level_ != id.level_)
+  if (branch() != 0 && rel() != id.rel() && level() != id.level())
     {
       return 0;
     }
   return 1;
 }
 
-int
-sid::gt(sid const &id) const {
-	if (rel_ > id.rel_)
-	  {
-	    return 1;
-	  }
-	if (rel_ != id.rel_)
-	  {
-	    return 0;
-	  }
-	if (level_ > id.level_)
-	  {
-	    return 1;
-	  }
-	if (level_ != id.level_)
-	  {
-	    return 0;
-	  }
-#if 0
-	if (branch_ > id.branch_)
-	  {
-		return 1;
-	}
-	if (branch_ != id.branch_)
-	  {
-		return 0;
-	}
-#endif
-	return sequence_ > id.sequence_;
-}
-
-bool
-sid::gte(sid const &id) const
-{
-  if (rel_ > id.rel_)
-    {
-      return true;
-    }
-  if (rel_ != id.rel_)
-    {
-      return false;
-    }
-  if (level_ > id.level_)
-    {
-      return true;
-    }
-  if (level_ != id.level_)
-    {
-      return false;
-    }
-#if 0
-  // XXX: why is this code commented out?
-  if (branch_ > id.branch_)
-    {
-      return true;
-    }
-  if (branch_ != id.branch_)
-    {
-      return false;
-    }
-#endif
-  return sequence_ >= id.sequence_;
-}
-
 bool
 sid::partial_match(sid const &id) const
 {
@@ -174,32 +161,32 @@ sid::partial_match(sid const &id) const
       return false;
     }
 
-  if (rel_ == 0)
+  if (rel() == 0)
     {
       return true;
     }
-  if (rel_ != id.rel_)
+  if (rel() != id.rel())
     {
       return false;
     }
-  if (level_ == 0)
+  if (level() == 0)
     {
       return true;
     }
-  if (level_ != id.level_)
+  if (level() != id.level())
     {
       return false;
     }
-  if (branch_ == 0)
+  if (branch() == 0)
     {
       return true;
     }
-  if (branch_ != id.branch_)
+  if (branch() != id.branch())
     {
       return false;
     }
-  // TODO: shouldn't this be sequence_ == id.rel_?
-  return sequence_ == 0 || sequence_ == id.rel_;
+  // TODO: shouldn't this be sequence() == id.rel()?
+  return sequence() == 0 || sequence() == id.rel();
 }
 
 sid
@@ -209,26 +196,26 @@ sid::successor() const
     {
       return sid(1, 1, 0, 0);
     }
-  else if (branch_ != 0)
+  else if (branch() != 0)
     {
-      short next_seq = sequence_;
+      short next_seq = sequence();
       ++next_seq;
-      return sid(rel_, level_, branch_, next_seq);
+      return sid(rel(), level(), branch(), next_seq);
     }
   else
     {
-      short next_lev = level_;
+      short next_lev = level();
       ++next_lev;
-      return sid(rel_, next_lev, 0, 0);
+      return sid(rel(), next_lev, 0, 0);
     }
 }
 
 int sid::components() const
 {
-  if (valid() && rel_)
-    if (level_)
-      if (branch_)
-	if (sequence_)
+  if (valid() && rel())
+    if (level())
+      if (branch())
+	if (sequence())
 	  return   4;
 	else
 	  return 3;
@@ -252,7 +239,7 @@ bool sid::matches(const sid &m, int nfields) const
   else
     --nfields;
 
-  if (rel_ != m.rel_)
+  if (rel() != m.rel())
     return false;
 
   if (0 == nfields)
@@ -260,7 +247,7 @@ bool sid::matches(const sid &m, int nfields) const
   else
     --nfields;
 
-  if (level_ != m.level_)
+  if (level() != m.level())
     return false;
 
   if (0 == nfields)
@@ -268,7 +255,7 @@ bool sid::matches(const sid &m, int nfields) const
   else
     --nfields;
 
-  if (branch_ != m.branch_)
+  if (branch() != m.branch())
     return false;
 
   if (0 == nfields)
@@ -276,7 +263,7 @@ bool sid::matches(const sid &m, int nfields) const
   else
     --nfields;
 
-  if (sequence_ != m.sequence_)
+  if (sequence() != m.sequence())
     return false;
 
   return true;
@@ -284,12 +271,12 @@ bool sid::matches(const sid &m, int nfields) const
 
 release sid::get_release() const
 {
-  return rel_;
+  return rel();
 }
 
 relvbr sid::get_relvbr() const
 {
-  return relvbr(rel_, level_, branch_);
+  return relvbr(rel(), level(), branch());
 }
 
 
@@ -297,39 +284,18 @@ cssc::Failure
 sid::print(FILE *out) const
 {
   ASSERT(valid());
-  ASSERT(rel_ != 0);
-
-  if (printf_failed(fprintf(out, "%d", rel_))
-      || (level_ != 0
-	  && (printf_failed(fprintf(out, ".%d", level_))
-	      || (branch_ != 0
-		  && (printf_failed(fprintf(out, ".%d", branch_))
-		      || (sequence_ != 0
-			  && printf_failed(fprintf(out, ".%d",
-						   sequence_))))))))
-    {
-      return cssc::make_failure_from_errno(errno);
-    }
-  return cssc::Failure::Ok();
+  ASSERT(rel() != 0);
+
+  char buf[48];
+  const size_t len = format(buf);
+  return fwrite_failed(fwrite(buf, 1, len, out), len);
 }
 
 
 std::ostream& sid::ostream_insert(std::ostream& os) const
 {
-  os << rel_;
-  if (level_)
-    {
-      os << '.' << level_;
-      if (branch_)
-	{
-	  os << '.' << branch_;
-	  if (sequence_)
-	    {
-	      os << '.' << sequence_;
-	    }
-	}
-    }
-  return os;
+  char buf[48];
+  return os.write(buf, format(buf));
 }
 
 
@@ -342,35 +308,33 @@ sid::printf(FILE *out, char c, bool force_zero /*=false*/) const {
 
 	switch (c) {
 	case 'R':
-		n = rel_;
+		n = rel();
 		break;
 
 	case 'L':
-		n = level_;
+		n = level();
 		break;
 
 	case 'B':
 	        // this field is completely blank for trunk revisions.
-                if (!force_zero && 0 == branch_ && 0 == sequence_)
+                if (!force_zero && 0 == branch() && 0 == sequence())
 		  return cssc::Failure::Ok();
-		n = branch_;
+		n = branch();
 		break;
 
 	case 'S':
 	        // this field is completely blank for trunk revisions.
-                if (!force_zero && 0 == branch_ && 0 == sequence_)
+                if (!force_zero && 0 == branch() && 0 == sequence())
 		  return cssc::Failure::Ok();
-		n = sequence_;
+		n = sequence();
 		break;
 
 	default:
           ASSERT(0);
 	}
-	if (printf_failed(fprintf(out, "%d", n)))
-	  {
-	    return cssc::make_failure_from_errno(errno);
-	  }
-	return cssc::Failure::Ok();
+	char buf[12];
+	const size_t len = put_number(buf, n);
+	return fwrite_failed(fwrite(buf, 1, len, out), len);
 }
 
 /* Local variables: */
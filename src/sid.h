@@ -29,6 +29,8 @@
 #ifndef CSSC__SID_H__
 #define CSSC__SID_H__
 
+#include <cstdint>
+#include <functional>
 #include <ostream>
 #include <string>
 
@@ -42,12 +44,18 @@
 
 
 class sccs_file;
+class sid;
+
+namespace std
+{
+  template <> struct hash<sid>;
+}
 
 class sid
 {
 public:
   sid(short r, short l, short b, short s)
-    : rel_(r), level_(l), branch_(b), sequence_(s)
+    : packed_(pack(r, l, b, s))
   {
     ASSERT((!r && !l && !b && !s)
 	   || (r && !l && !b && !s)
@@ -56,39 +64,32 @@ public:
   }
 
   static sid null_sid();
-  sid(): rel_(-1), level_(0), branch_(0), sequence_(0) {}
+  sid(): packed_(pack(-1, 0, 0, 0)) {}
   sid(const char *s);
   sid(release);		/* Defined below */
   sid(relvbr);		/* Defined below */
 
-  bool is_null() const { return rel_ <= 0; }
-  bool gte(sid const &id) const; // used by sccs_file::find_requested_sid().
-
-  release get_release() const;
-  relvbr get_relvbr() const;
+  bool is_null() const { return rel() <= 0; }
 
-  sid(sid const &id)
-    : rel_(id.rel_), level_(id.level_),
-      branch_(id.branch_), sequence_(id.sequence_)
+  // used by sccs_file::find_requested_sid().  Like gt(), this ignores
+  // the branch component.
+  bool gte(sid const &id) const
   {
+    return (packed_ & ~branch_bits) >= (id.packed_ & ~branch_bits);
   }
 
-  sid &
-  operator=(sid const &id)
-  {
-    rel_ = id.rel_;
-    level_ = id.level_;
-    branch_ = id.branch_;
-    sequence_ = id.sequence_;
-    return *this;
-  }
+  release get_release() const;
+  relvbr get_relvbr() const;
 
-  bool valid() const { return rel_ > 0; }
+  sid(sid const &id) = default;
+  sid & operator=(sid const &id) = default;
+
+  bool valid() const { return rel() > 0; }
 
   bool
   partial_sid() const
   {
-    return level_ == 0 || (branch_ != 0 && sequence_ == 0);
+    return level() == 0 || (branch() != 0 && sequence() == 0);
   }
 
   int components() const;
@@ -116,18 +117,12 @@ public:
 
   bool operator==(sid const &i2) const
   {
-    return rel_ == i2.rel_
-      && level_ == i2.level_
-      && branch_ == i2.branch_
-      && sequence_ == i2.sequence_;
+    return packed_ == i2.packed_;
   }
 
   bool operator!=(sid const &i2) const
   {
-    return rel_ != i2.rel_
-      || level_ != i2.level_
-      || branch_ != i2.branch_
-      || sequence_ != i2.sequence_;
+    return packed_ != i2.packed_;
   }
 
   sid successor() const;
@@ -135,66 +130,43 @@ public:
   sid &
   next_branch()
   {
-    branch_++;
-    sequence_ = 1;
+    packed_ = pack(rel(), level(), static_cast<short>(branch() + 1), 1);
     return *this;
   }
 
   const sid &
   next_level()
   {
-    ++level_;
-    branch_ = sequence_ = 0;
+    packed_ = pack(rel(), static_cast<short>(level() + 1), 0, 0);
     return *this;
   }
 
   sid &
   operator++()
   {
-    if (branch_ != 0)
-      {
-	sequence_++;
-      }
-    else if (level_ != 0)
-      {
-	level_++;
-      }
-    else
-      {
-	rel_++;
-      }
+    // Add one to the last non-zero component.
+    packed_ += one_in_last_component();
     return *this;
   }
 
   sid &
   operator--()
   {
-    if (branch_ != 0)
-      {
-	sequence_--;
-      }
-    else if (level_ != 0)
-      {
-	level_--;
-      }
-    else
-      {
-	rel_--;
-      }
+    packed_ -= one_in_last_component();
     return *this;
   }
 
   bool
   is_trunk_successor(sid const &id) const
   {
-    return branch_ == 0 && *this < id;
+    return branch() == 0 && *this < id;
   }
 
   bool
   branch_greater_than(sid const &id) const
   {
-    return rel_ == id.rel_ && level_ == id.level_
-      && branch_ > id.branch_;
+    return rel() == id.rel() && level() == id.level()
+      && branch() > id.branch();
   }
 
   bool partial_match(sid const &id) const;
@@ -203,15 +175,15 @@ public:
   bool
   release_only() const
   {
-    return rel_ != 0 && level_ == 0;
+    return rel() != 0 && level() == 0;
   }
 
   bool
   trunk_match(sid const &id) const
   {
-    return rel_ == 0
-      || (rel_ == id.rel_ && (level_ == 0
-			    || level_ == id.level_));
+    return rel() == 0
+      || (rel() == id.rel() && (level() == 0
+				|| level() == id.level()));
   }
 
   cssc::Failure print(FILE *f) const;
@@ -220,7 +192,7 @@ public:
   cssc::Failure
   dprint(FILE *f) const
   {
-    if (fprintf(f, "%d.%d.%d.%d", rel_, level_, branch_, sequence_) < 0)
+    if (fprintf(f, "%d.%d.%d.%d", rel(), level(), branch(), sequence()) < 0)
       {
 	return cssc::make_failure_from_errno(errno);
       }
@@ -232,12 +204,78 @@ public:
   std::ostream& ostream_insert(std::ostream&) const;
 
 private:
-  short rel_, level_, branch_, sequence_;
+  friend struct std::hash<sid>;
+
+  // The four components are packed into one integer, release first,
+  // so that equality is one comparison and ordering is one
+  // comparison after masking out the branch.  Each is stored plus
+  // 0x8000, so that the order of the (signed) components is kept.
+  uint64_t packed_;
+
+  static constexpr int rel_shift = 48;
+  static constexpr int level_shift = 32;
+  static constexpr int branch_shift = 16;
+  static constexpr int sequence_shift = 0;
+  static constexpr uint64_t branch_bits = UINT64_C(0xFFFF) << branch_shift;
+
+  static uint64_t
+  pack_one(short value, int shift)
+  {
+    return static_cast<uint64_t>(static_cast<uint16_t>(value + 0x8000))
+      << shift;
+  }
+
+  static uint64_t
+  pack(short r, short l, short b, short s)
+  {
+    return pack_one(r, rel_shift) | pack_one(l, level_shift)
+      | pack_one(b, branch_shift) | pack_one(s, sequence_shift);
+  }
+
+  short
+  component(int shift) const
+  {
+    return static_cast<short>(static_cast<int>((packed_ >> shift) & 0xFFFFu)
+			      - 0x8000);
+  }
+
+  short rel() const { return component(rel_shift); }
+  short level() const { return component(level_shift); }
+  short branch() const { return component(branch_shift); }
+  short sequence() const { return component(sequence_shift); }
 
+  uint64_t
+  one_in_last_component() const
+  {
+    if (branch() != 0)
+      return UINT64_C(1) << sequence_shift;
+    else if (level() != 0)
+      return UINT64_C(1) << level_shift;
+    else
+      return UINT64_C(1) << rel_shift;
+  }
+
+  size_t format(char *buf) const;
   int comparable(sid const &id) const;
-  int gt(sid const &id) const;
+
+  // Compares the release, level and sequence, ignoring the branch.
+  bool gt(sid const &id) const
+  {
+    return (packed_ & ~branch_bits) > (id.packed_ & ~branch_bits);
+  }
 };
 
+namespace std
+{
+  template <> struct hash<sid>
+  {
+    size_t operator()(const sid& s) const noexcept
+    {
+      return hash<uint64_t>()(s.packed_);
+    }
+  };
+}
+
 inline std::ostream& operator<<(std::ostream& os, const sid& s)
 {
   return s.ostream_insert(os);
@@ -246,7 +284,7 @@ inline std::ostream& operator<<(std::ostream& os, const sid& s)
 // TODO: find a better API than "char*&".
 short int get_id_comp(const char *&s);
 
-inline sid::sid(release r): rel_(r), level_(0), branch_(0), sequence_(0) {}
+inline sid::sid(release r): packed_(pack(r, 0, 0, 0)) {}
 
 inline bool operator>(release i1, sid const &i2) { return i1 > i2.get_release(); }
 inline bool operator<(release i1, sid const &i2) { return i1 < i2.get_release(); }
@@ -0,0 +1,166 @@
+/*
+ * trace.cc: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Members of the class trace_phase.
+ */
+#include "config.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "cssc.h"
+#include "event-log.h"
+#include "trace.h"
+
+int trace_phase::state_ = -1;
+
+namespace
+{
+  // Totals of the time spent in each phase, and of the counters.
+  // Allocated on first use and never freed, since we need them
+  // during exit.
+  std::map<std::string, double> *time_totals = nullptr;
+  std::map<std::string, unsigned long> *count_totals = nullptr;
+
+  double
+  wall_seconds()
+  {
+    const std::chrono::duration<double> d =
+      std::chrono::steady_clock::now().time_since_epoch();
+    return d.count();
+  }
+
+  double
+  cpu_seconds()
+  {
+    struct rusage ru;
+    if (0 != getrusage(RUSAGE_SELF, &ru))
+      return 0.0;
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec
+      + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+  }
+
+  double process_wall_start = 0.0;
+
+  // Add the number of bytes this process has read and written
+  // (through any file descriptor) to RECORD.  Only Linux tells us
+  // this, in /proc/self/io; elsewhere we add nothing.
+  void
+  add_io_counts(event_record& record)
+  {
+    FILE *f = fopen("/proc/self/io", "r");
+    if (nullptr == f)
+      return;
+    char line[64];
+    unsigned long n;
+    while (fgets(line, sizeof(line), f))
+      {
+	if (1 == sscanf(line, "rchar: %lu", &n))
+	  record.add("io_read", static_cast<long>(n));
+	else if (1 == sscanf(line, "wchar: %lu", &n))
+	  record.add("io_written", static_cast<long>(n));
+      }
+    fclose(f);
+  }
+
+  template <typename T>
+  void
+  add_to_total(std::map<std::string, T> *&totals,
+	       const std::string& key, T value)
+  {
+    if (nullptr == totals)
+      totals = new std::map<std::string, T>;
+    (*totals)[key] += value;
+  }
+
+  void
+  write_totals()
+  {
+    event_record record(trace_file(), "totals");
+    record.add("wall", wall_seconds() - process_wall_start)
+      .add("cpu", cpu_seconds());
+    add_io_counts(record);
+    if (time_totals)
+      {
+	for (const auto& item : *time_totals)
+	  record.add(item.first.c_str(), item.second);
+      }
+    if (count_totals)
+      {
+	for (const auto& item : *count_totals)
+	  record.add(item.first.c_str(), static_cast<long>(item.second));
+      }
+    record.write();
+  }
+}  // unnamed namespace
+
+
+void
+trace_phase::initialise()
+{
+  const char *name = trace_file();
+  state_ = (name != nullptr && *name != '\0') ? 1 : 0;
+  if (state_ > 0)
+    {
+      process_wall_start = wall_seconds();
+      atexit(write_totals);
+    }
+}
+
+void
+trace_phase::begin(const std::string& file)
+{
+  file_ = file;
+  wall_start_ = wall_seconds();
+  cpu_start_ = cpu_seconds();
+}
+
+void
+trace_phase::end()
+{
+  const double wall = wall_seconds() - wall_start_;
+  const double cpu = cpu_seconds() - cpu_start_;
+
+  event_record record(trace_file(), "phase");
+  record.add("phase", std::string(phase_));
+  if (!file_.empty())
+    record.add_file("file", file_);
+  record.add("wall", wall).add("cpu", cpu);
+  for (const auto& c : counts_)
+    {
+      record.add(c.first, static_cast<long>(c.second));
+      add_to_total(count_totals, std::string(c.first), c.second);
+    }
+  record.write();
+
+  const std::string prefix(phase_);
+  add_to_total(time_totals, prefix + "_wall", wall);
+  add_to_total(time_totals, prefix + "_cpu", cpu);
+}
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
@@ -0,0 +1,109 @@
+/*
+ * trace.h: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Defines the class trace_phase, which records the time taken by
+ * each phase of the work of a program.
+ */
+#ifndef CSSC__TRACE_H__
+#define CSSC__TRACE_H__
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/* If the environment variable CSSC_TRACE names a file, a record (see
+ * event-log.h) is appended to it at the end of each phase, giving
+ * its name, the file it worked on, the wall-clock and CPU time it
+ * took (in seconds) and any counters attached to it:
+ *
+ *   {"time":...,"pid":...,"program":"get","event":"phase",
+ *    "phase":"body","file":"/src/s.foo","wall":0.0021,"cpu":0.0020,
+ *    "body_lines":5120,"control_lines":96,"output_lines":4800}
+ *
+ * When the program exits, a "totals" record gives the total of each
+ * counter, the total time spent in each phase (as "body_wall",
+ * "body_cpu" and so on), the CPU time of the whole process, the
+ * wall-clock time since the first phase began and, where the system
+ * tells us, the number of bytes read and written ("io_read",
+ * "io_written").
+ *
+ * When CSSC_TRACE is unset, a trace_phase does nothing beyond
+ * testing a flag, so callers can count things in local variables
+ * and pass them to count() without testing whether tracing is on.
+ */
+class trace_phase
+{
+public:
+  trace_phase(const char *phase, const std::string& file)
+    : active_(trace_enabled()), phase_(phase), file_(), wall_start_(0.0),
+      cpu_start_(0.0), counts_()
+  {
+    if (active_)
+      begin(file);
+  }
+
+  ~trace_phase()
+  {
+    if (active_)
+      end();
+  }
+
+  void count(const char *counter, unsigned long n)
+  {
+    if (active_)
+      counts_.push_back(std::make_pair(counter, n));
+  }
+
+  bool active() const
+  {
+    return active_;
+  }
+
+  static bool trace_enabled()
+  {
+    if (state_ < 0)
+      initialise();
+    return state_ > 0;
+  }
+
+private:
+  trace_phase(const trace_phase&) = delete;
+  trace_phase& operator=(const trace_phase&) = delete;
+
+  void begin(const std::string& file);
+  void end();
+  static void initialise();
+
+  static int state_;		// -1 until we have looked at CSSC_TRACE.
+
+  bool active_;
+  const char *phase_;
+  std::string file_;
+  double wall_start_;
+  double cpu_start_;
+  std::vector<std::pair<const char*, unsigned long> > counts_;
+};
+
+#endif /* CSSC__TRACE_H__ */
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
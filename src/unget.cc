@@ -32,20 +32,21 @@
 #include "fileiter.h"
 #include "pfile.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "version.h"
 #include "except.h"
 #include "file.h"
 
 
 void
-usage() {
+unget_usage() {
 	fprintf(stderr,
 "usage: %s [-nsV] [-r SID] file ...\n",
 		prg_name);
 }
 
 int
-main(int argc, char **argv)
+unget_main(int argc, char **argv)
 {
   Cleaner arbitrary_name;
   int c;
@@ -172,6 +173,21 @@ main(int argc, char **argv)
   return retval;
 }
 
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  unget_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return unget_main(argc, argv);
+}
+#endif
+
 /* Local variables: */
 /* mode: c++ */
 /* End: */
@@ -0,0 +1,298 @@
+/*
+ * val-cache.cc: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Members of the class val_cache.
+ *
+ */
+#include "config.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cssc.h"
+#include "ioerr.h"
+#include "privs.h"
+#include "quit.h"
+#include "stat-time.h"
+#include "val-cache.h"
+
+namespace
+{
+  const char cache_header[] = "# CSSC val cache, version 1\n";
+
+  std::string entry_line(const val_cache::identity& id, bool body_checked,
+			 const std::string& name)
+  {
+    char prefix[128];
+    snprintf(prefix, sizeof(prefix), "%llu %llu %lld %ld %ld %d %c ",
+	     static_cast<unsigned long long>(id.dev),
+	     static_cast<unsigned long long>(id.ino),
+	     static_cast<long long>(id.size),
+	     id.mtime_sec, id.mtime_nsec, id.stored_sum,
+	     body_checked ? 'b' : 'h');
+    return prefix + name + "\n";
+  }
+}  // unnamed namespace
+
+
+bool
+val_cache::identity::operator==(const identity& other) const
+{
+  return dev == other.dev
+    && ino == other.ino
+    && size == other.size
+    && mtime_sec == other.mtime_sec
+    && mtime_nsec == other.mtime_nsec
+    && stored_sum == other.stored_sum;
+}
+
+
+val_cache::val_cache(const std::string& filename)
+  : filename_(filename), hits_(0uL), misses_(0uL)
+{
+}
+
+
+bool
+val_cache::identify(const std::string& name, identity *id)
+{
+  const int fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  // The first line of an SCCS file is "^Ahnnnnn".
+  struct stat st;
+  char line[7];
+  const bool got = 0 == fstat(fd, &st)
+    && sizeof(line) == static_cast<size_t>(read(fd, line, sizeof(line)));
+  close(fd);
+  if (!got || '\001' != line[0] || 'h' != line[1])
+    return false;
+
+  int sum = 0;
+  for (size_t i = 2u; i < sizeof(line); ++i)
+    {
+      if (line[i] < '0' || line[i] > '9')
+	return false;
+      sum = sum * 10 + (line[i] - '0');
+    }
+
+  const struct timespec mtime = get_stat_mtime(&st);
+  id->dev = st.st_dev;
+  id->ino = st.st_ino;
+  id->size = st.st_size;
+  id->mtime_sec = static_cast<long>(mtime.tv_sec);
+  id->mtime_nsec = mtime.tv_nsec;
+  id->stored_sum = sum;
+  return true;
+}
+
+
+// Reads the entries in the cache file F into *ENTRIES, a later line
+// for a file replacing an earlier one.  Sets *LINES to the number of
+// entry lines read.  Returns false if F is not a cache file at all.
+bool
+val_cache::read_entries(FILE *f, entry_map *entries, unsigned long *lines)
+{
+  *lines = 0uL;
+  char *buf = NULL;
+  size_t buflen = 0u;
+  ssize_t len = getline(&buf, &buflen, f);
+  if (len < 0 || 0 != strcmp(buf, cache_header))
+    {
+      free(buf);
+      return false;
+    }
+
+  while ((len = getline(&buf, &buflen, f)) > 0)
+    {
+      if ('\n' != buf[len - 1])
+	break;			// a line which was never finished.
+      buf[len - 1] = '\0';
+
+      unsigned long long dev, ino;
+      long long size;
+      long mtime_sec, mtime_nsec;
+      int sum, name_start = -1;
+      char level;
+      if (7 != sscanf(buf, "%llu %llu %lld %ld %ld %d %c %n",
+		      &dev, &ino, &size, &mtime_sec, &mtime_nsec, &sum,
+		      &level, &name_start)
+	  || name_start < 0)
+	{
+	  continue;		// not one of ours; ignore it.
+	}
+
+      entry e;
+      e.id.dev = static_cast<dev_t>(dev);
+      e.id.ino = static_cast<ino_t>(ino);
+      e.id.size = static_cast<off_t>(size);
+      e.id.mtime_sec = mtime_sec;
+      e.id.mtime_nsec = mtime_nsec;
+      e.id.stored_sum = sum;
+      e.body_checked = ('b' == level);
+      e.name = buf + name_start;
+
+      // Checking only the header of a file does not undo an earlier
+      // check of its body.
+      entry& slot = (*entries)[key(e.id.dev, e.id.ino)];
+      if (slot.id == e.id && slot.body_checked)
+	e.body_checked = true;
+      slot = e;
+      ++*lines;
+    }
+  free(buf);
+  return true;
+}
+
+
+bool
+val_cache::load()
+{
+  // The cache is named by the user, so it is read and written as the
+  // real user; otherwise a set-user-id val could be used to create or
+  // replace some other file.
+  TempPrivDrop drop;
+  FILE *f = fopen(filename_.c_str(), "r");
+  if (f)
+    {
+      unsigned long lines;
+      const bool ours = read_entries(f, &entries_, &lines);
+      fclose(f);
+      if (!ours)
+	{
+	  errormsg("%s is not a val cache file; not using it.",
+		   filename_.c_str());
+	  return false;
+	}
+      return true;
+    }
+  if (ENOENT != errno)
+    {
+      errormsg_with_errno("Cannot read %s; not using it", filename_.c_str());
+      return false;
+    }
+
+  // Create the file now, so that the processes which append to it
+  // need not worry about who writes the first line.
+  f = fopen(filename_.c_str(), "w");
+  if (NULL == f
+      || fputs_failed(fputs(cache_header, f))
+      || fclose_failed(fclose(f)))
+    {
+      errormsg_with_errno("Cannot create %s; not using it",
+			  filename_.c_str());
+      return false;
+    }
+  return true;
+}
+
+
+bool
+val_cache::unchanged(const std::string& name, bool check_body)
+{
+  identity id;
+  if (identify(name, &id))
+    {
+      auto it = entries_.find(key(id.dev, id.ino));
+      if (it != entries_.end()
+	  && it->second.id == id
+	  && (it->second.body_checked || !check_body))
+	{
+	  ++hits_;
+	  return true;
+	}
+    }
+  ++misses_;
+  return false;
+}
+
+
+void
+val_cache::record(const std::string& name, const identity& id,
+		  bool check_body)
+{
+  // The line is written with a single write() to a file opened for
+  // appending, so the lines written by several processes at once do
+  // not get mixed up.
+  const std::string line = entry_line(id, check_body, name);
+  TempPrivDrop drop;		// see load().
+  const int fd = open(filename_.c_str(), O_WRONLY | O_APPEND);
+  if (fd < 0)
+    return;			// the file will just be checked again.
+  const ssize_t written = write(fd, line.data(), line.size());
+  close(fd);
+  (void) written;
+}
+
+
+void
+val_cache::save()
+{
+  TempPrivDrop drop;		// see load().
+
+  // Re-read the file, to pick up the lines written by any child
+  // processes.
+  FILE *f = fopen(filename_.c_str(), "r");
+  if (NULL == f)
+    return;
+  entry_map current;
+  unsigned long lines;
+  const bool ours = read_entries(f, &current, &lines);
+  fclose(f);
+  if (!ours || lines == current.size())
+    return;			// nothing to drop.
+
+  const std::string tmpname = filename_ + ".tmp";
+  f = fopen(tmpname.c_str(), "w");
+  if (NULL == f)
+    {
+      errormsg_with_errno("Cannot create %s", tmpname.c_str());
+      return;
+    }
+  bool failed = fputs_failed(fputs(cache_header, f));
+  for (auto it = current.begin(); !failed && it != current.end(); ++it)
+    {
+      const entry& e = it->second;
+      failed = fputs_failed(fputs(entry_line(e.id, e.body_checked,
+					      e.name).c_str(), f));
+    }
+  if (fclose_failed(fclose(f)) || failed)
+    {
+      errormsg_with_errno("Cannot write %s", tmpname.c_str());
+      remove(tmpname.c_str());
+      return;
+    }
+  if (0 != rename(tmpname.c_str(), filename_.c_str()))
+    {
+      errormsg_with_errno("Cannot rename %s to %s",
+			  tmpname.c_str(), filename_.c_str());
+      remove(tmpname.c_str());
+    }
+}
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
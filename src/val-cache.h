@@ -0,0 +1,115 @@
+/*
+ * val-cache.h: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * CSSC was originally Based on MySC, by Ross Ridge, which was
+ * placed in the Public Domain.
+ *
+ * Defines the class val_cache, which remembers which SCCS files
+ * passed validation so that "val -c" need not check them again until
+ * they change.
+ */
+#ifndef CSSC__VAL_CACHE_H__
+#define CSSC__VAL_CACHE_H__
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <sys/types.h>
+
+/* The cache is a text file.  Its first line identifies it, and each
+ * following line records one successful validation:
+ *
+ *    DEV INO SIZE MTIME-SEC MTIME-NSEC SUM LEVEL NAME
+ *
+ * SUM is the checksum stored in the first line of the SCCS file, and
+ * LEVEL is "b" if the body was checked too (val -b) and "h" if only
+ * the header was.  NAME is for the benefit of people reading the
+ * file; entries are found by device and inode number.
+ *
+ * Failed validations are never recorded, so a file which is corrupt
+ * is checked (and reported) on every run.
+ *
+ * Each process which validates a file appends a line for it, so
+ * the child processes of "val -j" can all add to the cache.  The
+ * parent process then rewrites the file to drop out-of-date lines.
+ */
+class val_cache
+{
+public:
+  struct identity
+  {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    long mtime_sec;
+    long mtime_nsec;
+    int stored_sum;
+
+    bool operator==(const identity& other) const;
+  };
+
+  explicit val_cache(const std::string& filename);
+
+  // Reads the cache file, creating it if it does not exist.  Returns
+  // false (after issuing a message) if the cache cannot be used.
+  bool load();
+
+  // Fills in *ID for the SCCS file NAME.  Returns false if NAME
+  // cannot be read or does not start with a checksum line.
+  static bool identify(const std::string& name, identity *id);
+
+  // Returns true if the SCCS file NAME passed validation (with the
+  // body checked, if CHECK_BODY) and has not changed since.  Counts
+  // the result as a hit or a miss.
+  bool unchanged(const std::string& name, bool check_body);
+
+  // Records that the file NAME, which had the identity ID before it
+  // was checked, passed validation.
+  void record(const std::string& name, const identity& id, bool check_body);
+
+  // Rewrites the cache file without its out-of-date lines.
+  void save();
+
+  unsigned long hits() const { return hits_; }
+  unsigned long misses() const { return misses_; }
+
+private:
+  struct entry
+  {
+    identity id;
+    bool body_checked;
+    std::string name;
+  };
+  typedef std::pair<dev_t, ino_t> key;
+  typedef std::map<key, entry> entry_map;
+
+  static bool read_entries(FILE *f, entry_map *entries,
+			   unsigned long *lines);
+
+  std::string filename_;
+  entry_map entries_;
+  unsigned long hits_;
+  unsigned long misses_;
+};
+
+#endif /* CSSC__VAL_CACHE_H__ */
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
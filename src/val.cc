@@ -24,22 +24,27 @@
 
 #include <config.h>
 
+#include <memory>
+
 #include "cssc.h"
 #include "fileiter.h"
+#include "parallel.h"
 #include "sccsfile.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "version.h"
 #include "except.h"
 #include "file.h"
 #include "valcodes.h"
+#include "val-cache.h"
 
 /* Prints a list of included or excluded SIDs. */
 
 void
-usage()
+val_usage()
 {
   fprintf(stderr,
-	  "usage: %s [-sV] [-m module] [-rSID] [-y type]\n",
+	  "usage: %s [-bsV] [-ccache] [-m module] [-rSID] [-y type]\n",
 	  prg_name);
 }
 
@@ -52,11 +57,12 @@ static void problem(int &retval, const int &newprob)
 
 
 int
-main(int argc, char **argv)
+val_main(int argc, char **argv)
 {
   Cleaner arbitrary_name;
   int retval = 0;
   bool silent = false;
+  bool check_body = false;
   std::string mstring;
   bool had_m_option = false;
   std::string ystring;
@@ -65,6 +71,8 @@ main(int argc, char **argv)
   int c;
   const char *req_sid_str = NULL;
   sid rid(sid::null_sid());
+  int max_jobs = 1;		/* -j */
+  const char *cache_name = NULL; /* -c */
 
   if (argc > 0)
       set_prg_name(argv[0]);
@@ -73,7 +81,7 @@ main(int argc, char **argv)
 
   ASSERT(!rid.valid());
 
-  class CSSC_Options opts(argc, argv, "sV!m!r!y!", 0);
+  class CSSC_Options opts(argc, argv, "bc!sV!m!r!y!j!", 0);
   for(c = opts.next();
       c != CSSC_Options::END_OF_ARGUMENTS;
       c = opts.next())
@@ -110,6 +118,30 @@ main(int argc, char **argv)
 	  silent = true;
 	  break;
 
+	case 'b':
+	  check_body = true;
+	  break;
+
+	case 'c':
+	  cache_name = opts.getarg();
+	  if ('\0' == *cache_name)
+	    {
+	      errormsg("The -c option needs the name of a cache file");
+	      problem(retval, Val_InvalidOption);
+	      return retval;
+	    }
+	  break;
+
+	case 'j':
+	  max_jobs = atoi(opts.getarg());
+	  if (max_jobs < 1)
+	    {
+	      errormsg("Invalid number of jobs: '%s'", opts.getarg());
+	      problem(retval, Val_InvalidOption);
+	      return retval;
+	    }
+	  break;
+
 	case 'm':
 	  if (had_m_option)
 	    {
@@ -150,12 +182,42 @@ main(int argc, char **argv)
       return retval;
     }
 
-  while (iter.next())
+  // The cache only knows whether a file passed validation, so it
+  // cannot answer for the -m, -r and -y checks.  We still record
+  // the files which pass them, though.
+  std::unique_ptr<val_cache> cache;
+  if (cache_name)
+    {
+      cache.reset(new val_cache(cache_name));
+      if (!cache->load())
+	cache.reset();
+    }
+  const bool use_cache_hits = cache
+    && !had_m_option && !had_r_option && !had_y_option;
+  parallel_jobs::skip_predicate skip;
+  if (use_cache_hits)
+    {
+      skip = [&cache, check_body](const std::string& name)
+	{
+	  return cache->unchanged(name, check_body);
+	};
+    }
+
+  parallel_jobs jobs(max_jobs);
+  while (jobs.next(iter, retval, skip))
     {
+      int file_retval = 0;
       try
 	{
 	  sccs_name &name = iter.get_name();
-	  sccs_file file(name, READ);
+	  val_cache::identity before;
+	  const bool identified =
+	    cache && val_cache::identify(name.c_str(), &before);
+
+	  // With -b, validate() computes the checksum while it reads
+	  // the body, so the file is read only once.
+	  sccs_file file(name, READ,
+			 ParserOptions().set_defer_checksum(check_body));
 
 	  if (had_r_option)
 	    {
@@ -166,7 +228,7 @@ main(int argc, char **argv)
 		      errormsg("%s: Requested SID %s not found.",
 			       name.c_str(), req_sid_str);
 		    }
-		  problem(retval, Val_NoSuchSID);
+		  problem(file_retval, Val_NoSuchSID);
 		}
 	    }
 
@@ -183,7 +245,7 @@ main(int argc, char **argv)
 			       mstring.c_str(),
 			       module_flag.c_str());
 		    }
-		  problem(retval, Val_MismatchedM);
+		  problem(file_retval, Val_MismatchedM);
 		}
 	    }
 
@@ -200,38 +262,69 @@ main(int argc, char **argv)
 			       mstring.c_str(),
 			       type_flag.c_str());
 		    }
-		  problem(retval, Val_MismatchedY);
+		  problem(file_retval, Val_MismatchedY);
 		}
 	    }
 
 
-	  if (!file.validate())
+	  if (!file.validate(check_body))
 	    {
-	      problem(retval, Val_CorruptFile);
+	      problem(file_retval, Val_CorruptFile);
 	    }
+
+	  // We record the file as it was before we checked it; if it
+	  // changed meanwhile, it will not match next time.
+	  if (identified && 0 == file_retval)
+	    cache->record(name.c_str(), before, check_body);
 	}
       catch (CsscSfileMissingException e)
 	{
-	  problem(retval, Val_CannotOpenOrWrongFormat);
+	  problem(file_retval, Val_CannotOpenOrWrongFormat);
 	}
       catch (CsscContstructorFailedException e)
 	{
-	  problem(retval, Val_CorruptFile);
+	  problem(file_retval, Val_CorruptFile);
 	}
       catch (CsscSfileCorruptException ce)
 	{
-	  problem(retval, Val_CorruptFile);
+	  problem(file_retval, Val_CorruptFile);
 	}
       catch (CsscExitvalException e)
 	{
-	  if (e.exitval > retval)
-	    retval = e.exitval;
+	  problem(file_retval, e.exitval);
+	}
+      problem(retval, file_retval);
+    }
+
+  if (cache)
+    {
+      cache->save();
+      if (use_cache_hits)
+	{
+	  // -s sends this to /dev/null along with everything else.
+	  printf("%s: %lu unchanged, %lu checked\n",
+		 cache_name, cache->hits(), cache->misses());
 	}
     }
 
   return retval;
 }
 
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  val_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return val_main(argc, argv);
+}
+#endif
+
 /* Local variables: */
 /* mode: c++ */
 /* End: */
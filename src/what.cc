@@ -34,6 +34,7 @@
 
 #include "defaults.h"
 #include "my-getopt.h"
+#include "multicall.h"
 #include "cssc.h"
 #include "version.h"
 
@@ -256,13 +257,13 @@ int what(const char *filename, bool one_match)
 }  // unnamed namespace
 
 void
-usage(void)
+what_usage(void)
 {
   fprintf(stderr, "usage: %s [-sV] file ...\n", what_prg_name);
 }
 
 int
-main(int argc, char **argv)
+what_main(int argc, char **argv)
 {
   bool one_match = false;
   int matchcount = 0;
@@ -299,6 +300,21 @@ main(int argc, char **argv)
     return 1;
 }
 
+#ifndef CSSC_MULTICALL
+// In the multicall build, these are provided by multicall.cc.
+void
+usage()
+{
+  what_usage();
+}
+
+int
+main(int argc, char **argv)
+{
+  return what_main(argc, argv);
+}
+#endif
+
 /* Local variables: */
 /* mode: c++ */
 /* End: */
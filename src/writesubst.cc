@@ -23,6 +23,7 @@
  */
 
 #include <config.h>
+#include <cstring>
 #include <string>
 
 #include "cssc.h"
@@ -207,7 +208,8 @@ sccs_file::emit_keyletter_expansion(FILE *out, struct subst_parms *parms, const
 	    parms->wstring = cssc::optional<std::string>();
 	  }
 	ASSERT(saved_wstring.has_value());
-	cssc::Failure recursed = write_subst(saved_wstring.value().c_str(),
+	cssc::Failure recursed = write_subst(saved_wstring.value().data(),
+					     saved_wstring.value().size(),
 					     parms, d, true);
 	if (!recursed.ok())
 	  return recursed;
@@ -220,8 +222,9 @@ sccs_file::emit_keyletter_expansion(FILE *out, struct subst_parms *parms, const
 
     case 'A':
       {
-	cssc::Failure recursed = write_subst("%Z""%%Y""% %M""% %I"
-					     "%%Z""%",
+	static const char a_expansion[] = "%Z""%%Y""% %M""% %I""%%Z""%";
+	cssc::Failure recursed = write_subst(a_expansion,
+					     sizeof(a_expansion) - 1u,
 					     parms, d, true);
 	if (!recursed.ok())
 	  return recursed;
@@ -235,22 +238,28 @@ sccs_file::emit_keyletter_expansion(FILE *out, struct subst_parms *parms, const
 
 
 
-/* Write a line of a file after substituting any id keywords in it.
-   Returns true if an error occurs. */
+/* Write the LEN bytes at START (a line of a file, without its
+   newline) after substituting any id keywords in it.  The line may
+   contain NUL bytes. */
 cssc::Failure
-sccs_file::write_subst(const char *start,
+sccs_file::write_subst(const char *start, size_t len,
                        struct subst_parms *parms,
                        const delta& d,
 		       bool force_expansion) const
 {
   FILE *out = parms->out;
+  const char *const end = start + len;
+  auto find_percent = [end](const char *from) -> const char*
+    {
+      return static_cast<const char*>(memchr(from, '%', end - from));
+    };
 
-  const char *percent = strchr(start, '%');
+  const char *percent = find_percent(start);
   while (percent != NULL)
     {
-      char c = percent[1];
-      if (c != '\0' && percent[2] == '%')
+      if (end - percent >= 3 && percent[2] == '%')
 	{
+	  char c = percent[1];
 	  if (start != percent
 	      && fwrite(start, percent - start, 1, out) != 1)
 	    {
@@ -274,7 +283,7 @@ sccs_file::write_subst(const char *start,
 	      else
 		{
 		  start = percent+3;
-		  percent = strchr(start, '%');
+		  percent = find_percent(start);
 		  continue;
 		}
 	    }
@@ -300,10 +309,11 @@ sccs_file::write_subst(const char *start,
 	{
 	  percent++;
 	}
-      percent = strchr(percent, '%');
+      percent = find_percent(percent);
     }
 
-  if (fputs_failed(fputs(start, out)))
+  const size_t rest = end - start;
+  if (rest && fwrite(start, 1, rest, out) < rest)
     {
       return cssc::make_failure_builder_from_errno(errno) << "write failed";
     }
@@ -0,0 +1,81 @@
+#! /bin/sh
+# blocks.sh:  Tests for "admin"'s detection of binary files, where
+#             the evidence appears only after a lot of text.  The
+#             data read before that point must not be lost.
+
+# Import common functions & definitions.
+. ../common/test-common
+. ../common/real-thing
+. ../common/config-data
+
+if $binary_support
+then
+    true
+else
+    echo "Skipping these tests -- no binary file support."
+    exit 0
+fi
+
+g=blocks
+s=s.$g
+remove $s $g infile got
+unset CSSC_MAX_LINE_LENGTH
+
+# make_input: write 20000 lines of text (about 250K) to infile,
+# followed by the string in $1 (interpreted by printf).
+make_input () {
+    awk 'BEGIN { for (i = 1; i <= 20000; ++i) printf("line %d %%M%%\n", i); }' \
+	< /dev/null > infile || miscarry "cannot create infile"
+    printf "$1" >> infile || miscarry "cannot create infile"
+}
+
+# check_encoded: create $s from infile (on stdin if $2 is "stdin"),
+# and check that it is encoded and that "get" gives back the input.
+check_encoded () {
+    label=$1
+    echo_nonl ${label}...
+    rm -f $s
+    if test "$2" = stdin
+    then
+	${vg_admin} -i $s < infile > /dev/null 2>&1
+    else
+	${vg_admin} -iinfile $s > /dev/null 2>&1
+    fi || fail "$label: admin failed"
+    ( ${prs} -d:FL: $s 2>/dev/null; echo foo ) | grep encoded >/dev/null 2>&1 ||
+	fail "$label: input did not produce an encoded s-file."
+    ${get} -s -k -p $s > got 2>/dev/null || fail "$label: get failed"
+    cmp infile got >/dev/null 2>&1 || fail "$label: get did not return the input"
+    echo passed
+}
+
+make_input "\001 at start of line\n"
+check_encoded B1 file
+check_encoded B2 stdin
+
+make_input "no newline at the end"
+check_encoded B3 file
+check_encoded B4 stdin
+
+# Without anything unusual, the file is not encoded, and all the
+# lines are counted.
+rm -f $s
+make_input ""
+docommand B5 "${vg_admin} -iinfile $s" 0 "" IGNORE
+docommand B6 "${prs} -d:Li: $s" 0 "20000\n" ""
+docommand B7 "${get} -s -k -p $s | cmp - infile" 0 "" ""
+rm -f $s
+
+if $TESTING_CSSC
+then
+    # A line of the maximum length or more makes the file binary.
+    printf "short\n123456789\nlonger line\n" > infile
+    docommand B8 "CSSC_MAX_LINE_LENGTH=20 ${vg_admin} -iinfile $s" 0 "" IGNORE
+    docommand B9 "${prs} -d:FL: $s" 0 "\n" ""
+    rm -f $s
+    docommand B10 "CSSC_MAX_LINE_LENGTH=10 ${vg_admin} -iinfile $s" 0 "" IGNORE
+    docommand B11 "${prs} -d:FL: $s | grep encoded" 0 IGNORE ""
+    docommand B12 "${get} -s -k -p $s" 0 "short\n123456789\nlonger line\n" ""
+fi
+
+remove $s $g infile got command.log
+success
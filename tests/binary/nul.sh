@@ -0,0 +1,54 @@
+#! /bin/sh
+# nul.sh:  Tests for text files containing ASCII NUL characters.
+#          CSSC stores these as text, so get, delta and prs must
+#          not lose the part of a line after a NUL.
+
+# Import common functions & definitions.
+. ../common/test-common
+. ../common/real-thing
+
+if $TESTING_CSSC
+then
+    true
+else
+    echo "Skipping these tests -- SCCS treats files containing NUL as binary."
+    exit 0
+fi
+
+g=nul
+s=s.$g
+p=p.$g
+remove $s $g $p infile first expected command.log
+
+printf 'one\000two\nthree %%M%%\000%%I%%\nfour\n' > infile ||
+    miscarry "cannot create infile"
+cp infile first || miscarry "cannot copy infile"
+
+docommand N1 "${vg_admin} -iinfile $s" 0 "" IGNORE
+docommand N2 "${prs} -d:FL: $s" 0 "\n" ""
+
+# get -k gives back the input unchanged.
+docommand N3 "${get} -s -k -p $s | cmp - infile" 0 "" ""
+
+# Keywords either side of the NUL are expanded.
+printf 'one\000two\nthree nul\0001.1\nfour\n' > expected ||
+    miscarry "cannot create expected"
+docommand N4 "${get} -s -p $s | cmp - expected" 0 "" ""
+
+# delta keeps the NULs in the lines it does not change, and in the
+# lines it adds.
+docommand N5 "${vg_get} -e $s" 0 IGNORE IGNORE
+printf 'five\000six\n' >> $g || miscarry "cannot append to $g"
+cp $g infile || miscarry "cannot copy $g"
+docommand N6 "${vg_delta} -yNUL $s" 0 IGNORE IGNORE
+docommand N7 "${get} -s -k -p $s | cmp - infile" 0 "" ""
+docommand N8 "${get} -s -k -p -r1.1 $s | cmp - first" 0 "" ""
+docommand N9 "${prs} -r1.2 -d:Li: $s" 0 "00001\n" ""
+
+# prs :GB: shows the body, NULs and all.
+printf 'one\000two\nthree nul\0001.2\nfour\nfive\000six\n\n' > expected ||
+    miscarry "cannot create expected"
+docommand N10 "${prs} -r1.2 -d:GB: $s | cmp - expected" 0 "" ""
+
+remove $s $g $p infile first expected command.log
+success
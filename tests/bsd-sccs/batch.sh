@@ -0,0 +1,75 @@
+#! /bin/sh
+# batch.sh:  Tests for "sccs batch", which reads commands from a file.
+
+# Import common functions & definitions.
+. ../common/test-common
+
+unset LANG
+unset PROJECTDIR
+
+g=bfile
+s=SCCS/s.${g}
+p=SCCS/p.${g}
+cmds=batch.cmds
+remove $cmds SCCS $g
+mkdir SCCS 2>/dev/null
+
+echo '%M%: line one' > $g || miscarry "cannot create $g"
+${admin} -i$g $s > /dev/null 2>&1 || miscarry "cannot create $s"
+remove $g
+
+# The ^A which ends each command's output is shown as "=" so that we
+# can write it in the expected output.
+batch () {
+    ${vg_sccs} batch "$@" | tr '\001' '='
+}
+
+cat > $cmds <<EOF
+# A comment, and then a blank line.
+
+prs -d:I: $g
+get -p -s $g
+prs "-d:I: and :M:" $g
+EOF
+docommand b1 "batch $cmds" 0 \
+    "1.1\n=0\nbfile: line one\n=0\n1.1 and bfile\n=0\n" IGNORE
+
+# The commands can also come from stdin.
+docommand b2 "batch < $cmds" 0 \
+    "1.1\n=0\nbfile: line one\n=0\n1.1 and bfile\n=0\n" IGNORE
+docommand b3 "batch - < $cmds" 0 \
+    "1.1\n=0\nbfile: line one\n=0\n1.1 and bfile\n=0\n" IGNORE
+
+# The exit status of each command is shown, and a failing command
+# does not stop the others.
+cat > $cmds <<EOF
+get -p -s nosuch
+prs -d:I: $g
+nosuchcommand
+prs -d:I: "$g
+EOF
+docommand b4 "batch $cmds" 0 "=1\n1.1\n=0\n=64\n=64\n" IGNORE
+
+# Each command sees the effect of the earlier ones.
+cat > $cmds <<EOF
+edit $g
+unedit $g
+EOF
+docommand b5 "batch $cmds" 0 IGNORE IGNORE
+docommand b6 "test -f $p" 1 "" ""
+docommand b7 "test -f $g" 0 "" ""
+
+# The commands do not read the batch input, so the delta (which would
+# otherwise prompt for comments) does not consume the next command.
+remove $g
+cat > $cmds <<EOF
+edit $g
+delta $g
+prs -d:I: $g
+EOF
+docommand b8 "batch < $cmds | tail -2" 0 "1.2\n=0\n" IGNORE
+
+docommand b9 "${vg_sccs} batch nosuchfile" 66 "" IGNORE
+
+remove $cmds SCCS $g command.log
+success
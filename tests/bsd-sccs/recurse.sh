@@ -0,0 +1,56 @@
+#! /bin/sh
+# recurse.sh:  Tests for the -r option of "sccs clean", "sccs info",
+#              "sccs check" and "sccs tell".
+
+# Import common functions & definitions.
+. ../common/test-common
+
+unset LANG
+unset PROJECTDIR
+
+d=rtop
+remove $d
+mkdir $d $d/SCCS $d/sub $d/sub/SCCS $d/nosccs $d/nosccs/deeper \
+    $d/nosccs/deeper/SCCS || miscarry "cannot create directories"
+
+for g in top1 top2 sub/sub1 nosccs/deeper/deep1
+do
+    dir=`dirname $d/$g`
+    base=`basename $g`
+    echo "%M%" > $d/$g || miscarry "cannot create $d/$g"
+    ${admin} -i$d/$g $dir/SCCS/s.$base > /dev/null 2>&1 ||
+	miscarry "cannot create $dir/SCCS/s.$base"
+    rm -f $d/$g
+    ( cd $dir && ${get} -s SCCS/s.$base ) || miscarry "cannot get $g"
+done
+( cd $d/sub && ${get} -s -e SCCS/s.sub1 ) || miscarry "cannot edit sub1"
+
+# Without -r, only the named directory is examined.
+docommand r1 "( cd $d && ${vg_sccs} tell )" 0 "" ""
+docommand r2 "( cd $d && ${vg_sccs} check )" 0 "" ""
+docommand r3 "( cd $d && ${vg_sccs} tell sub )" 0 "sub1\n" ""
+
+# With -r, files being edited in subdirectories are found, and are
+# named relative to the starting directory.
+docommand r4 "( cd $d && ${vg_sccs} tell -r )" 0 "sub/sub1\n" ""
+docommand r5 "( cd $d && ${vg_sccs} check -r )" 1 IGNORE ""
+docommand r6 "( cd $d && ${vg_sccs} info -r -b | sed 's/ 1.1 1.2 .*//' )" 0 \
+    "    sub/sub1: being edited:\n" ""
+docommand r7 "( cd $d && ${vg_sccs} info -r -u nosuchuser )" 0 \
+    "Nothing being edited by nosuchuser\n" ""
+
+# Without -r, the named directory must have an SCCS subdirectory.
+docommand r8 "( cd $d && ${vg_sccs} tell nosccs )" 66 "" IGNORE
+docommand r9 "( cd $d && ${vg_sccs} tell -r nosccs )" 0 "" ""
+docommand r10 "( cd $d && ${vg_sccs} tell -r nosuchdir )" 66 "" IGNORE
+docommand r11 "( cd $d && ${vg_sccs} tell -r sub )" 0 "sub1\n" ""
+
+# clean -r removes the g-files which are not being edited, throughout
+# the tree.
+docommand r12 "( cd $d && ${vg_sccs} clean -r )" 0 IGNORE ""
+docommand r13 "test -f $d/top1" 1 "" ""
+docommand r14 "test -f $d/nosccs/deeper/deep1" 1 "" ""
+docommand r15 "test -f $d/sub/sub1" 0 "" ""
+
+remove $d command.log
+success
@@ -0,0 +1,159 @@
+#! /bin/sh
+# basic.sh:  Testing for "comb", which rewrites an SCCS file keeping
+#            only some of its deltas.
+
+# Import common functions & definitions.
+. ../common/test-common
+. ../common/real-thing
+
+if $TESTING_CSSC
+then
+    true
+else
+    echo "Skipping these tests -- comb rewrites the file only in CSSC."
+    exit 0
+fi
+
+g=foo
+s=s.$g
+remove $s $g p.$g z.$g x.$g s.orig got.* want.*
+
+# 1.1 has the lines 1 to 20; 1.2 to 1.5 each delete a line and add
+# one.  There is a branch 1.3.1.1 and finally 1.6 deletes most of
+# the file.
+i=1
+while test $i -le 20
+do
+    echo $i
+    i=`expr $i + 1`
+done > $g || miscarry "cannot create $g"
+${admin} -i$g $s >/dev/null 2>&1 || miscarry "cannot create $s"
+remove $g
+for i in 2 3 4 5
+do
+    ${get} -e $s >/dev/null 2>&1 || miscarry "cannot get $s for editing"
+    sed -e "${i}d" < $g > $g.new && echo new$i >> $g.new && mv $g.new $g ||
+	miscarry "cannot edit $g"
+    ${delta} -yd$i $s >/dev/null 2>&1 || miscarry "cannot make delta $i"
+done
+${get} -e -r1.3 $s >/dev/null 2>&1 || miscarry "cannot get 1.3 for editing"
+echo branch >> $g
+${delta} -ybranch $s >/dev/null 2>&1 || miscarry "cannot make the branch"
+${get} -e $s >/dev/null 2>&1 || miscarry "cannot get $s for editing"
+sed -e '1,10d' < $g > $g.new && mv $g.new $g || miscarry "cannot edit $g"
+${delta} -ycut $s >/dev/null 2>&1 || miscarry "cannot make the last delta"
+
+for r in 1.1 1.2 1.3 1.3.1.1 1.4 1.5 1.6
+do
+    ${get} -s -p -r$r $s > want.$r 2>/dev/null || miscarry "cannot get $r"
+done
+cp $s s.orig || miscarry "cannot copy $s"
+
+# restore: put the original file back.
+restore () {
+    remove $s
+    cp s.orig $s || miscarry "cannot restore $s"
+}
+
+# same ID...: check that each of the versions ID... is unchanged.
+same () {
+    for r
+    do
+	${get} -s -p -r$r $s > got.$r 2>/dev/null &&
+	    cmp got.$r want.$r >/dev/null 2>&1 || return 1
+    done
+}
+
+deltas="${prs} -d:I:/:DS:/:DP: -e $s"
+
+# With no options, comb keeps the deltas with no successor (1.6 and
+# 1.3.1.1), and 1.3, where they branch.
+docommand b1 "${vg_comb} -s $s" 0 IGNORE ""
+docommand b2 "cmp $s s.orig" 0 "" ""
+docommand b3 "${vg_comb} $s" 0 "" ""
+docommand b4 "${deltas}" 0 "1.6/3/1\n1.3.1.1/2/1\n1.3/1/0\n" IGNORE
+docommand b5 "same 1.3 1.3.1.1 1.6" 0 "" ""
+docommand b6 "${vg_val} $s" 0 "" ""
+docommand b7 "${get} -r1.2 $s" 1 IGNORE IGNORE
+docommand b8 "${prs} -d:Li:/:Ld:/:Lu: -r1.6 $s" 0 "00002/00012/00008\n" ""
+docommand b9 "test \`wc -c < $s\` -lt \`wc -c < s.orig\`" 0 "" ""
+
+# -p keeps the given delta and all later ones.
+restore
+docommand p1 "${vg_comb} -p1.4 $s" 0 "" ""
+docommand p2 "${deltas}" 0 \
+    "1.6/5/3\n1.3.1.1/4/1\n1.5/3/2\n1.4/2/1\n1.3/1/0\n" IGNORE
+docommand p3 "same 1.3 1.3.1.1 1.4 1.5 1.6" 0 "" ""
+docommand p4 "${vg_val} $s" 0 "" ""
+docommand p5 "${vg_comb} -p1.9 $s" 1 "" IGNORE
+
+# -c keeps just the deltas given.
+restore
+docommand c1 "${vg_comb} -c1.2,1.5 $s" 0 "" ""
+docommand c2 "${deltas}" 0 "1.5/2/1\n1.2/1/0\n" IGNORE
+docommand c3 "same 1.2 1.5" 0 "" ""
+docommand c4 "${vg_val} $s" 0 "" ""
+docommand c5 "${vg_comb} -c1.9 $s" 1 "" IGNORE
+docommand c6 "${vg_comb} -c1.1 -p1.1 $s" 2 "" IGNORE
+# The error is reported once, not once per copy of the failure.
+docommand c7 "${vg_comb} -c1.9 $s 2>&1 >/dev/null | grep -c 'would be kept'" \
+    0 "1\n" ""
+
+# A file being edited is left alone, as its p-file names SIDs which
+# might not survive.
+restore
+docommand e1 "${get} -e $s" 0 IGNORE IGNORE
+docommand e2 "${vg_comb} $s" 1 "" IGNORE
+docommand e3 "cmp $s s.orig" 0 "" ""
+docommand e4 "${vg_comb} -s $s" 0 IGNORE ""
+
+# When the only successor of a delta has been removed, the delta is
+# one of those kept by default.
+remove p.$g $g
+restore
+docommand m1 "${rmdel} -r1.6 $s" 0 "" IGNORE
+docommand m2 "${vg_comb} $s" 0 "" ""
+docommand m3 "${deltas}" 0 "1.3.1.1/3/1\n1.5/2/1\n1.3/1/0\n" IGNORE
+docommand m4 "same 1.3 1.3.1.1 1.5" 0 "" ""
+docommand m5 "${vg_val} $s" 0 "" ""
+
+# Deltas with include and exclude lists: 1.4 excludes 1.2, and 1.5
+# includes the branch 1.2.1.1.
+remove $s s.orig got.* want.*
+i=1
+while test $i -le 10
+do
+    echo $i
+    i=`expr $i + 1`
+done > $g || miscarry "cannot create $g"
+${admin} -i$g $s >/dev/null 2>&1 || miscarry "cannot create $s"
+remove $g
+# edit ARGS TEXT: make a delta from "get -e ARGS", adding the line TEXT.
+edit () {
+    ${get} -e $1 $s >/dev/null 2>&1 || miscarry "cannot get $s $1 for editing"
+    echo "$2" >> $g || miscarry "cannot edit $g"
+    ${delta} -y"$2" $s >/dev/null 2>&1 || miscarry "cannot make delta $2"
+}
+edit "" two
+edit "" three
+edit -r1.2 branch
+edit -x1.2 four
+edit -i1.2.1.1 five
+for r in 1.1 1.2 1.2.1.1 1.3 1.4 1.5
+do
+    ${get} -s -p -r$r $s > want.$r 2>/dev/null || miscarry "cannot get $r"
+done
+cp $s s.orig || miscarry "cannot copy $s"
+
+docommand i1 "${vg_comb} $s" 0 "" IGNORE
+docommand i2 "${deltas}" 0 "1.5/3/1\n1.2.1.1/2/1\n1.2/1/0\n" IGNORE
+docommand i3 "same 1.2 1.2.1.1 1.5" 0 "" ""
+docommand i4 "${vg_val} $s" 0 "" ""
+restore
+docommand i5 "${vg_comb} -c1.3,1.4,1.5 $s" 0 "" IGNORE
+docommand i6 "${deltas}" 0 "1.5/3/2\n1.4/2/1\n1.3/1/0\n" IGNORE
+docommand i7 "same 1.3 1.4 1.5" 0 "" ""
+docommand i8 "${vg_val} $s" 0 "" ""
+
+remove $s $g p.$g z.$g x.$g s.orig got.* want.*
+success
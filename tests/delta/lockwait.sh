@@ -0,0 +1,65 @@
+#! /bin/sh
+# lockwait.sh:  Tests for waiting for the lock (the z-file) on an
+#               SCCS file which another process is updating.
+
+# Import common functions & definitions.
+. ../common/test-common
+. ../common/real-thing
+
+if $TESTING_CSSC
+then
+    true
+else
+    echo "Skipping these tests -- CSSC_LOCK_TIMEOUT is specific to CSSC."
+    exit 0
+fi
+
+g=foo
+s=s.$g
+p=p.$g
+z=z.$g
+remove $s $g $p $z delta.out lock.log
+unset CSSC_LOCK_TIMEOUT CSSC_LOCK_LOG
+
+echo '%M%' > $g
+${admin} -i$g $s > /dev/null 2>&1 || miscarry "cannot create $s"
+remove $g
+
+# A z-file left behind by some other program (without a record lock)
+# makes us wait until the timeout expires.
+echo 12345 > $z
+docommand L1 "CSSC_LOCK_TIMEOUT=0 ${vg_admin} -fb $s" 1 "" IGNORE
+docommand L2 "CSSC_LOCK_TIMEOUT=1 ${vg_admin} -fb $s 2>&1 | grep 'held by process 12345' >/dev/null" 0 "" ""
+docommand L3 "${prs} -d:BF: $s" 0 "no\n" ""
+remove $z
+
+docommand L4 "CSSC_LOCK_TIMEOUT=soon ${vg_admin} -fb $s" 1 "" IGNORE
+
+# While delta is waiting for its comments it holds the lock.  admin
+# waits for delta to finish and then makes its own change.
+docommand L5 "${get} -e $s" 0 IGNORE IGNORE
+echo 'another line' >> $g
+( sleep 2; echo comment ) | ${delta} $s > delta.out 2>&1 &
+sleep 1
+docommand L6 "test -f $z" 0 "" ""
+docommand L7 "CSSC_LOCK_TIMEOUT=60 ${vg_admin} -fb $s" 0 "" IGNORE
+wait
+docommand L8 "${prs} -d:I:/:BF: $s" 0 "1.2/yes\n" ""
+docommand L9 "test -f $z" 1 "" ""
+
+# CSSC_LOCK_LOG names a file to which a line is appended for each
+# lock taken and released, and for each update of the p-file.
+remove $g lock.log
+docommand L10 "CSSC_LOCK_LOG=lock.log ${vg_get} -e $s" 0 IGNORE IGNORE
+docommand L11 "grep -c '\"event\":\"lock\",' lock.log" 0 "1\n" ""
+docommand L12 "grep -c '\"event\":\"pfile-update\",.*\"locks\":1}' lock.log" 0 "1\n" ""
+docommand L13 "grep -c '\"event\":\"unlock\",.*\"held\":' lock.log" 0 "1\n" ""
+docommand L14 "grep -c '\"file\":\"/.*/$z\"' lock.log" 0 "2\n" ""
+
+# A program working on the same file twice has given up the lock on
+# it before the second time.
+docommand L15 "CSSC_LOCK_TIMEOUT=2 ${vg_admin} -fb $s $s" 0 "" ""
+docommand L16 "test -f $z" 1 "" ""
+
+remove $s $g $p $z delta.out lock.log command.log
+success
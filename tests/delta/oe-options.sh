@@ -0,0 +1,56 @@
+#! /bin/sh
+# oe-options.sh:  Testing for the -o and -e options of "delta", which
+#                 do the work of "sccs delget" and "sccs deledit".
+
+# Import common functions & definitions.
+. ../common/test-common
+. ../common/real-thing
+
+if $TESTING_CSSC
+then
+    true
+else
+    echo "Skipping these tests -- delta -o and -e are specific to CSSC."
+    exit 0
+fi
+
+g=foo
+s=s.$g
+remove $s $g p.$g z.$g got
+
+echo 'one %I%' > $g || miscarry "cannot create $g"
+docommand o1 "${admin} -i$g $s" 0 "" IGNORE
+remove $g
+
+# -o leaves the new version in a read-only g-file, with its keywords
+# expanded, just as "get" would.
+docommand o2 "${get} -e $s" 0 IGNORE IGNORE
+echo 'two' >> $g
+docommand o3 "${vg_delta} -o -y $s" 0 \
+    "1.2\n1 inserted\n0 deleted\n1 unchanged\n1.2\n2 lines\n" ""
+docommand o4 "test -w $g" 1 "" ""
+docommand o5 "cat $g" 0 "one 1.2\ntwo\n" ""
+docommand o6 "test -f p.$g" 1 "" ""
+
+# If "get" would fetch some other delta, -o fetches that one.
+docommand o7 "${get} -e -r2 $s" 0 IGNORE IGNORE
+docommand o8 "${vg_delta} -y $s" 0 IGNORE ""
+docommand o9 "${get} -e -r1.2 $s" 0 IGNORE IGNORE
+echo 'three' >> $g
+docommand o10 "${vg_delta} -o -y $s" 0 \
+    "1.2.1.1\n1 inserted\n0 deleted\n2 unchanged\n2.1\n2 lines\n" ""
+docommand o11 "cat $g" 0 "one 2.1\ntwo\n" ""
+
+# -e keeps the working file and checks the new delta out again.
+remove $g
+docommand e1 "${get} -e $s" 0 IGNORE IGNORE
+echo 'four' >> $g
+docommand e2 "${vg_delta} -e -y $s" 0 \
+    "2.2\n1 inserted\n0 deleted\n2 unchanged\n2.2\nnew delta 2.3\n" ""
+docommand e3 "test -w $g" 0 "" ""
+docommand e4 "sed -e 's/ .*//' p.$g" 0 "2.2\n" ""
+docommand e5 "${get} -p -r2.2 $s 2>/dev/null" 0 "one 2.2\ntwo\nfour\n" ""
+docommand e6 "${vg_delta} -e -o -y $s" 1 "" IGNORE
+
+remove $s $g p.$g z.$g got
+success
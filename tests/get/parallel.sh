@@ -0,0 +1,59 @@
+#! /bin/sh
+
+# parallel.sh:  Tests for the -j option of get, prs and val.
+#               The output and exit status should be the same as
+#               for the same command without -j.
+
+# Import common functions & definitions.
+. ../common/test-common
+
+d=pdir
+remove $d serial.out serial.err parallel.out parallel.err
+mkdir $d || miscarry "cannot create directory $d"
+
+for i in 1 2 3 4 5 6 7 8 9
+do
+    f=$d/foo$i
+    echo "line one of %M%" > $f   || miscarry "cannot create $f"
+    echo "line two of $i" >> $f   || miscarry "cannot create $f"
+    ${admin} -i$f $d/s.foo$i > /dev/null 2>&1 || miscarry "admin failed for $f"
+    remove $f
+done
+# A file which is not an SCCS file at all, so that some of the
+# commands below fail.
+echo "not an SCCS file" > $d/s.junk || miscarry "cannot create $d/s.junk"
+
+same_as_serial () {
+    # $1 -- label
+    # $2 -- command, in which @J@ is replaced by the -j option.
+    serial=`echo "$2" | sed -e 's/@J@//'`
+    parallel=`echo "$2" | sed -e 's/@J@/-j3/'`
+
+    echo_nonl $1...
+    eval "$serial" > serial.out 2> serial.err
+    serial_rv=$?
+    eval "$parallel" > parallel.out 2> parallel.err
+    parallel_rv=$?
+    if test $serial_rv -ne $parallel_rv
+    then
+	fail "$1: exit status was $parallel_rv with -j but $serial_rv without"
+    fi
+    cmp serial.out parallel.out > /dev/null || fail "$1: stdout differs with -j"
+    cmp serial.err parallel.err > /dev/null || fail "$1: stderr differs with -j"
+    echo passed
+}
+
+same_as_serial J1 "${vg_get} @J@ -p $d"
+same_as_serial J2 "${vg_get} @J@ -p -s $d"
+same_as_serial J3 "${vg_get} @J@ -p -m -n $d/s.foo3 $d/s.junk $d/s.foo1 $d/s.foo2"
+same_as_serial J4 "${vg_prs} @J@ $d"
+same_as_serial J5 "${vg_prs} @J@ -d:M: $d/s.foo4 $d/s.foo5"
+same_as_serial J6 "${vg_val} @J@ $d"
+same_as_serial J7 "${vg_val} @J@ $d/s.foo6 $d/s.foo7"
+
+# A non-numeric job count is an error.
+docommand J8 "${vg_get} -jx -p $d/s.foo1" 1 "" IGNORE
+docommand J9 "${vg_prs} -j0 $d/s.foo1" 2 "" IGNORE
+
+remove $d serial.out serial.err parallel.out parallel.err
+success
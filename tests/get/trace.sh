@@ -0,0 +1,55 @@
+#! /bin/sh
+# trace.sh:  Tests for the records written to the file named by
+#            CSSC_TRACE.
+
+# Import common functions & definitions.
+. ../common/test-common
+. ../common/real-thing
+
+if $TESTING_CSSC
+then
+    true
+else
+    echo "Skipping these tests -- CSSC_TRACE is specific to CSSC."
+    exit 0
+fi
+
+g=foo
+s=s.$g
+remove $s $g trace.log
+unset CSSC_TRACE
+
+printf '%%M%% one\ntwo\nthree\n' > $g
+${admin} -i$g $s > /dev/null 2>&1 || miscarry "cannot create $s"
+remove $g
+
+# Without CSSC_TRACE, nothing is written.
+docommand T1 "${vg_get} -p $s" 0 "foo one\ntwo\nthree\n" IGNORE
+docommand T2 "test -f trace.log" 1 "" ""
+
+# Each phase (open, checksum, header, seqstate, body) writes a
+# record, with its counters.
+docommand T3 "CSSC_TRACE=trace.log ${vg_get} -p $s" 0 \
+    "foo one\ntwo\nthree\n" IGNORE
+docommand T4 "grep -c '\"event\":\"phase\",\"phase\":\"checksum\",' trace.log" \
+    0 "1\n" ""
+docommand T5 "grep -c '\"phase\":\"header\",.*\"deltas\":1}' trace.log" \
+    0 "1\n" ""
+docommand T6 "grep -c '\"phase\":\"body\",.*\"body_lines\":3,.*\"subst_lines\":3}' trace.log" \
+    0 "1\n" ""
+docommand T7 "grep -c '\"file\":\"/.*/$s\"' trace.log" 0 "5\n" ""
+
+# At the end, a record of the totals.
+docommand T8 "grep -c '\"event\":\"totals\",' trace.log" 0 "1\n" ""
+docommand T9 "tail -1 trace.log | grep -c '\"body_lines\":3'" 0 "1\n" ""
+
+# Records are appended, and delta reports the comparison.
+${get} -e $s > /dev/null 2>&1 || miscarry "cannot get -e $s"
+echo four >> $g
+docommand T10 "CSSC_TRACE=trace.log ${vg_delta} -yx $s" 0 IGNORE IGNORE
+docommand T11 "grep -c '\"event\":\"totals\",' trace.log" 0 "2\n" ""
+docommand T12 "grep -c '\"phase\":\"diff\",.*\"old_lines\":3,\"new_lines\":4,\"hunks\":1}' trace.log" \
+    0 "1\n" ""
+
+remove $s $g trace.log command.log
+success
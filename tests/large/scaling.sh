@@ -0,0 +1,179 @@
+#! /bin/sh
+# scaling.sh:  Checks that the time taken by get and prs, and the
+#              amount delta reads, grow no faster than they should as
+#              SCCS files get bigger.
+#
+# Each check compares a run on a small file made by mkhistory (the
+# calibration run) with a run on a file eight times bigger.  The
+# budgets are generous enough to absorb timing noise, but a tool
+# whose running time grows with the square of the file size will
+# exceed them.
+
+# Import common functions & definitions.
+. ../common/test-common
+. ../common/real-thing
+
+if $TESTING_CSSC
+then
+    true
+else
+    echo "Skipping these tests -- they use CSSC_TRACE, which is specific to CSSC."
+    exit 0
+fi
+
+mkhistory=../../testutils/mkhistory
+if test -x $mkhistory
+then
+    true
+else
+    echo "Skipping these tests -- $mkhistory has not been built."
+    exit 0
+fi
+
+s=s.hist
+g=hist
+p=p.hist
+remove $s $g $p trace.log command.log
+unset CSSC_TRACE
+
+# The bigger file of each pair is this many times bigger than the
+# smaller one...
+scale=8
+# ...and the bigger run may take at most this many times as long.
+# Linear growth gives a ratio of about $scale; quadratic growth
+# gives $scale squared.
+budget=16
+
+# totals_field FIELD prints the value of FIELD in the last "totals"
+# record in trace.log.
+totals_field () {
+    grep '"event":"totals"' trace.log | tail -1 |
+	sed -n "s/.*\"$1\":\([0-9.]*\).*/\1/p"
+}
+
+# cpu_time COMMAND prints the smallest CPU time (in seconds) taken by
+# COMMAND over three runs.
+cpu_time () {
+    best=
+    for run in 1 2 3
+    do
+	remove trace.log
+	( CSSC_TRACE=trace.log; export CSSC_TRACE; eval "$1" ) \
+	    >/dev/null 2>&1 || miscarry "$1 failed"
+	t=`totals_field cpu`
+	test -n "$t" || miscarry "$1 wrote no totals record"
+	best=`echo "$best $t" | awk '{ if (NF == 1 || $2 < $1) print $NF; else print $1 }'`
+    done
+    echo $best
+}
+
+# check_ratio LABEL SMALL BIG checks that BIG is at most $budget
+# times SMALL.  CPU time may be counted in clock ticks, so a quick
+# calibration run can read as zero, which gives us no budget at all;
+# the check is skipped then.
+check_ratio () {
+    echo_nonl "$1..."
+    if echo "$2" | awk '{ exit ($1 > 0) ? 1 : 0 }'
+    then
+	echo "skipped (the calibration run was too quick to measure)"
+    elif echo "$2 $3 $budget" |
+	awk '{ exit ($2 <= $1 * $3) ? 0 : 1 }'
+    then
+	echo passed
+    else
+	fail "$1: took ${3}s, against ${2}s for a file $scale times smaller" \
+	    "(budget: $budget times)"
+    fi
+}
+
+make_history () {
+    remove $s
+    ${mkhistory} "$@" $s || miscarry "cannot run ${mkhistory} $*"
+}
+
+
+# get should take time proportional to the size of the body.
+make_history -n 20 -l 50000
+small=`cpu_time "${get} -p $s"`
+make_history -n 20 -l `expr 50000 \* $scale`
+big=`cpu_time "${get} -p $s"`
+check_ratio S1 $small $big
+
+# prs should take time proportional to the number of deltas.
+make_history -n 2000 -l 100
+small=`cpu_time "${prs} $s"`
+make_history -n `expr 2000 \* $scale` -l 100
+big=`cpu_time "${prs} $s"`
+check_ratio S2 $small $big
+
+
+# get should take time proportional to the length of a line, even
+# a very long one.
+make_long_line () {
+    remove $s $g
+    awk "BEGIN { for (i = 0; i < $1; ++i) printf(\"0123456789\");
+                 printf(\"\\n\"); }" < /dev/null > $g ||
+	miscarry "cannot create $g"
+    ${admin} -i$g $s >/dev/null 2>&1 || miscarry "cannot create $s"
+    remove $g
+}
+make_long_line 100000
+small=`cpu_time "${get} -p $s"`
+make_long_line `expr 100000 \* $scale`
+big=`cpu_time "${get} -p $s"`
+check_ratio S3 $small $big
+
+
+# delta should read the SCCS file only a few times: to check its
+# checksum, to get the previous version, and to copy the body into
+# the new file.  The g-file is the same size as the body and is read
+# once or twice.  We count the bytes read, so this check does not
+# depend on timing.
+make_history -n 20 -l 200000
+${get} -e $s >/dev/null 2>&1 || miscarry "cannot get -e $s"
+echo "one more line" >> $g
+remove trace.log
+CSSC_TRACE=trace.log ${delta} -yscaling $s >/dev/null 2>&1 ||
+    miscarry "delta failed"
+read_bytes=`totals_field io_read`
+if test -n "$read_bytes"
+then
+    size=`wc -c < $s`
+    echo_nonl "S4..."
+    # Up to five and a half times the size of the file.
+    if echo "$read_bytes $size" | awk '{ exit ($1 * 2 <= $2 * 11) ? 0 : 1 }'
+    then
+	echo passed
+    else
+	fail "S4: delta read $read_bytes bytes for a $size byte file"
+    fi
+
+    # get reads the SCCS file twice (once for the checksum) and prs
+    # once.
+    remove trace.log
+    CSSC_TRACE=trace.log ${get} -p $s >/dev/null 2>&1 || miscarry "get failed"
+    read_bytes=`totals_field io_read`
+    echo_nonl "S5..."
+    if echo "$read_bytes $size" | awk '{ exit ($1 * 2 <= $2 * 5) ? 0 : 1 }'
+    then
+	echo passed
+    else
+	fail "S5: get read $read_bytes bytes for a $size byte file"
+    fi
+
+    remove trace.log
+    CSSC_TRACE=trace.log ${prs} $s >/dev/null 2>&1 || miscarry "prs failed"
+    read_bytes=`totals_field io_read`
+    echo_nonl "S6..."
+    if echo "$read_bytes $size" | awk '{ exit ($1 * 2 <= $2 * 3) ? 0 : 1 }'
+    then
+	echo passed
+    else
+	fail "S6: prs read $read_bytes bytes for a $size byte file"
+    fi
+else
+    echo "Skipping S4-S6 -- this system does not report the bytes read."
+fi
+
+remove $s $g $p trace.log command.log
+success
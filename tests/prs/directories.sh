@@ -0,0 +1,52 @@
+#! /bin/sh
+
+# directories.sh:  Tests for naming a directory on the command line,
+#                  including the CSSC_RECURSE_DIRECTORIES and
+#                  CSSC_DIRECTORY_ORDER environment variables.
+
+# Import common functions & definitions.
+. ../common/test-common
+
+d=dtop
+remove $d got.sorted
+unset CSSC_RECURSE_DIRECTORIES CSSC_DIRECTORY_ORDER
+
+mkdir $d $d/sub $d/sub/deeper || miscarry "cannot create directories"
+for f in $d/s.top1 $d/s.top2 $d/sub/s.sub1 $d/sub/deeper/s.deep1
+do
+    ${admin} -n $f || miscarry "cannot create $f"
+done
+mkdir $d/s.notafile || miscarry "cannot create $d/s.notafile"
+
+lists () {
+    # $1 -- label
+    # $2 -- command
+    # $3 -- expected output, after sorting
+    echo_nonl $1...
+    eval "$2" 2>/dev/null | sort > got.sorted
+    echo_nonl "$3" | cmp - got.sorted >/dev/null || fail "$1: $2 produced `cat got.sorted`"
+    echo passed
+}
+
+# Without recursion, subdirectories are ignored.
+lists D1 "${vg_prs} -d:F: $d" "s.top1\ns.top2\n"
+docommand D2 "${vg_prs} -d:F: $d" 0 IGNORE "${prs}: warning: Ignoring subdirectory $d/s.notafile\n"
+
+lists D3 "CSSC_RECURSE_DIRECTORIES=enabled ${vg_prs} -d:F: $d" \
+    "s.deep1\ns.sub1\ns.top1\ns.top2\n"
+lists D4 "CSSC_RECURSE_DIRECTORIES=disabled ${vg_prs} -d:F: $d" \
+    "s.top1\ns.top2\n"
+lists D5 "CSSC_RECURSE_DIRECTORIES=enabled CSSC_DIRECTORY_ORDER=inode ${vg_prs} -d:F: $d" \
+    "s.deep1\ns.sub1\ns.top1\ns.top2\n"
+lists D6 "CSSC_DIRECTORY_ORDER=directory ${vg_prs} -d:F: $d" \
+    "s.top1\ns.top2\n"
+
+# Invalid settings are rejected.
+docommand D7 "CSSC_RECURSE_DIRECTORIES=yes ${vg_prs} -d:F: $d" 1 "" IGNORE
+docommand D8 "CSSC_DIRECTORY_ORDER=random ${vg_prs} -d:F: $d" 1 "" IGNORE
+
+# Names read from stdin are processed as they are read.
+lists D9 "echo $d/s.top2 | ${vg_prs} -d:F: -" "s.top2\n"
+
+remove $d got.sorted
+success
@@ -0,0 +1,95 @@
+#! /bin/sh
+
+# registry.sh:  Tests for the registry of edit locks named by
+#               CSSC_EDIT_REGISTRY, and for "sact -R" and "sact -U".
+
+# Import common functions & definitions.
+. ../common/test-common
+. ../common/real-thing
+
+if $TESTING_CSSC
+then
+    true
+else
+    echo "Skipping these tests -- the edit registry is specific to CSSC."
+    exit 0
+fi
+
+reg=edits.reg
+remove $reg $reg.tmp one two three p.one p.two p.three command.log
+rm -rf sub
+
+# registered ARGS: the output of sact -R ARGS, with the directories
+# removed from the file names and just the SIDs of each edit.
+registered () {
+    ${vg_sact} -R "$@" |
+	sed -e 's|^/.*/\(s\.[a-z]*:\)$|\1|' -e 's/^\([0-9.]* [0-9.]*\) .*/\1/'
+}
+
+mkdir sub || miscarry "cannot create directory sub"
+for g in one two sub/three
+do
+    echo $g > $g || miscarry "cannot create $g"
+    ${admin} -i$g `dirname $g`/s.`basename $g` >/dev/null 2>&1 ||
+	miscarry "cannot create s.$g"
+    remove $g
+done
+
+CSSC_EDIT_REGISTRY=`pwd`/$reg
+export CSSC_EDIT_REGISTRY
+
+docommand r1 "registered" 0 "" ""
+docommand r2 "${vg_get} -e s.one" 0 IGNORE IGNORE
+docommand r3 "${vg_get} -e sub/s.three" 0 IGNORE IGNORE
+docommand r4 "registered" 0 "\ns.one:\n1.1 1.2\n\ns.three:\n1.1 1.2\n" ""
+docommand r5 "registered sub" 0 "\ns.three:\n1.1 1.2\n" ""
+docommand r6 "registered s.one s.two" 0 "\ns.one:\n1.1 1.2\n" ""
+docommand r7 "registered -uno_such_user" 0 "" ""
+
+# Finishing an edit removes it from the registry, whether by delta
+# or by unget.
+docommand r8 "${vg_delta} -ydone s.one" 0 IGNORE IGNORE
+docommand r9 "registered" 0 "\ns.three:\n1.1 1.2\n" ""
+docommand r10 "${vg_unget} -n sub/s.three" 0 IGNORE IGNORE
+docommand r11 "registered" 0 "" ""
+
+# Edits made while the registry is not in use can be added with -U.
+unset CSSC_EDIT_REGISTRY
+docommand r12 "${vg_get} -e s.two" 0 IGNORE IGNORE
+CSSC_EDIT_REGISTRY=`pwd`/$reg
+export CSSC_EDIT_REGISTRY
+docommand r13 "registered" 0 "" ""
+docommand r14 "${vg_sact} -U s.one s.two sub/s.three | sed -e 's/ .*//'" \
+    0 "\ns.two:\n1.1\n" ""
+docommand r15 "registered" 0 "\ns.two:\n1.1 1.2\n" ""
+
+# -R and -U need the registry.
+unset CSSC_EDIT_REGISTRY
+docommand r16 "${vg_sact} -R" 1 "" IGNORE
+docommand r17 "${vg_sact} -U s.two" 1 "" IGNORE
+
+docommand r18 "${vg_sact} -uno_such_user s.two" 0 "" ""
+
+# With CSSC_LOCK_TIMEOUT=0, we do not wait at all for a registry which
+# someone else has locked.
+CSSC_EDIT_REGISTRY=`pwd`/$reg
+export CSSC_EDIT_REGISTRY
+remove holdlock.out
+../../testutils/holdlock $reg 5 > holdlock.out &
+i=0
+until test -s holdlock.out
+do
+    i=`expr $i + 1`
+    test $i -le 10 || miscarry "cannot lock $reg"
+    sleep 1
+done
+docommand r19 "CSSC_LOCK_TIMEOUT=0 ${vg_sact} -U s.two" 1 IGNORE IGNORE
+docommand r20 "CSSC_LOCK_TIMEOUT=0 ${vg_sact} -U s.two 2>&1 >/dev/null | wc -l | tr -d ' '" \
+    0 "1\n" ""
+wait
+docommand r21 "registered" 0 "\ns.two:\n1.1 1.2\n" ""
+
+remove $reg $reg.tmp one two three s.one s.two p.one p.two p.three command.log
+remove holdlock.out
+rm -rf sub
+success
@@ -0,0 +1,65 @@
+#! /bin/sh
+
+# options.sh: Tests for the output formats and options of sccsdiff.
+
+# Import common functions & definitions.
+. ../common/test-common
+
+g=foo
+s=s.$g
+g2=bar
+s2=s.$g2
+remove $s $g $s2 $g2 command.log
+
+printf 'a\nb\nc\nd\ne\nf\ng\nh\ni\nj\n' > $g
+docommand prep1 "${admin} -i$g $s" 0 IGNORE IGNORE
+remove $g
+docommand prep2 "${get} -e $s" 0 IGNORE IGNORE
+printf 'a\nB\nc\nd\ne\nf\ng\nh\nj\nk\n' > $g
+docommand prep3 "${delta} -ycomment $s" 0 IGNORE IGNORE
+
+echo one > $g2
+docommand prep4 "${admin} -i$g2 $s2" 0 IGNORE IGNORE
+remove $g2
+
+header="\n------- ${g} -------\n"
+
+# The default format is that of diff(1) without options.
+docommand O1 "${vg_sccsdiff} -r1.1 -r1.2 $s" 0 \
+    "${header}2c2\n< b\n---\n> B\n9d8\n< i\n10a10\n> k\n" ""
+
+# The SID may be a separate argument, or just a release.
+docommand O2 "${vg_sccsdiff} -r 1.1 -r1 $s" 0 \
+    "${header}2c2\n< b\n---\n> B\n9d8\n< i\n10a10\n> k\n" ""
+
+# Unified output.
+docommand O3 "${vg_sccsdiff} -r1.1 -r1.2 -U1 $s" 0 \
+"${header}--- foo	1.1
++++ foo	1.2
+@@ -1,3 +1,3 @@
+ a
+-b
++B
+ c
+@@ -8,3 +8,3 @@
+ h
+-i
+ j
++k
+" ""
+
+docommand O4 "${vg_sccsdiff} -r1.1 -r1.1 $s" 0 "No differences.\n" ""
+
+# Several files.
+docommand O5 "${vg_sccsdiff} -r1.1 -r1.1 $s $s2" 0 \
+    "No differences.\nNo differences.\n" ""
+
+# Other diff options are passed to diff(1).
+docommand O6 "${vg_sccsdiff} -r1.1 -r1.2 -c $s | grep '^! B'" 0 "! B\n" ""
+
+docommand O7 "${vg_sccsdiff} -r1.1 $s" 1 "" IGNORE
+docommand O8 "${vg_sccsdiff} -r1.1 -r1.2 -r1.1 $s" 1 "" IGNORE
+docommand O9 "${vg_sccsdiff} -r1.1 -r1.2 $s2" 1 "" IGNORE
+
+remove $s $g $s2 $g2 command.log
+success
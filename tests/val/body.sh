@@ -0,0 +1,77 @@
+#! /bin/sh
+
+# body.sh:  Tests for "val -b", which also checks the body.
+
+# Import common functions & definitions.
+. ../common/test-common
+. ../common/real-thing
+
+if $TESTING_CSSC
+then
+    true
+else
+    echo "Skipping these tests -- val -b is specific to CSSC."
+    exit 0
+fi
+
+g=body
+s=s.$g
+p=p.$g
+bad=s.bad
+remove $g $s $p $bad command.log
+
+ctl=`printf '\001'`
+
+# Make a file with a few deltas, including a change and a deletion.
+printf 'one\ntwo\nthree\n' > $g || miscarry "cannot create $g"
+docommand b1 "${admin} -i$g $s" 0 IGNORE IGNORE
+remove $g
+docommand b2 "${get} -e $s" 0 IGNORE IGNORE
+printf 'one\n2\nthree\nfour\n' > $g || miscarry "cannot change $g"
+docommand b3 "${delta} -ychange $s" 0 IGNORE IGNORE
+docommand b4 "${get} -e $s" 0 IGNORE IGNORE
+printf 'one\nfour\n' > $g || miscarry "cannot change $g"
+docommand b5 "${delta} -ydelete $s" 0 IGNORE IGNORE
+
+docommand b6 "${vg_val} -b $s" 0 "" ""
+docommand b7 "${vg_val} -b -j2 $s $s $s" 0 "" ""
+
+# make_bad SED-EXPRESSION: copy $s to $bad, edit it with sed, and fix
+# the checksum.
+make_bad () {
+    remove $bad
+    sed -e "$1" < $s > $bad || miscarry "cannot create $bad"
+    ${admin} -z $bad >/dev/null 2>&1 || miscarry "cannot fix checksum of $bad"
+}
+
+# A missing ^AE.
+make_bad "/^${ctl}E 3\$/d"
+docommand b8 "${vg_val} -b $bad" 32 "" IGNORE
+
+# A serial number which is not in the delta table.
+make_bad "s/^${ctl}D 3\$/${ctl}D 9/"
+docommand b9 "${vg_val} -b $bad" 32 "" IGNORE
+
+# Text after the last ^AE.
+make_bad "\$a\\
+stray"
+docommand b10 "${vg_val} -b $bad" 32 "" IGNORE
+
+# An inserted line count which does not match the body.  val without
+# -b does not read the body, so it does not notice.
+make_bad "s:^${ctl}s 00002/00001/00002\$:${ctl}s 00003/00001/00002:"
+docommand b11 "${vg_val} $bad" 0 "" IGNORE
+docommand b12 "${vg_val} -b $bad" 32 "" IGNORE
+
+# Unchanged and deleted line counts which do not add up to the number
+# of lines in the previous version.
+make_bad "s:^${ctl}s 00000/00002/00002\$:${ctl}s 00000/00002/00003:"
+docommand b13 "${vg_val} -b $bad" 32 "" IGNORE
+
+# A bad checksum is still detected.
+remove $bad
+sed -e 's/^three$/thrEE/' < $s > $bad || miscarry "cannot create $bad"
+docommand b14 "${vg_val} -b $bad" 32 "" IGNORE
+
+remove $g $s $p $bad command.log
+success
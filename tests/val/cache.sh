@@ -0,0 +1,75 @@
+#! /bin/sh
+
+# cache.sh:  Tests for "val -c", which skips files that passed
+#            validation before and have not changed since.
+
+# Import common functions & definitions.
+. ../common/test-common
+. ../common/real-thing
+
+if $TESTING_CSSC
+then
+    true
+else
+    echo "Skipping these tests -- val -c is specific to CSSC."
+    exit 0
+fi
+
+cache=val.cache
+files="s.one s.two s.three"
+remove $files one two three bad $cache $cache.tmp command.log
+
+for g in one two three
+do
+    echo $g > $g || miscarry "cannot create $g"
+    ${admin} -i$g s.$g >/dev/null 2>&1 || miscarry "cannot create s.$g"
+    remove $g
+done
+
+# The first run checks every file, and the second none.
+docommand c1 "${vg_val} -c$cache $files" 0 \
+    "$cache: 0 unchanged, 3 checked\n" ""
+docommand c2 "${vg_val} -c$cache $files" 0 \
+    "$cache: 3 unchanged, 0 checked\n" ""
+docommand c3 "${vg_val} -j2 -c$cache $files" 0 \
+    "$cache: 3 unchanged, 0 checked\n" ""
+
+# Checking the header only does not count for -b; checking the body
+# counts for both.
+docommand c4 "${vg_val} -b -j2 -c$cache $files" 0 \
+    "$cache: 0 unchanged, 3 checked\n" ""
+docommand c5 "${vg_val} -b -c$cache $files" 0 \
+    "$cache: 3 unchanged, 0 checked\n" ""
+docommand c6 "${vg_val} -c$cache $files" 0 \
+    "$cache: 3 unchanged, 0 checked\n" ""
+
+# A modified file is checked again, and a corrupt one is checked
+# every time.
+sed -e 's/^two$/TWO/' < s.two > bad || miscarry "cannot create bad"
+remove s.two
+mv bad s.two || miscarry "cannot replace s.two"
+docommand c7 "${vg_val} -c$cache $files" 32 \
+    "$cache: 2 unchanged, 1 checked\n" IGNORE
+docommand c8 "${vg_val} -c$cache $files" 32 \
+    "$cache: 2 unchanged, 1 checked\n" IGNORE
+${admin} -z s.two >/dev/null 2>&1 || miscarry "cannot fix s.two"
+docommand c9 "${vg_val} -c$cache $files" 0 \
+    "$cache: 2 unchanged, 1 checked\n" ""
+docommand c10 "${vg_val} -c$cache $files" 0 \
+    "$cache: 3 unchanged, 0 checked\n" ""
+
+# The cache does not answer for -m, -r or -y.
+docommand c11 "${vg_val} -c$cache -mone s.one" 0 "" ""
+docommand c12 "${vg_val} -c$cache -mtwo s.one" 1 "" IGNORE
+
+# -s suppresses the report.
+docommand c13 "${vg_val} -s -c$cache $files" 0 "" ""
+
+# A file which is not a cache is left alone.
+echo "not a cache" > bad || miscarry "cannot create bad"
+docommand c14 "${vg_val} -cbad $files" 0 "" IGNORE
+docommand c15 "cat bad" 0 "not a cache\n" ""
+docommand c16 "${vg_val} -c $files" 64 "" IGNORE
+
+remove $files one two three bad $cache $cache.tmp command.log
+success
@@ -0,0 +1,227 @@
+#! /usr/bin/env python3
+#
+# cssc-bench.py: Part of GNU CSSC.
+#
+# Copyright (C) 2019 Free Software Foundation, Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Times the CSSC tools on synthetic SCCS files.
+
+Each workload is an SCCS file made by mkhistory with the given
+arguments.  For each workload we time get, prs, val, delta, rmdel and
+admin -i, several times each, and report the median elapsed and CPU
+time.  The report is tab-separated text, one line per workload and
+tool; give an earlier report with --compare to see the ratio of each
+time to the earlier one.
+
+Example:
+  cssc-bench.py --bindir=/usr/libexec/cssc --output=new.txt \\
+      --compare=old.txt
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import resource
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+# The workloads we run by default.  The "production" one takes some
+# minutes and a few hundred megabytes of disk, so it is only run when
+# asked for.
+WORKLOADS = [
+    ('small', '-n 100 -l 1000'),
+    ('many-deltas', '-n 20000 -l 5000 -b 10 -i 100'),
+    ('big-body', '-n 50 -l 500000 -k 1'),
+    ('binary', '-e -n 100 -l 100000'),
+]
+LARGE_WORKLOADS = [
+    ('production', '-n 65535 -l 2000000 -b 10 -i 200 -k 1'),
+]
+
+TOOLS = ['get', 'prs', 'val', 'delta', 'rmdel', 'admin-i']
+
+
+def run(argv, cwd, stdin=None):
+    """Runs a command, returning its elapsed and CPU time."""
+    before = resource.getrusage(resource.RUSAGE_CHILDREN)
+    start = time.time()
+    with open(os.devnull, 'w') as devnull:
+        rv = subprocess.call(argv, cwd=cwd, stdin=stdin,
+                             stdout=devnull, stderr=devnull)
+    elapsed = time.time() - start
+    after = resource.getrusage(resource.RUSAGE_CHILDREN)
+    if rv != 0:
+        raise RuntimeError('%s failed with status %d' % (' '.join(argv), rv))
+    cpu = (after.ru_utime - before.ru_utime) + (after.ru_stime - before.ru_stime)
+    return elapsed, cpu
+
+
+def quiet(argv, cwd, stdin=None):
+    """Runs a command which is part of the preparation, not timed."""
+    with open(os.devnull, 'w') as devnull:
+        rv = subprocess.call(argv, cwd=cwd, stdin=stdin,
+                             stdout=devnull, stderr=devnull)
+    if rv != 0:
+        raise RuntimeError('%s failed with status %d' % (' '.join(argv), rv))
+
+
+def top_sid(tool, sfile, cwd):
+    out = subprocess.check_output([tool('prs'), '-d:I:', '-r', sfile],
+                                  cwd=cwd, stderr=open(os.devnull, 'w'))
+    return out.decode('ascii').strip()
+
+
+def time_tool(name, tool, work, sfile):
+    """Times one run of the named tool on a fresh copy of SFILE."""
+    gname = sfile[2:]
+    copy = os.path.join(work, sfile)
+    for f in (copy, os.path.join(work, 'p.' + gname),
+              os.path.join(work, gname), os.path.join(work, 's.new')):
+        if os.path.exists(f):
+            os.chmod(f, 0o644)
+            os.remove(f)
+    shutil.copy(os.path.join(work, '..', sfile), copy)
+
+    if name == 'get':
+        return run([tool('get'), '-p', sfile], work)
+    if name == 'prs':
+        return run([tool('prs'), sfile], work)
+    if name == 'val':
+        return run([tool('val'), sfile], work)
+    if name == 'delta':
+        quiet([tool('get'), '-e', sfile], work)
+        with open(os.path.join(work, gname), 'a') as f:
+            f.write('a line added by cssc-bench\n')
+        return run([tool('delta'), '-ybenchmark', sfile], work)
+    if name == 'rmdel':
+        # We can only remove a delta that we made ourselves.
+        quiet([tool('get'), '-e', sfile], work)
+        quiet([tool('delta'), '-ybenchmark', sfile], work)
+        sid = top_sid(tool, sfile, work)
+        return run([tool('rmdel'), '-r' + sid, sfile], work)
+    if name == 'admin-i':
+        with open(os.path.join(work, gname), 'w') as f:
+            subprocess.check_call([tool('get'), '-k', '-p', sfile], cwd=work,
+                                  stdout=f, stderr=open(os.devnull, 'w'))
+        return run([tool('admin'), '-i' + gname, 's.new'], work)
+    raise ValueError(name)
+
+
+def median(values):
+    values = sorted(values)
+    return values[len(values) // 2]
+
+
+def read_report(name):
+    """Reads a report, returning a dict of (workload, tool) -> times."""
+    result = {}
+    with open(name) as f:
+        for line in f:
+            if line.startswith('#') or not line.strip():
+                continue
+            fields = line.rstrip('\n').split('\t')
+            if fields[0] == 'workload':
+                continue
+            result[(fields[0], fields[1])] = (float(fields[2]), float(fields[3]))
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser.add_argument('--bindir', required=True,
+                        help='directory containing the CSSC tools')
+    parser.add_argument('--mkhistory', default=os.path.join(here, 'mkhistory'),
+                        help='the mkhistory program')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='number of times to run each tool')
+    parser.add_argument('--large', action='store_true',
+                        help='also run the production-sized workload')
+    parser.add_argument('--workload', action='append', default=[],
+                        metavar='NAME=ARGS',
+                        help='add a workload made by "mkhistory ARGS"')
+    parser.add_argument('--only', action='append', default=[],
+                        metavar='NAME', help='run only the named workloads')
+    parser.add_argument('--tools', default=','.join(TOOLS),
+                        help='comma-separated list of tools to time')
+    parser.add_argument('--output', help='write the report to this file')
+    parser.add_argument('--compare', metavar='REPORT',
+                        help='show the ratio of each time to REPORT')
+    args = parser.parse_args()
+
+    workloads = list(WORKLOADS)
+    if args.large:
+        workloads += LARGE_WORKLOADS
+    for w in args.workload:
+        name, _, spec = w.partition('=')
+        workloads.append((name, spec))
+    if args.only:
+        workloads = [w for w in workloads if w[0] in args.only]
+    tools = args.tools.split(',')
+    for t in tools:
+        if t not in TOOLS:
+            parser.error('unknown tool %s' % t)
+
+    def tool(name):
+        return os.path.join(os.path.abspath(args.bindir), name)
+
+    previous = read_report(args.compare) if args.compare else {}
+    out = open(args.output, 'w') if args.output else sys.stdout
+    version = subprocess.check_output([tool('admin'), '-V'],
+                                      stderr=subprocess.STDOUT)
+    out.write('# %s\n' % version.decode('ascii', 'replace').splitlines()[0])
+    out.write('# %s, %d runs each\n' % (time.strftime('%Y-%m-%d %H:%M:%S'),
+                                        args.repeat))
+    out.write('workload\ttool\twall\tcpu\tbytes\tbytes/s\n')
+    out.flush()
+
+    top = tempfile.mkdtemp(prefix='cssc-bench.')
+    try:
+        work = os.path.join(top, 'work')
+        os.mkdir(work)
+        for name, spec in workloads:
+            sfile = 's.' + name
+            subprocess.check_call([args.mkhistory] + spec.split()
+                                  + [os.path.join(top, sfile)])
+            size = os.path.getsize(os.path.join(top, sfile))
+            for t in tools:
+                times = [time_tool(t, tool, work, sfile)
+                         for _ in range(args.repeat)]
+                wall = median([w for w, _ in times])
+                cpu = median([c for _, c in times])
+                line = '%s\t%s\t%.4f\t%.4f\t%d\t%.0f' % (
+                    name, t, wall, cpu, size, size / wall if wall else 0)
+                if (name, t) in previous:
+                    old_wall, old_cpu = previous[(name, t)]
+                    line += '\t%.2fx wall\t%.2fx cpu' % (
+                        wall / old_wall if old_wall else 0,
+                        cpu / old_cpu if old_cpu else 0)
+                out.write(line + '\n')
+                out.flush()
+            os.remove(os.path.join(top, sfile))
+    finally:
+        shutil.rmtree(top, ignore_errors=True)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,71 @@
+/* holdlock.c; part of GNU CSSC.
+ *
+ * Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This program is not installed as part of CSSC.  It's just used by
+ * the test suite.  "holdlock FILE SECONDS" takes a write record lock
+ * on the whole of FILE (creating it if need be), prints "locked" once
+ * it has the lock, and holds it for SECONDS seconds.
+ */
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "progname.h"
+
+int
+main(int argc, char *argv[])
+{
+  const char *prog;
+  struct flock fl;
+  int fd, seconds;
+
+  set_program_name (argv[0]);
+  prog = program_name ? program_name : "holdlock";
+  if (argc != 3 || (seconds = atoi(argv[2])) <= 0)
+    {
+      fprintf(stderr, "usage: %s file seconds\n", prog);
+      return 2;
+    }
+
+  fd = open(argv[1], O_RDWR | O_CREAT, 0666);
+  if (fd < 0)
+    {
+      fprintf(stderr, "%s: %s: %s\n", prog, argv[1], strerror(errno));
+      return 1;
+    }
+  memset(&fl, 0, sizeof(fl));
+  fl.l_type = F_WRLCK;
+  fl.l_whence = SEEK_SET;
+  fl.l_start = 0;
+  fl.l_len = 0;
+  if (fcntl(fd, F_SETLKW, &fl) != 0)
+    {
+      fprintf(stderr, "%s: cannot lock %s: %s\n",
+	      prog, argv[1], strerror(errno));
+      return 1;
+    }
+  printf("locked\n");
+  fflush(stdout);
+  sleep((unsigned int) seconds);
+  close(fd);
+  return 0;
+}
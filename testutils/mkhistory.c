@@ -0,0 +1,607 @@
+/* mkhistory.c: Part of GNU CSSC.
+ *
+ * Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* This program is not installed as part of CSSC.  It writes a
+ * synthetic SCCS file with a history of the requested shape, for the
+ * performance tests and for cssc-bench.py.
+ *
+ * The first delta (1.1) has the given number of lines.  Each later
+ * delta deletes and inserts a few lines (the numbers vary randomly
+ * around the given means) at one place in the version it was made
+ * from.  With -c, that place is usually close to where the previous
+ * delta changed the file, as it is in real histories.  A percentage
+ * of deltas (-b) go on branches; a branch starts from one of the
+ * recent trunk deltas, or continues an existing branch.  Every Nth
+ * trunk delta can include a branch delta (-i) or exclude an earlier
+ * trunk delta (-x).  With -e, the file is encoded and its lines are
+ * random binary data.
+ *
+ * The same arguments (including the seed, -s) always produce the same
+ * file.  The text of a line is computed from a line number, so that
+ * the body is never held in memory; only the structure of the weave
+ * is.  That makes it possible to create files with very large bodies.
+ */
+#include <config.h>
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "progname.h"
+
+#define CONTROL '\001'
+
+static const char *prog;
+
+struct options
+{
+  unsigned long deltas;		/* -n */
+  unsigned long lines;		/* -l: lines in delta 1.1 */
+  unsigned long added;		/* -a: mean lines inserted per delta */
+  unsigned long deleted;	/* -d: mean lines deleted per delta */
+  unsigned branch_percent;	/* -b */
+  unsigned locality_percent;	/* -c */
+  unsigned keyword_percent;	/* -k */
+  unsigned min_width, max_width; /* -w */
+  unsigned long include_every;	/* -i */
+  unsigned long exclude_every;	/* -x */
+  int encoded;			/* -e */
+  unsigned long seed;		/* -s */
+};
+
+/* A run of consecutive lines in the body which were inserted by the
+ * same delta and (if DEL is not zero) deleted by the same delta.  The
+ * lines are numbered FIRST to FIRST+COUNT-1; the text of each line is
+ * derived from its number.
+ */
+struct run
+{
+  unsigned long first;
+  unsigned long count;
+  unsigned long ins;
+  unsigned long del;
+};
+
+struct delta
+{
+  short rel, level, branch, seq;
+  unsigned long prev;
+  unsigned long trunk_point;	/* for a trunk delta, itself. */
+  unsigned long branch_id;	/* 0 for a trunk delta. */
+  unsigned long inserted, deleted, lines;
+  unsigned long include, exclude;
+  unsigned branches;		/* branches started from this delta. */
+};
+
+struct branch
+{
+  unsigned long last;		/* the newest delta on the branch. */
+};
+
+static struct run *runs;
+static size_t nruns, runs_allocated;
+static struct delta *deltas;	/* indexed by sequence number. */
+static struct branch *branches;
+static size_t nbranches;
+static unsigned long next_line_number;
+
+static FILE *out;
+static const char *out_name;
+static int checksum;
+
+static void
+usage(int retval)
+{
+  fprintf(retval ? stderr : stdout,
+	  "usage: %s [-e] [-n deltas] [-l lines] [-a added] [-d deleted]\n"
+	  "       [-b branch-percent] [-c locality-percent] [-k keyword-percent]\n"
+	  "       [-w min,max] [-i N] [-x N] [-s seed] s.file\n",
+	  prog);
+  exit(retval);
+}
+
+static void
+fatal(const char *what)
+{
+  fprintf(stderr, "%s: %s: %s\n", prog, what, strerror(errno));
+  exit(1);
+}
+
+static void *
+xrealloc(void *p, size_t n)
+{
+  p = realloc(p, n);
+  if (NULL == p)
+    fatal("out of memory");
+  return p;
+}
+
+/* A small PRNG (xorshift64*) so that the output does not depend on
+ * the C library.
+ */
+static unsigned long long rng_state;
+
+static unsigned long
+rnd(unsigned long n)
+{
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return n ? (unsigned long) ((rng_state * 2685821657736338717ULL) >> 33) % n
+    : 0;
+}
+
+static unsigned long
+hash(unsigned long n)
+{
+  unsigned long long h = (n + 1) * 0x9E3779B97F4A7C15ULL;
+  h ^= h >> 31;
+  return (unsigned long) (h * 0xBF58476D1CE4E5B9ULL >> 33);
+}
+
+/* Write to the output, keeping a running checksum. */
+static void
+emit(const char *s, size_t len)
+{
+  size_t i;
+  for (i = 0; i < len; ++i)
+    checksum += (char) s[i];
+  if (fwrite(s, 1, len, out) != len)
+    fatal(out_name);
+}
+
+static void
+emitf(const char *fmt, ...)
+{
+  char buf[1024];
+  va_list ap;
+  int n;
+  va_start(ap, fmt);
+  n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  emit(buf, (size_t) n);
+}
+
+static void
+emit_line(const struct options *opts, unsigned long n)
+{
+  char buf[256];
+  size_t len = 0;
+
+  if (opts->encoded)
+    {
+      /* 45 bytes of data, uuencoded as "encode_line" does it. */
+      unsigned char data[45];
+      size_t i;
+      for (i = 0; i < sizeof(data); ++i)
+	data[i] = (unsigned char) (hash(n * 64 + i) & 0xFF);
+      buf[len++] = (char) (' ' + sizeof(data));
+      for (i = 0; i < sizeof(data); i += 3)
+	{
+	  buf[len++] = (char) (' ' + ((data[i] >> 2) & 077));
+	  buf[len++] = (char) (' ' + (((data[i] << 4) & 060)
+				      | ((data[i+1] >> 4) & 017)));
+	  buf[len++] = (char) (' ' + (((data[i+1] << 2) & 074)
+				      | ((data[i+2] >> 6) & 003)));
+	  buf[len++] = (char) (' ' + (data[i+2] & 077));
+	}
+    }
+  else
+    {
+      const unsigned long h = hash(n);
+      const unsigned width = opts->min_width
+	+ (unsigned) (h % (opts->max_width - opts->min_width + 1));
+      len = (size_t) snprintf(buf, sizeof(buf), "%lu:", n);
+      if (opts->keyword_percent && h / 7 % 100 < opts->keyword_percent)
+	len += (size_t) snprintf(buf + len, sizeof(buf) - len,
+				 " %%M%% %%I%%");
+      for (; len < width && len < sizeof(buf) - 2; ++len)
+	buf[len] = (char) ('a' + (h + len) % 26);
+    }
+  buf[len++] = '\n';
+  emit(buf, len);
+}
+
+static void
+insert_runs(size_t where, size_t n)
+{
+  if (nruns + n > runs_allocated)
+    {
+      runs_allocated = (nruns + n) * 2;
+      runs = xrealloc(runs, runs_allocated * sizeof(*runs));
+    }
+  memmove(runs + where + n, runs + where, (nruns - where) * sizeof(*runs));
+  nruns += n;
+}
+
+/* Is delta A the same as D, or one of its ancestors? */
+static int
+is_ancestor(unsigned long a, unsigned long d)
+{
+  const struct delta *pa = &deltas[a], *pd = &deltas[d];
+  if (0 == pa->branch_id)
+    return a <= pd->trunk_point;
+  return pa->branch_id == pd->branch_id && a <= d;
+}
+
+static int
+is_visible(const struct run *r, unsigned long d)
+{
+  return is_ancestor(r->ins, d) && !(r->del && is_ancestor(r->del, d));
+}
+
+/* Make delta number SEQ from its predecessor, changing the file near
+ * run *HINT.
+ */
+static void
+make_edit(const struct options *opts, unsigned long seq, size_t *hint)
+{
+  struct delta *d = &deltas[seq];
+  const unsigned long to_delete = rnd(2 * opts->deleted + 1);
+  const unsigned long to_insert = rnd(2 * opts->added + 1);
+  size_t where, tries;
+  struct run *r;
+
+  if (rnd(100) < opts->locality_percent)
+    {
+      where = *hint + rnd(17);
+      where = (where > 8) ? where - 8 : 0;
+      if (where >= nruns)
+	where = nruns - 1;
+    }
+  else
+    {
+      where = rnd(nruns);
+    }
+
+  /* Find a run which is visible in the predecessor. */
+  for (tries = 0; tries < 1000; ++tries)
+    {
+      if (is_visible(&runs[where], d->prev))
+	break;
+      if (++where == nruns)
+	where = 0;
+    }
+
+  r = &runs[where];
+  if (is_visible(r, d->prev) && 0 == r->del && to_delete)
+    {
+      /* Delete some lines from the middle of this run. */
+      const unsigned long start = rnd(r->count);
+      unsigned long n = r->count - start;
+      if (n > to_delete)
+	n = to_delete;
+      if (start > 0)
+	{
+	  insert_runs(where, 1);
+	  runs[where].count = start;
+	  runs[where + 1].first += start;
+	  runs[where + 1].count -= start;
+	  ++where;
+	}
+      if (runs[where].count > n)
+	{
+	  insert_runs(where, 1);
+	  runs[where].count = n;
+	  runs[where + 1].first += n;
+	  runs[where + 1].count -= n;
+	}
+      runs[where].del = seq;
+      d->deleted = n;
+      ++where;
+    }
+
+  if (to_insert)
+    {
+      insert_runs(where, 1);
+      runs[where].first = next_line_number;
+      runs[where].count = to_insert;
+      runs[where].ins = seq;
+      runs[where].del = 0;
+      next_line_number += to_insert;
+      d->inserted = to_insert;
+    }
+  d->lines = deltas[d->prev].lines + d->inserted - d->deleted;
+  *hint = where;
+}
+
+static void
+make_history(const struct options *opts)
+{
+  unsigned long seq, last_trunk = 1;
+  unsigned long trunk_count = 1;
+  size_t hint = 0;
+
+  deltas = xrealloc(NULL, (opts->deltas + 1) * sizeof(*deltas));
+  memset(deltas, 0, (opts->deltas + 1) * sizeof(*deltas));
+  branches = xrealloc(NULL, (opts->deltas + 1) * sizeof(*branches));
+
+  deltas[1].rel = 1;
+  deltas[1].level = 1;
+  deltas[1].trunk_point = 1;
+  deltas[1].inserted = deltas[1].lines = opts->lines;
+  insert_runs(0, 1);
+  runs[0].first = 0;
+  runs[0].count = opts->lines;
+  runs[0].ins = 1;
+  runs[0].del = 0;
+  next_line_number = opts->lines;
+  if (0 == opts->lines)
+    nruns = 0;
+
+  for (seq = 2; seq <= opts->deltas; ++seq)
+    {
+      struct delta *d = &deltas[seq];
+      if (rnd(100) < opts->branch_percent)
+	{
+	  if (nbranches > 0 && rnd(2))
+	    {
+	      /* Continue an existing branch. */
+	      struct branch *b = &branches[rnd(nbranches)];
+	      const struct delta *p = &deltas[b->last];
+	      *d = *p;
+	      d->seq = (short) (p->seq + 1);
+	      d->prev = b->last;
+	      b->last = seq;
+	    }
+	  else
+	    {
+	      /* Start a new branch from a recent trunk delta. */
+	      unsigned long base = last_trunk;
+	      unsigned back = (unsigned) rnd(10);
+	      while (back-- && deltas[base].prev)
+		base = deltas[base].prev;
+	      d->rel = deltas[base].rel;
+	      d->level = deltas[base].level;
+	      d->branch = (short) ++deltas[base].branches;
+	      d->seq = 1;
+	      d->prev = base;
+	      d->trunk_point = base;
+	      d->branch_id = nbranches + 1;
+	      branches[nbranches++].last = seq;
+	    }
+	  d->branches = 0;
+	}
+      else
+	{
+	  const struct delta *p = &deltas[last_trunk];
+	  d->rel = p->rel;
+	  d->level = (short) (p->level + 1);
+	  if (d->level > 999)
+	    {
+	      ++d->rel;
+	      d->level = 1;
+	    }
+	  d->prev = last_trunk;
+	  d->trunk_point = seq;
+	  last_trunk = seq;
+	  ++trunk_count;
+	  if (opts->include_every && 0 == trunk_count % opts->include_every
+	      && nbranches > 0)
+	    d->include = branches[rnd(nbranches)].last;
+	  if (opts->exclude_every && 0 == trunk_count % opts->exclude_every
+	      && d->prev > 2)
+	    {
+	      unsigned long x = deltas[d->prev].prev;
+	      unsigned back = (unsigned) rnd(20);
+	      while (back-- && deltas[x].prev > 1)
+		x = deltas[x].prev;
+	      d->exclude = x;
+	    }
+	}
+      d->inserted = d->deleted = 0;
+      d->include = (d->branch_id ? 0 : d->include);
+      if (nruns > 0)
+	make_edit(opts, seq, &hint);
+      else
+	d->lines = deltas[d->prev].lines;
+    }
+}
+
+static void
+emit_sid(const struct delta *d)
+{
+  if (d->branch)
+    emitf("%d.%d.%d.%d", d->rel, d->level, d->branch, d->seq);
+  else
+    emitf("%d.%d", d->rel, d->level);
+}
+
+static unsigned long
+cap(unsigned long n)
+{
+  return n > 99999 ? 99999 : n;
+}
+
+static void
+write_sfile(const struct options *opts)
+{
+  static const char *users[] = { "alice", "bob", "carol", "dave" };
+  const time_t start = 631152000; /* 1990-01-01 */
+  unsigned long seq;
+  size_t i;
+
+  if (fputs("\001h00000\n", out) == EOF)
+    fatal(out_name);
+
+  for (seq = opts->deltas; seq >= 1; --seq)
+    {
+      const struct delta *d = &deltas[seq];
+      const time_t when = start + (time_t) seq * 600;
+      const struct tm *tm = gmtime(&when);
+      const unsigned long unchanged = deltas[d->prev].lines - d->deleted;
+
+      emitf("%cs %05lu/%05lu/%05lu\n", CONTROL,
+	    cap(d->inserted), cap(d->deleted),
+	    cap(seq > 1 ? unchanged : 0));
+      emitf("%cd D ", CONTROL);
+      emit_sid(d);
+      emitf(" %02d/%02d/%02d %02d:%02d:%02d %s %lu %lu\n",
+	    tm->tm_year % 100, tm->tm_mon + 1, tm->tm_mday,
+	    tm->tm_hour, tm->tm_min, tm->tm_sec,
+	    users[seq % 4], seq, d->prev);
+      if (d->include)
+	emitf("%ci %lu\n", CONTROL, d->include);
+      if (d->exclude)
+	emitf("%cx %lu\n", CONTROL, d->exclude);
+      emitf("%cc synthetic delta %lu\n%ce\n", CONTROL, seq, CONTROL);
+    }
+  emitf("%cu\n%cU\n", CONTROL, CONTROL);
+  if (nbranches)
+    emitf("%cf b\n", CONTROL);
+  if (opts->encoded)
+    emitf("%cf e 1\n", CONTROL);
+  emitf("%ct\n%cT\n", CONTROL, CONTROL);
+
+  /* The body.  Consecutive runs inserted by the same delta share an
+   * insert block, and within it, consecutive runs deleted by the same
+   * delta share a delete block.
+   */
+  for (i = 0; i < nruns; )
+    {
+      const unsigned long ins = runs[i].ins;
+      emitf("%cI %lu\n", CONTROL, ins);
+      while (i < nruns && runs[i].ins == ins)
+	{
+	  const unsigned long del = runs[i].del;
+	  if (del)
+	    emitf("%cD %lu\n", CONTROL, del);
+	  while (i < nruns && runs[i].ins == ins && runs[i].del == del)
+	    {
+	      unsigned long n;
+	      for (n = 0; n < runs[i].count; ++n)
+		emit_line(opts, runs[i].first + n);
+	      ++i;
+	    }
+	  if (del)
+	    emitf("%cE %lu\n", CONTROL, del);
+	}
+      emitf("%cE %lu\n", CONTROL, ins);
+    }
+  if (0 == nruns)
+    emitf("%cI 1\n%cE 1\n", CONTROL, CONTROL);
+
+  if (fflush(out) == EOF || fseek(out, 0L, SEEK_SET) != 0)
+    fatal(out_name);
+  if (fprintf(out, "%ch%05d", CONTROL, checksum & 0xFFFF) < 0
+      || fclose(out) == EOF)
+    fatal(out_name);
+}
+
+static unsigned long
+number(const char *s)
+{
+  char *end;
+  unsigned long n;
+  errno = 0;
+  n = strtoul(s, &end, 10);
+  if (errno || end == s || *end)
+    {
+      fprintf(stderr, "%s: invalid number '%s'\n", prog, s);
+      usage(2);
+    }
+  return n;
+}
+
+static unsigned
+percentage(const char *s)
+{
+  const unsigned long n = number(s);
+  if (n > 100)
+    {
+      fprintf(stderr, "%s: %s is not a percentage\n", prog, s);
+      usage(2);
+    }
+  return (unsigned) n;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct options opts;
+  int c;
+
+  set_program_name(argv[0]);
+  prog = program_name ? program_name : "mkhistory";
+
+  opts.deltas = 100;
+  opts.lines = 1000;
+  opts.added = 10;
+  opts.deleted = 5;
+  opts.branch_percent = 0;
+  opts.locality_percent = 80;
+  opts.keyword_percent = 0;
+  opts.min_width = 20;
+  opts.max_width = 80;
+  opts.include_every = 0;
+  opts.exclude_every = 0;
+  opts.encoded = 0;
+  opts.seed = 1;
+
+  while ((c = getopt(argc, argv, "a:b:c:d:ehi:k:l:n:s:w:x:")) != -1)
+    {
+      switch (c)
+	{
+	case 'a': opts.added = number(optarg); break;
+	case 'b': opts.branch_percent = percentage(optarg); break;
+	case 'c': opts.locality_percent = percentage(optarg); break;
+	case 'd': opts.deleted = number(optarg); break;
+	case 'e': opts.encoded = 1; break;
+	case 'h': usage(0); break;
+	case 'i': opts.include_every = number(optarg); break;
+	case 'k': opts.keyword_percent = percentage(optarg); break;
+	case 'l': opts.lines = number(optarg); break;
+	case 'n': opts.deltas = number(optarg); break;
+	case 's': opts.seed = number(optarg); break;
+	case 'x': opts.exclude_every = number(optarg); break;
+	case 'w':
+	  if (sscanf(optarg, "%u,%u", &opts.min_width, &opts.max_width) != 2
+	      || opts.min_width > opts.max_width || opts.max_width > 200)
+	    {
+	      fprintf(stderr, "%s: invalid line widths '%s'\n", prog, optarg);
+	      usage(2);
+	    }
+	  break;
+	default:
+	  usage(2);
+	}
+    }
+  if (optind + 1 != argc || opts.deltas < 1)
+    usage(2);
+  /* Sequence numbers are unsigned shorts in an SCCS file. */
+  if (opts.deltas > 65535)
+    {
+      fprintf(stderr, "%s: an SCCS file can have at most 65535 deltas\n",
+	      prog);
+      return 2;
+    }
+
+  rng_state = 0x2545F4914F6CDD1DULL ^ opts.seed;
+  make_history(&opts);
+
+  out_name = argv[optind];
+  out = fopen(out_name, "w");
+  if (NULL == out)
+    fatal(out_name);
+  write_sfile(&opts);
+  return 0;
+}
@@ -0,0 +1,554 @@
+/*
+ * bench_libcssc.cc: Part of GNU CSSC.
+ *
+ *
+ * Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Microbenchmarks for the parts of libcssc which the tools spend most
+ * of their time in.  All the data is synthetic, and is created in a
+ * temporary directory which is removed afterwards.
+ *
+ * Each benchmark is run in batches, each of which takes at least the
+ * minimum time (-t, in seconds).  The number of batches is set with
+ * -r.  For each benchmark we print the median and the smallest time
+ * per operation over the batches, and the throughput (for the median
+ * batch) in bytes per second.  Benchmarks can be selected by giving
+ * (part of) their names as arguments.
+ */
+#include <config.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "cssc.h"
+#include "bodyio.h"
+#include "delta.h"
+#include "delta-table.h"
+#include "except.h"
+#include "linebuf.h"
+#include "my-getopt.h"
+#include "parser.h"
+#include "sccsdate.h"
+#include "sccsfile.h"
+#include "sccsname.h"
+#include "seqstate.h"
+#include "sid.h"
+#include "subst-parms.h"
+#include "version.h"
+
+void
+usage()
+{
+  fprintf(stderr, "usage: %s [-V] [-rrepetitions] [-tseconds] [name...]\n",
+	  prg_name);
+}
+
+namespace
+{
+  // Stops the compiler from discarding work whose result we don't use.
+  volatile unsigned long sink;
+
+  const char control = '\001';
+  const unsigned body_lines = 20000;
+  const unsigned table_deltas = 2000;
+
+  // A benchmark performs the given number of operations and returns
+  // the number of bytes it processed.
+  struct benchmark
+  {
+    const char *name;
+    std::function<unsigned long(unsigned long)> run;
+  };
+
+  struct measurement
+  {
+    double ns_per_op;
+    double bytes_per_op;
+  };
+
+  double
+  seconds_since(std::chrono::steady_clock::time_point start)
+  {
+    const std::chrono::duration<double> d =
+      std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  measurement
+  run_batch(const benchmark& b, unsigned long ops)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    const unsigned long bytes = b.run(ops);
+    const double elapsed = seconds_since(start);
+    measurement m;
+    m.ns_per_op = elapsed * 1e9 / ops;
+    m.bytes_per_op = static_cast<double>(bytes) / ops;
+    return m;
+  }
+
+  void
+  measure(const benchmark& b, int repetitions, double min_seconds)
+  {
+    // Find a batch size which takes at least min_seconds, starting
+    // small because some of the operations are slow.
+    unsigned long ops = 1;
+    run_batch(b, ops);		// warm up.
+    for (;;)
+      {
+	const measurement m = run_batch(b, ops);
+	const double elapsed = m.ns_per_op * ops / 1e9;
+	if (elapsed >= min_seconds)
+	  break;
+	const double scale = (elapsed > 0.0) ? min_seconds / elapsed : 100.0;
+	ops = static_cast<unsigned long>(ops * std::min(100.0, scale * 1.2)) + 1;
+      }
+
+    std::vector<measurement> results;
+    for (int i = 0; i < repetitions; ++i)
+      results.push_back(run_batch(b, ops));
+    std::sort(results.begin(), results.end(),
+	      [](const measurement& x, const measurement& y)
+	      {
+		return x.ns_per_op < y.ns_per_op;
+	      });
+    const measurement& median = results[results.size() / 2];
+    printf("%-28s %14.1f %14.1f", b.name,
+	   median.ns_per_op, results.front().ns_per_op);
+    if (median.bytes_per_op > 0.0)
+      printf(" %14.0f", median.bytes_per_op / median.ns_per_op * 1e9);
+    printf("\n");
+    fflush(stdout);
+  }
+
+  // A line of text of between 20 and 80 characters, different for
+  // each N.
+  std::string
+  text_line(unsigned n)
+  {
+    std::string s = "line " + std::to_string(n) + ":";
+    const unsigned len = 20u + (n * 7919u) % 60u;
+    while (s.size() < len)
+      s.push_back(static_cast<char>('a' + (n + s.size()) % 26));
+    return s;
+  }
+
+  sid
+  nth_sid(unsigned n)
+  {
+    // Mostly trunk deltas, with some branches.
+    if (n % 5 == 4)
+      return sid(static_cast<short>(1 + n / 1000), static_cast<short>(n % 1000),
+		 static_cast<short>(1 + n % 3), static_cast<short>(1 + n % 7));
+    return sid(static_cast<short>(1 + n / 1000), static_cast<short>(1 + n % 1000),
+	       0, 0);
+  }
+
+  // Write an SCCS file containing one delta, whose body has LINES
+  // lines.  If KEYWORDS is set, every tenth line contains some ID
+  // keywords.  The checksum is fixed afterwards.
+  bool
+  make_sfile(const std::string& name, unsigned lines, bool keywords)
+  {
+    FILE *fp = fopen(name.c_str(), "w");
+    if (NULL == fp)
+      return false;
+    fprintf(fp, "%ch00000\n", control);
+    fprintf(fp, "%cs %05u/00000/00000\n", control, lines);
+    fprintf(fp, "%cd D 1.1 99/05/19 01:42:08 bench 1 0\n", control);
+    fprintf(fp, "%cc synthetic\n%ce\n", control, control);
+    fprintf(fp, "%cu\n%cU\n%ct\n%cT\n", control, control, control, control);
+    fprintf(fp, "%cI 1\n", control);
+    for (unsigned i = 0; i < lines; ++i)
+      {
+	if (keywords && 0 == i % 10)
+	  fprintf(fp, "/* %%M%% %%I%% %%E%% %%U%% */ %s\n", text_line(i).c_str());
+	else
+	  fprintf(fp, "%s\n", text_line(i).c_str());
+      }
+    fprintf(fp, "%cE 1\n", control);
+    if (fclose(fp) != 0)
+      return false;
+
+    sccs_name sname;
+    sname = name;
+    sccs_file file(sname, FIX_CHECKSUM);
+    return file.update_checksum();
+  }
+
+  long
+  file_size(const std::string& name)
+  {
+    FILE *fp = fopen(name.c_str(), "r");
+    if (NULL == fp)
+      return 0;
+    fseek(fp, 0L, SEEK_END);
+    const long size = ftell(fp);
+    fclose(fp);
+    return size;
+  }
+
+  std::vector<benchmark>
+  make_benchmarks(const std::string& dir)
+  {
+    std::vector<benchmark> benchmarks;
+
+    // cssc_linebuf::read_line, on a file of text.
+    benchmarks.push_back({"linebuf_read_line",
+	  [](unsigned long ops) -> unsigned long
+	  {
+	    static FILE *f = nullptr;
+	    if (nullptr == f)
+	      {
+		f = tmpfile();
+		for (unsigned i = 0; i < body_lines; ++i)
+		  fprintf(f, "%s\n", text_line(i).c_str());
+	      }
+	    rewind(f);
+	    cssc_linebuf buf;
+	    unsigned long bytes = 0;
+	    for (unsigned long i = 0; i < ops; ++i)
+	      {
+		if (!buf.read_line(f).ok())
+		  {
+		    rewind(f);
+		    --i;
+		    continue;
+		  }
+		bytes += strlen(buf.c_str());
+	      }
+	    return bytes;
+	  }});
+
+    // The checksum is computed by reading the whole file when it is
+    // opened, so opening a file with a large body measures the
+    // checksum loop.
+    const std::string big = dir + "/s.big";
+    if (!make_sfile(big, body_lines, false))
+      fatal_quit(1, "cannot create %s", big.c_str());
+    const long big_size = file_size(big);
+    benchmarks.push_back({"open_sccs_file_checksum",
+	  [big, big_size](unsigned long ops) -> unsigned long
+	  {
+	    for (unsigned long i = 0; i < ops; ++i)
+	      {
+		auto opened = sccs_file_parser::open_sccs_file(big, READ,
+							       ParserOptions());
+		if (!opened.ok())
+		  fatal_quit(1, "cannot open %s", big.c_str());
+		sink = (*opened)->computed_sum;
+	      }
+	    return ops * big_size;
+	  }});
+
+    benchmarks.push_back({"sid_parse",
+	  [](unsigned long ops) -> unsigned long
+	  {
+	    static std::vector<std::string> text;
+	    if (text.empty())
+	      for (unsigned i = 0; i < 1000; ++i)
+		text.push_back(nth_sid(i).as_string());
+	    unsigned long bytes = 0;
+	    for (unsigned long i = 0; i < ops; ++i)
+	      {
+		const std::string& s = text[i % text.size()];
+		const sid id(s.c_str());
+		sink = id.valid();
+		bytes += s.size();
+	      }
+	    return bytes;
+	  }});
+
+    benchmarks.push_back({"sid_compare",
+	  [](unsigned long ops) -> unsigned long
+	  {
+	    static std::vector<sid> sids;
+	    if (sids.empty())
+	      for (unsigned i = 0; i < 1024; ++i)
+		sids.push_back(nth_sid((i * 7919u) % 1024u));
+	    unsigned long less = 0;
+	    for (unsigned long i = 0; i < ops; ++i)
+	      {
+		const sid& a = sids[i & 1023u];
+		const sid& b = sids[(i + 1) & 1023u];
+		less += (a < b) + (a == b);
+	      }
+	    sink = less;
+	    return 0;
+	  }});
+
+    benchmarks.push_back({"sccs_date_parse",
+	  [](unsigned long ops) -> unsigned long
+	  {
+	    static std::vector<std::pair<std::string, std::string> > dates;
+	    if (dates.empty())
+	      for (unsigned i = 0; i < 1000; ++i)
+		{
+		  char d[20], t[20];
+		  snprintf(d, sizeof(d), "%02u/%02u/%02u",
+			   (70 + i) % 100, 1 + i % 12, 1 + i % 28);
+		  snprintf(t, sizeof(t), "%02u:%02u:%02u",
+			   i % 24, i % 60, (i * 7) % 60);
+		  dates.push_back(std::make_pair(d, t));
+		}
+	    unsigned long bytes = 0;
+	    for (unsigned long i = 0; i < ops; ++i)
+	      {
+		const auto& dt = dates[i % dates.size()];
+		const sccs_date when(dt.first.c_str(), dt.second.c_str());
+		sink = when.valid();
+		bytes += dt.first.size() + dt.second.size() + 1;
+	      }
+	    return bytes;
+	  }});
+
+    // One operation is a ^AI, a body line and a ^AE, in a file with
+    // table_deltas deltas, all of which are included.
+    benchmarks.push_back({"seq_state_start_end",
+	  [](unsigned long ops) -> unsigned long
+	  {
+	    seq_state state(static_cast<seq_no>(table_deltas));
+	    for (seq_no s = 1; s <= table_deltas; ++s)
+	      state.set_included(s);
+	    unsigned long included = 0;
+	    for (unsigned long i = 0; i < ops; ++i)
+	      {
+		const seq_no s = static_cast<seq_no>(1 + i % table_deltas);
+		state.start(s, 'I');
+		included += state.include_line();
+		state.end(s);
+	      }
+	    sink = included;
+	    return 0;
+	  }});
+
+    benchmarks.push_back({"seq_state_include_line",
+	  [](unsigned long ops) -> unsigned long
+	  {
+	    seq_state state(static_cast<seq_no>(table_deltas));
+	    for (seq_no s = 1; s <= table_deltas; ++s)
+	      state.set_included(s);
+	    state.start(1, 'I');
+	    unsigned long included = 0;
+	    for (unsigned long i = 0; i < ops; ++i)
+	      included += state.include_line();
+	    sink = included;
+	    return 0;
+	  }});
+
+    benchmarks.push_back({"encode_line",
+	  [](unsigned long ops) -> unsigned long
+	  {
+	    char in[45], out[80];
+	    for (size_t i = 0; i < sizeof(in); ++i)
+	      in[i] = static_cast<char>(i * 37);
+	    for (unsigned long i = 0; i < ops; ++i)
+	      {
+		in[0] = static_cast<char>(i);
+		sink = encode_line(in, out, sizeof(in));
+	      }
+	    return ops * sizeof(in);
+	  }});
+
+    benchmarks.push_back({"decode_line",
+	  [](unsigned long ops) -> unsigned long
+	  {
+	    char in[45], encoded[80], out[80];
+	    for (size_t i = 0; i < sizeof(in); ++i)
+	      in[i] = static_cast<char>(i * 37);
+	    encode_line(in, encoded, sizeof(in));
+	    unsigned long bytes = 0;
+	    for (unsigned long i = 0; i < ops; ++i)
+	      bytes += decode_line(encoded, out);
+	    return bytes;
+	  }});
+
+    // write_subst is private to sccs_file, so we measure it as the
+    // difference between a "get -p" with and without keyword
+    // expansion of the same file.  One operation is one get.
+    const std::string kw = dir + "/s.keywords";
+    if (!make_sfile(kw, body_lines, true))
+      fatal_quit(1, "cannot create %s", kw.c_str());
+    const long kw_size = file_size(kw);
+    auto get_body = [dir](const std::string& name, long size, bool keywords)
+      {
+	return [dir, name, size, keywords](unsigned long ops) -> unsigned long
+	  {
+	    FILE *out = fopen("/dev/null", "w");
+	    if (NULL == out)
+	      fatal_quit(1, "cannot open /dev/null");
+	    for (unsigned long i = 0; i < ops; ++i)
+	      {
+		sccs_name sname;
+		sname = name;
+		sccs_file file(sname, READ);
+		const delta *d = file.find_delta(sid("1.1"));
+		if (nullptr == d)
+		  fatal_quit(1, "%s: no delta 1.1", name.c_str());
+		// This is what prepare_seqstate() does for a file with a
+		// single delta.
+		seq_state state(d->seq());
+		state.set_included(d->seq());
+		struct subst_parms parms(dir + "/g", file.get_module_name(), out,
+					 cssc::optional<std::string>(), *d,
+					 0, sccs_date::now());
+		cssc::Failure got = file.do_get(dir + "/g", state, parms,
+						keywords, 0, 0, 0, false, false);
+		if (!got.ok())
+		  fatal_quit(1, "get failed on %s", name.c_str());
+	      }
+	    fclose(out);
+	    return ops * size;
+	  };
+      };
+    benchmarks.push_back({"get_no_keywords",
+	  get_body(kw, kw_size, false)});
+    benchmarks.push_back({"get_write_subst",
+	  get_body(kw, kw_size, true)});
+
+    // Lookups in a delta table with table_deltas entries.
+    benchmarks.push_back({"delta_table_find_sid",
+	  [](unsigned long ops) -> unsigned long
+	  {
+	    static cssc_delta_table table;
+	    const std::vector<std::string> none;
+	    if (table.size() == 0)
+	      for (unsigned i = 0; i < table_deltas; ++i)
+		table.add(delta('D', nth_sid(i), sccs_date("990519014208"),
+				"bench", static_cast<seq_no>(i + 1),
+				static_cast<seq_no>(i), none, none));
+	    unsigned long found = 0;
+	    for (unsigned long i = 0; i < ops; ++i)
+	      found += (NULL != table.find(nth_sid((i * 7919u) % table_deltas)));
+	    sink = found;
+	    return 0;
+	  }});
+
+    benchmarks.push_back({"delta_table_at_seq",
+	  [](unsigned long ops) -> unsigned long
+	  {
+	    static cssc_delta_table table;
+	    const std::vector<std::string> none;
+	    if (table.size() == 0)
+	      for (unsigned i = 0; i < table_deltas; ++i)
+		table.add(delta('D', nth_sid(i), sccs_date("990519014208"),
+				"bench", static_cast<seq_no>(i + 1),
+				static_cast<seq_no>(i), none, none));
+	    unsigned long found = 0;
+	    for (unsigned long i = 0; i < ops; ++i)
+	      {
+		const seq_no s = static_cast<seq_no>(1 + (i * 7919u) % table_deltas);
+		found += table.delta_at_seq(s).seq();
+	      }
+	    sink = found;
+	    return 0;
+	  }});
+
+    return benchmarks;
+  }
+
+  bool
+  selected(const char *name, int argc, char **argv, int first)
+  {
+    if (first >= argc)
+      return true;
+    for (int i = first; i < argc; ++i)
+      {
+	if (strstr(name, argv[i]))
+	  return true;
+      }
+    return false;
+  }
+}  // unnamed namespace
+
+
+int
+main(int argc, char *argv[])
+{
+  int repetitions = 5;
+  double min_seconds = 0.2;
+
+  set_prg_name(argv[0]);
+  class CSSC_Options opts(argc, argv, "Vr!t!");
+  for (int c = opts.next();
+       c != CSSC_Options::END_OF_ARGUMENTS;
+       c = opts.next())
+    {
+      switch (c)
+	{
+	default:
+	  errormsg("Unsupported option: '%c'", c);
+	  return 2;
+
+	case 'r':
+	  repetitions = atoi(opts.getarg());
+	  if (repetitions < 1)
+	    {
+	      errormsg("The number of repetitions must be positive.");
+	      return 2;
+	    }
+	  break;
+
+	case 't':
+	  min_seconds = atof(opts.getarg());
+	  break;
+
+	case 'V':
+	  version();
+	  return 0;
+	}
+    }
+
+  const char *tmpdir = getenv("TMPDIR");
+  std::string dir = std::string((tmpdir && *tmpdir) ? tmpdir : "/tmp")
+    + "/bench_libcssc.XXXXXX";
+  if (NULL == mkdtemp(&dir[0]))
+    {
+      errormsg_with_errno("cannot create a temporary directory");
+      return 1;
+    }
+
+  int rv = 0;
+  try
+    {
+      printf("%-28s %14s %14s %14s\n", "benchmark",
+	     "ns/op", "min ns/op", "bytes/s");
+      for (const auto& b : make_benchmarks(dir))
+	{
+	  if (selected(b.name, argc, argv, opts.get_index()))
+	    measure(b, repetitions, min_seconds);
+	}
+    }
+  catch (CsscExitvalException e)
+    {
+      rv = e.exitval;
+    }
+
+  for (const char *f : { "s.big", "s.keywords", "g" })
+    remove((dir + "/" + f).c_str());
+  rmdir(dir.c_str());
+  return rv;
+}
+
+/* Local variables: */
+/* mode: c++ */
+/* End: */
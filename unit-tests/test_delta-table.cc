@@ -187,6 +187,46 @@ TEST(DeltaTable, FindAny)
 }
 
 
+// find
+// find_any
+TEST(DeltaTable, FindReusedSid)
+{
+  // After "rmdel -r1.2", a new delta 1.2 can be made.
+  cssc_delta_table t;
+  const std::vector<std::string> no_comments;
+  const std::vector<std::string> no_mrs;
+
+  const delta b('D', sid("1.2"), sccs_date("990620014208"), "wiggy",
+		seq_no(3), seq_no(1), no_mrs, no_comments);
+  const delta r('R', sid("1.2"), sccs_date("990619014208"), "waldo",
+		seq_no(2), seq_no(1), no_mrs, no_comments);
+  const delta a('D', sid("1.1"), sccs_date("990519014208"), "aldo",
+		seq_no(1), seq_no(0), no_mrs, no_comments);
+  t.add(b);
+  t.add(r);
+  t.add(a);
+
+  const delta *p = t.find(sid("1.2"));
+  ASSERT_TRUE(p != NULL);
+  EXPECT_EQ(3, p->seq());
+  p = t.find_any(sid("1.2"));
+  ASSERT_TRUE(p != NULL);
+  EXPECT_EQ(3, p->seq());
+  EXPECT_TRUE(t.find(sid("1.3")) == NULL);
+  EXPECT_TRUE(t.find_any(sid("1.3")) == NULL);
+
+  // The index must survive a prepend.
+  const delta c('D', sid("1.3"), sccs_date("990621014208"), "wiggy",
+		seq_no(4), seq_no(3), no_mrs, no_comments);
+  t.prepend(c);
+  p = t.find(sid("1.3"));
+  ASSERT_TRUE(p != NULL);
+  EXPECT_EQ(4, p->seq());
+  p = t.find(sid("1.1"));
+  ASSERT_TRUE(p != NULL);
+  EXPECT_EQ(1, p->seq());
+}
+
 // highest_seqno
 // next_seqno
 // highest_release
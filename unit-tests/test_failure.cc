@@ -16,10 +16,14 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *
- * Unit tests for failure.h.
+ * Unit tests for failure.h and failure_or.h.
  *
  */
 #include "failure.h"
+#include "failure_or.h"
+
+#include <string>
+#include <type_traits>
 
 #include <gtest/gtest.h>
 
@@ -114,6 +118,33 @@ TEST(FailureTest, Update)
   ASSERT_NE(f4.code(), f3.code());
 }
 
+TEST(FailureTest, Compact)
+{
+  // The OK state is held in a single word.
+  ASSERT_EQ(sizeof(void*), sizeof(cssc::Failure));
+  const cssc::Failure ok;
+  ASSERT_TRUE(ok.ok());
+  ASSERT_TRUE(ok.detail().empty());
+}
+
+TEST(FailureTest, CopyAndMove)
+{
+  const auto f = make_failure(errorcode::LockNotHeld, "in the stable");
+  cssc::Failure copy(f);
+  ASSERT_EQ(f.code(), copy.code());
+  ASSERT_EQ(f.detail(), copy.detail());
+
+  cssc::Failure moved(std::move(copy));
+  ASSERT_EQ(f.code(), moved.code());
+  ASSERT_EQ("in the stable", moved.detail());
+
+  cssc::Failure assigned;
+  assigned = f;
+  ASSERT_EQ(f.code(), assigned.code());
+  assigned = cssc::Failure::Ok();
+  ASSERT_TRUE(assigned.ok());
+}
+
 TEST(FailureTest, Errno)
 {
   auto f = cssc::make_failure_from_errno(ENOENT, "marshmallow-castle");
@@ -150,3 +181,18 @@ TEST(FailureBuilderTest, AutoConversion)
   cssc::Failure f2 = cssc::make_failure_builder(errorcode::NotAnSccsHistoryFile)
     << "also insert a string";
 }
+
+TEST(FailureOrTest, NothrowMove)
+{
+  // Standard containers only move their elements if that cannot throw.
+  static_assert(std::is_nothrow_move_constructible<cssc::FailureOr<std::string> >::value,
+		"FailureOr<std::string> should be nothrow move constructible");
+  static_assert(std::is_nothrow_move_assignable<cssc::FailureOr<std::string> >::value,
+		"FailureOr<std::string> should be nothrow move assignable");
+
+  cssc::FailureOr<std::string> a(std::string("lemon"));
+  cssc::FailureOr<std::string> b(make_failure(errorcode::LockNotHeld, "tart"));
+  b = std::move(a);
+  ASSERT_TRUE(b.ok());
+  ASSERT_EQ("lemon", *b);
+}
@@ -0,0 +1,187 @@
+/*
+ * test_line-diff.cc: Part of GNU CSSC.
+ *
+ *  Copyright (C) 2019 Free Software Foundation, Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Unit tests for line-diff.cc.
+ *
+ */
+#include <config.h>
+#include "line-diff.h"
+
+#include <stdio.h>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace
+{
+  line_list MakeLines(const std::string& text)
+  {
+    line_list result;
+    FILE *fp = tmpfile();
+    fwrite(text.data(), 1, text.size(), fp);
+    rewind(fp);
+    EXPECT_TRUE(result.read_file(fp).ok());
+    fclose(fp);
+    return result;
+  }
+
+  std::string Line(const line_list& lines, size_t i)
+  {
+    return std::string(lines.line(i), lines.length(i));
+  }
+}
+
+TEST(LineListTest, ReadFile) {
+  line_list lines = MakeLines(std::string("one\ntw\0o\n\nthree", 15));
+  ASSERT_EQ(4u, lines.size());
+  EXPECT_EQ("one\n", Line(lines, 0));
+  EXPECT_EQ(std::string("tw\0o\n", 5), Line(lines, 1));
+  EXPECT_EQ("\n", Line(lines, 2));
+  EXPECT_EQ("three\n", Line(lines, 3));
+  EXPECT_TRUE(lines.missing_final_newline());
+}
+
+TEST(LineListTest, IdKeywords) {
+  EXPECT_FALSE(MakeLines("one\ntwo\n").has_id_keywords());
+  EXPECT_FALSE(MakeLines("%M\n%\n%Q\n").has_id_keywords());
+  EXPECT_FALSE(MakeLines("100%x% off\n").has_id_keywords());
+  EXPECT_TRUE(MakeLines("one\n%M%\n").has_id_keywords());
+  EXPECT_TRUE(MakeLines("one\nlast %I%").has_id_keywords());
+  EXPECT_TRUE(MakeLines(std::string("\0%W%\n", 5)).has_id_keywords());
+}
+
+TEST(LineListTest, Append) {
+  line_list lines;
+  EXPECT_EQ(0u, lines.size());
+  lines.append("abc", 3);
+  lines.append("", 0);
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_EQ("abc\n", Line(lines, 0));
+  EXPECT_EQ("\n", Line(lines, 1));
+  EXPECT_FALSE(lines.missing_final_newline());
+}
+
+TEST(LineDiffTest, Identical) {
+  line_list a = MakeLines("a\nb\nc\n");
+  line_list b = MakeLines("a\nb\nc\n");
+  EXPECT_TRUE(diff_lines(a, b).empty());
+}
+
+TEST(LineDiffTest, BothEmpty) {
+  line_list a, b;
+  EXPECT_TRUE(diff_lines(a, b).empty());
+}
+
+TEST(LineDiffTest, Change) {
+  line_list a = MakeLines("a\nb\nc\n");
+  line_list b = MakeLines("a\nB\nc\nd\n");
+  std::vector<diff_hunk> hunks = diff_lines(a, b);
+  ASSERT_EQ(2u, hunks.size());
+  EXPECT_EQ(1u, hunks[0].old_start);
+  EXPECT_EQ(1u, hunks[0].old_count);
+  EXPECT_EQ(1u, hunks[0].new_start);
+  EXPECT_EQ(1u, hunks[0].new_count);
+  EXPECT_EQ(3u, hunks[1].old_start);
+  EXPECT_EQ(0u, hunks[1].old_count);
+  EXPECT_EQ(3u, hunks[1].new_start);
+  EXPECT_EQ(1u, hunks[1].new_count);
+}
+
+TEST(LineDiffTest, Delete) {
+  line_list a = MakeLines("a\nb\nc\nd\n");
+  line_list b = MakeLines("a\nd\n");
+  std::vector<diff_hunk> hunks = diff_lines(a, b);
+  ASSERT_EQ(1u, hunks.size());
+  EXPECT_EQ(1u, hunks[0].old_start);
+  EXPECT_EQ(2u, hunks[0].old_count);
+  EXPECT_EQ(1u, hunks[0].new_start);
+  EXPECT_EQ(0u, hunks[0].new_count);
+}
+
+TEST(LineDiffTest, Minimal) {
+  // The longest common subsequence, such as "b a b a", has four
+  // lines, so three lines are deleted and two inserted.
+  line_list a = MakeLines("a\nb\nc\na\nb\nb\na\n");
+  line_list b = MakeLines("c\nb\na\nb\na\nc\n");
+  size_t deleted = 0, inserted = 0;
+  for (const diff_hunk& h : diff_lines(a, b))
+    {
+      deleted += h.old_count;
+      inserted += h.new_count;
+    }
+  EXPECT_EQ(3u, deleted);
+  EXPECT_EQ(2u, inserted);
+}
+
+TEST(LineDiffTest, MissingNewlineDiffers) {
+  line_list a = MakeLines("a\nb\n");
+  line_list b = MakeLines("a\nb");
+  std::vector<diff_hunk> hunks = diff_lines(a, b);
+  ASSERT_EQ(1u, hunks.size());
+  EXPECT_EQ(1u, hunks[0].old_start);
+  EXPECT_EQ(1u, hunks[0].old_count);
+  EXPECT_EQ(1u, hunks[0].new_count);
+}
+
+namespace
+{
+  std::string Captured(FILE *fp)
+  {
+    std::string result;
+    rewind(fp);
+    int ch;
+    while ((ch = getc(fp)) != EOF)
+      result.push_back(static_cast<char>(ch));
+    fclose(fp);
+    return result;
+  }
+}
+
+TEST(DiffOutputTest, Normal) {
+  line_list a = MakeLines("a\nb\nc\nd\n");
+  line_list b = MakeLines("x\na\nc\nD\n");
+  FILE *fp = tmpfile();
+  ASSERT_TRUE(write_normal_diff(fp, a, b, diff_lines(a, b)).ok());
+  EXPECT_EQ("0a1\n> x\n2d2\n< b\n4c4\n< d\n---\n> D\n", Captured(fp));
+}
+
+TEST(DiffOutputTest, NormalMissingNewline) {
+  line_list a = MakeLines("a\n");
+  line_list b = MakeLines("a");
+  FILE *fp = tmpfile();
+  ASSERT_TRUE(write_normal_diff(fp, a, b, diff_lines(a, b)).ok());
+  EXPECT_EQ("1c1\n< a\n---\n> a\n\\ No newline at end of file\n",
+	    Captured(fp));
+}
+
+TEST(DiffOutputTest, Unified) {
+  line_list a = MakeLines("1\n2\n3\n4\n5\n6\n7\n8\n");
+  line_list b = MakeLines("1\n2\n3\n4\n5\n6\n7\n");
+  FILE *fp = tmpfile();
+  ASSERT_TRUE(write_unified_diff(fp, "old", "new", a, b,
+				 diff_lines(a, b), 2).ok());
+  EXPECT_EQ("--- old\n+++ new\n@@ -6,3 +6,2 @@\n 6\n 7\n-8\n", Captured(fp));
+}
+
+TEST(DiffOutputTest, UnifiedEmpty) {
+  line_list a = MakeLines("");
+  line_list b = MakeLines("a\n");
+  FILE *fp = tmpfile();
+  ASSERT_TRUE(write_unified_diff(fp, "old", "new", a, b,
+				 diff_lines(a, b), 3).ok());
+  EXPECT_EQ("--- old\n+++ new\n@@ -0,0 +1 @@\n+a\n", Captured(fp));
+}
@@ -23,6 +23,8 @@
 #include "linebuf.h"
 
 #include <stdio.h>
+#include <string.h>
+#include <string>
 #include <gtest/gtest.h>
 
 #include "failure.h"
@@ -159,6 +161,66 @@ TEST_F(LineBufTest, Write) {
   fclose (fp);
 }
 
+TEST_F(LineBufTest, Length) {
+  EXPECT_EQ(17u, three_colon.length());
+  EXPECT_EQ(14u, two_slash_with_null.length());
+  EXPECT_EQ('\n', two_slash_with_null[13]);
+  two_slash_with_null.truncate(13u);
+  EXPECT_EQ(13u, two_slash_with_null.length());
+  EXPECT_EQ('\0', two_slash_with_null[13]);
+}
+
+TEST_F(LineBufTest, NulInLongLine) {
+  // A line longer than the initial buffer, with NULs in each chunk.
+  std::string data(5000, 'x');
+  for (size_t i = 0; i < data.size(); i += 700)
+    data[i] = '\0';
+  data += "\nnext\n";
+  FILE *fp = MakeFile(data.data(), data.size());
+  cssc_linebuf b;
+  ASSERT_TRUE(b.read_line(fp).ok());
+  ASSERT_EQ(5001u, b.length());
+  EXPECT_EQ(0, memcmp(b.c_str(), data.data(), 5001u));
+  ASSERT_TRUE(b.read_line(fp).ok());
+  EXPECT_EQ(5u, b.length());
+  EXPECT_EQ(0, strcmp(b.c_str(), "next\n"));
+  ASSERT_FALSE(b.read_line(fp).ok());
+  fclose (fp);
+}
+
+TEST_F(LineBufTest, VeryLongLine) {
+  const size_t len = 4u * 1024u * 1024u;
+  std::string data(len, 'y');
+  data[len - 1u] = '\n';
+  data.append("last\0line", 9u);
+  FILE *fp = MakeFile(data.data(), data.size());
+  {
+    cssc_linebuf b;
+    ASSERT_TRUE(b.read_line(fp).ok());
+    ASSERT_EQ(len, b.length());
+    EXPECT_EQ(0, memcmp(b.c_str(), data.data(), len));
+    // The last line has no newline, and contains a NUL.
+    ASSERT_TRUE(b.read_line(fp).ok());
+    ASSERT_EQ(9u, b.length());
+    EXPECT_EQ(0, memcmp(b.c_str(), "last\0line", 9u));
+    ASSERT_FALSE(b.read_line(fp).ok());
+  }
+  // A new buffer (which may reuse the storage of the old one) starts
+  // out working normally.
+  rewind(fp);
+  cssc_linebuf again;
+  ASSERT_TRUE(again.read_line(fp).ok());
+  EXPECT_EQ(len, again.length());
+  fclose (fp);
+}
+
+TEST_F(LineBufTest, WriteWithNul) {
+  FILE *fp = tmpfile();
+  ASSERT_TRUE(two_slash_with_null.write(fp).ok());
+  EXPECT_EQ(14, ftell(fp));
+  fclose (fp);
+}
+
 TEST_F(LineBufTest, ReadLineSequence) {
   FILE *fp = tmpfile();
   fprintf (fp, "one\ntwo\nthree\n");
@@ -156,6 +156,54 @@ TEST(SccsdateTest, Equality)
   EXPECT_TRUE(sccs_date(datestr) <= sccs_date(datestr));
 }
 
+TEST(SccsdateTest, FieldOrder)
+{
+  // Later fields only matter when the earlier ones are equal.
+  EXPECT_TRUE(sccs_date("98/01/31 23:59:59") < sccs_date("98/02/01 00:00:00"));
+  EXPECT_TRUE(sccs_date("98/12/31 23:59:59") < sccs_date("99/01/01 00:00:00"));
+  EXPECT_TRUE(sccs_date("99/12/31 23:59:59") < sccs_date("00/01/01 00:00:00"));
+  EXPECT_TRUE(sccs_date("98/01/01 09:59:59") < sccs_date("98/01/01 10:00:00"));
+}
+
+TEST(SccsdateTest, SameAsSlowPath)
+{
+  // A four-digit year takes the slow path through the parser; the
+  // result must compare equal to the same date parsed quickly.
+  // This test generates a warning on stderr.  That's OK.
+  const sccs_date fast("07/05/19", "01:42:08");
+  const sccs_date slow("2007/05/19", "01:42:08");
+  EXPECT_TRUE(fast <= slow);
+  EXPECT_TRUE(slow <= fast);
+}
+
+TEST(SccsdateTest, BadDeltaDates)
+{
+  EXPECT_FALSE(sccs_date("99/13/19", "01:42:08").valid());
+  EXPECT_FALSE(sccs_date("99/02/30", "01:42:08").valid());
+  EXPECT_FALSE(sccs_date("99/05/19", "24:42:08").valid());
+  EXPECT_FALSE(sccs_date("99/5/19", "01:42:08").valid());
+  EXPECT_FALSE(sccs_date("99/05/19", "01:42:08x").valid());
+}
+
+TEST(SccsdateTest, Printf)
+{
+  const sccs_date d("99/05/19", "01:42:08");
+  FILE *f = tmpfile();
+  ASSERT_TRUE(f != nullptr);
+  for (const char *fmt = "DHTyodhms"; *fmt; ++fmt)
+    {
+      ASSERT_TRUE(d.printf(f, *fmt).ok());
+      fputc(' ', f);
+    }
+  ASSERT_TRUE(d.print(f).ok());
+  rewind(f);
+  char buf[100];
+  ASSERT_TRUE(fgets(buf, sizeof(buf), f) != nullptr);
+  fclose(f);
+  EXPECT_STREQ("99/05/19 05/19/99 01:42:08 99 05 19 01 42 08 "
+	       "99/05/19 01:42:08", buf);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   set_prg_name("test_sccsdate");
@@ -368,3 +368,41 @@ TEST(SidTest, TrunkMatch)
   // Different branches can still be trunk matches.
   ASSERT_TRUE(sid("1.2.7.8").trunk_match("1.2.3.4"));
 }
+
+TEST(SidTest, IncrementDecrement)
+{
+  sid a("1.2");
+  ++a;
+  EXPECT_EQ(sid("1.3"), a);
+  a = sid("1.2.3.4");
+  ++a;
+  EXPECT_EQ(sid("1.2.3.5"), a);
+  --a;
+  --a;
+  EXPECT_EQ(sid("1.2.3.3"), a);
+  a = sid("4");
+  ++a;
+  EXPECT_EQ(sid("5"), a);
+  a.next_level();
+  EXPECT_EQ(sid("5.1"), a);
+  a.next_branch();
+  EXPECT_EQ(sid("5.1.1.1"), a);
+}
+
+TEST(SidTest, Hash)
+{
+  const std::hash<sid> h;
+  EXPECT_EQ(h(sid("1.2.3.4")), h(sid("1.2.3.4")));
+  EXPECT_NE(h(sid("1.2.3.4")), h(sid("1.2.4.3")));
+  EXPECT_NE(h(sid("1.2")), h(sid("2.1")));
+}
+
+TEST(SidTest, AsString)
+{
+  EXPECT_EQ("1.2.3.4", sid("1.2.3.4").as_string());
+  EXPECT_EQ("12.345", sid("12.345").as_string());
+  EXPECT_EQ("9999", sid("9999").as_string());
+  std::ostringstream os;
+  os << sid("3.4.5.6");
+  EXPECT_EQ("3.4.5.6", os.str());
+}